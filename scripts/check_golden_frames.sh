@@ -0,0 +1,32 @@
+#!/bin/sh
+# Golden frame check, for CI. Renders the golden screens (playing, pause and game over at every size, see
+# tetris --dump-frames) with the renderer as of the pinned BASELINE commit, then compares the current tree's renderer
+# against them pixel for pixel with tetris --check-frames, which exits non-zero on any difference.
+#
+# The reference frames are rendered here rather than committed: the HUD text comes from SDL_ttf, whose rasterization
+# differs between versions and platforms, so references from one machine fail on another. Both builds below use the
+# same SDL_ttf, so only a change to the game's own rendering shows up.
+#
+# Needs git, cmake, a C++ compiler and the SDL2 and SDL2_ttf development packages; no display. From anywhere:
+#   scripts/check_golden_frames.sh [work directory]
+# A change that is meant to alter the game screen is followed by one that moves BASELINE to it.
+
+set -e
+
+# the last change to the game screen: the HUD digits composed from glyph sprites, a pixel apart from TTF's spacing
+BASELINE=c938e266dabe053884f0d33636c696e78582a5db
+root=$(cd "$(dirname "$0")/.." && pwd)
+work=${1:-"$root/_golden_build"}
+
+rm -rf "$work"
+mkdir -p "$work/baseline" "$work/frames"
+git -C "$root" archive "$BASELINE" | tar -x -C "$work/baseline"
+
+cmake -S "$work/baseline" -B "$work/baseline_build" -DCMAKE_BUILD_TYPE=Release
+cmake --build "$work/baseline_build" --target tetris
+cmake -S "$root" -B "$work/build" -DCMAKE_BUILD_TYPE=Release
+cmake --build "$work/build" --target tetris
+
+# res/ is copied next to each binary, and the fonts are loaded relative to the working directory
+(cd "$work/baseline_build" && ./tetris --dump-frames "$work/frames")
+(cd "$work/build" && ./tetris --check-frames "$work/frames")
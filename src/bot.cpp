@@ -0,0 +1,551 @@
+// Autoplay. For the falling shape the bot takes every final placement the move generator can reach (rotations, plus
+// mirroring while mirror power ups last, including slides under overhangs), scores the board each one leaves under
+// BotWeights with the batch evaluator (or with g_board_network, when one is loaded) and keeps the best.
+// evaluate_placement does the same for one placement by running it through the real rules on a copy of the game, and is
+// what the batch evaluator gets checked against.
+
+struct Placement
+{
+    int rotations;
+    bool mirrored;
+    int x, y;
+    int lock_index; // into the MoveGeneration the placement came from
+    float score;
+};
+
+struct BotStats
+{
+    u64 games;
+    u64 shapes_placed;
+    u64 placements_evaluated;
+    u64 total_score;
+    int best_score;
+    u64 nanoseconds;
+};
+
+CellMap get_placement_cell_map(CellMap base, int rotations, bool mirrored)
+{
+    auto result = base;
+    if (mirrored) { mirror(&result); }
+    for (auto i = 0; i < rotations; i++) { rotate(&result); }
+    return result;
+}
+
+int enumerate_placements(GameState* state, MoveGeneration* generation, Placement* placements)
+{
+    generate_moves(state, generation);
+    for (auto i = 0; i < generation->lock_count; i++)
+    {
+        auto lock = generation->locks[i];
+        auto placement = &placements[i];
+        placement->rotations = lock.orientation & 3;
+        placement->mirrored = lock.orientation >= 4;
+        placement->x = lock.x;
+        placement->y = lock.y;
+        placement->lock_index = i;
+        placement->score = 0;
+    }
+    return generation->lock_count;
+}
+
+// places the shape directly and runs the same lock logic as gravity does when the shape lands
+void apply_placement(Placement placement, GameState* state)
+{
+    state->falling_shape.cell_map = get_placement_cell_map(state->falling_shape.cell_map, placement.rotations, placement.mirrored);
+    state->falling_shape.x = placement.x;
+    state->falling_shape.y = placement.y;
+    if (placement.mirrored) { state->power_ups.mirror--; }
+    lock_falling_shape(state);
+}
+
+float evaluate_placement(Placement placement, GameState* state, BotWeights weights)
+{
+    auto simulated = *state;
+    simulated.is_interactive = false;
+    apply_placement(placement, &simulated);
+    if (simulated.mode == GameModeLost) { return LOST_GAME_SCORE; }
+    auto features = get_board_features(simulated.board);
+    features.cleared_rows = simulated.score - state->score;
+    return score_board_features(features, weights);
+}
+
+void fill_placement_batch(PackedBoard* board, MoveGeneration* generation, Placement* placements, int count, BoardBatch* batch)
+{
+    clear_board_batch(batch);
+    for (auto i = 0; i < count; i++)
+    {
+        auto lock = generation->locks[placements[i].lock_index];
+        auto shape = &generation->orientations[lock.orientation];
+        add_board_to_batch(board, shape->rows, shape->cell_map.height, lock.x, lock.y, batch);
+    }
+}
+
+// fills in the score of every placement from enumerate_placements, BOARD_BATCH_SIZE at a time
+void score_placements(BoardBatchEvaluator evaluator, GameState* state, MoveGeneration* generation, Placement* placements, int count, BotWeights weights, int cleared_rows_offset)
+{
+    auto board = pack_board(state->board);
+    BoardBatch batch;
+    float scores[BOARD_BATCH_SIZE];
+    for (auto first = 0; first < count; first += BOARD_BATCH_SIZE)
+    {
+        auto batch_count = MIN(count - first, BOARD_BATCH_SIZE);
+        fill_placement_batch(&board, generation, placements + first, batch_count, &batch);
+        evaluate_board_batch(evaluator, &batch, weights, cleared_rows_offset, scores);
+        for (auto i = 0; i < batch_count; i++) { placements[first + i].score = scores[i]; }
+    }
+}
+
+// the same as score_placements with the network scoring the boards; only weights.cleared_rows is used
+void score_placements_with_network(BoardNetworkEvaluator evaluator, BoardNetwork* network, GameState* state, MoveGeneration* generation, Placement* placements, int count, BotWeights weights, int cleared_rows_offset)
+{
+    auto board = pack_board(state->board);
+    BoardBatch batch;
+    BoardNetworkInputs inputs;
+    bool mirrored[BOARD_BATCH_SIZE];
+    float scores[BOARD_BATCH_SIZE];
+    for (auto first = 0; first < count; first += BOARD_BATCH_SIZE)
+    {
+        auto batch_count = MIN(count - first, BOARD_BATCH_SIZE);
+        fill_placement_batch(&board, generation, placements + first, batch_count, &batch);
+        for (auto i = 0; i < batch_count; i++) { mirrored[i] = placements[first + i].mirrored; }
+        get_board_network_inputs(&batch, state, mirrored, &inputs);
+        evaluate_board_network_batch(evaluator, network, &inputs, batch_count, weights, cleared_rows_offset, scores);
+        for (auto i = 0; i < batch_count; i++) { placements[first + i].score = scores[i]; }
+    }
+}
+
+// how the bot and the search score placements: with g_board_network if one is loaded, otherwise with weights
+void score_bot_placements(GameState* state, MoveGeneration* generation, Placement* placements, int count, BotWeights weights, int cleared_rows_offset)
+{
+    if (g_board_network != NULL) { score_placements_with_network(g_board_network_evaluator, g_board_network, state, generation, placements, count, weights, cleared_rows_offset); }
+    else { score_placements(g_board_batch_evaluator, state, generation, placements, count, weights, cleared_rows_offset); }
+}
+
+// returns false if the shape has nowhere to go
+bool find_best_placement(GameState* state, BotWeights weights, MoveGeneration* generation, Placement* result, BotStats* stats)
+{
+    Placement placements[MAX_LOCK_POSITIONS];
+    auto count = enumerate_placements(state, generation, placements);
+    if (count == 0) { return false; }
+    score_bot_placements(state, generation, placements, count, weights, 0);
+    auto best = 0;
+    for (auto i = 1; i < count; i++)
+    {
+        if (placements[i].score > placements[best].score) { best = i; }
+    }
+    stats->placements_evaluated += count;
+    *result = placements[best];
+    return true;
+}
+
+// headless game played by placing shapes directly, without going through input and gravity timers; every placement
+// goes to exporter unless it's NULL
+void play_bot_game(s32 seed, BotWeights weights, int max_shapes, TrainingExporter* exporter, BotStats* stats)
+{
+    auto start = get_monotonic_nanoseconds();
+    GameState state;
+    initialize_game_state(seed, &state);
+    auto shapes = 0;
+    while (state.mode == GameModePlaying && shapes < max_shapes)
+    {
+        Placement placement;
+        MoveGeneration generation;
+        if (!find_best_placement(&state, weights, &generation, &placement, stats))
+        {
+            state.mode = GameModeLost;
+            break;
+        }
+        if (exporter != NULL)
+        {
+            auto before = state;
+            apply_placement(placement, &state);
+            export_transition(exporter, &before, &state);
+        }
+        else { apply_placement(placement, &state); }
+        shapes++;
+    }
+    stats->games++;
+    stats->shapes_placed += shapes;
+    stats->total_score += state.score;
+    stats->best_score = MAX(stats->best_score, state.score);
+    stats->nanoseconds += get_monotonic_nanoseconds() - start;
+}
+
+float get_nodes_per_second(u64 nodes, u64 nanoseconds)
+{
+    if (nanoseconds == 0) { return 0; }
+    return (float)nodes / ((float)nanoseconds / 1e9f);
+}
+
+float get_placements_per_second(BotStats stats) { return get_nodes_per_second(stats.placements_evaluated, stats.nanoseconds); }
+
+// drives the windowed game through GameInput, one action per frame, so it plays by the same rules as a person
+struct Bot
+{
+    bool enabled;
+    BotWeights weights;
+    BotStats stats;
+    u32 planned_shape;
+    bool has_target;
+    Placement target;
+    MoveGeneration generation;
+    MoveAction actions[MAX_MOVE_SEQUENCE];
+    int action_count;
+    int next_action;
+    int expected_y;
+};
+
+Bot g_bot;
+
+GameInput get_bot_input(Bot* bot, GameState* state)
+{
+    GameInput input;
+    set_memory(0, sizeof(input), &input);
+    if (state->mode == GameModeLost)
+    {
+        input.enter = true;
+        return input;
+    }
+    if (state->mode != GameModePlaying) { return input; }
+
+    if (bot->planned_shape != state->shapes_spawned)
+    {
+        bot->planned_shape = state->shapes_spawned;
+        auto start = get_monotonic_nanoseconds();
+        bot->has_target = find_best_placement(state, bot->weights, &bot->generation, &bot->target, &bot->stats);
+        bot->stats.nanoseconds += get_monotonic_nanoseconds() - start;
+        bot->action_count = 0;
+        if (bot->has_target)
+        {
+            auto lock = bot->generation.locks[bot->target.lock_index];
+            bot->action_count = get_move_sequence(&bot->generation, lock, bot->actions, countof(bot->actions));
+            bot->stats.shapes_placed++;
+        }
+        bot->next_action = 0;
+        bot->expected_y = state->falling_shape.y;
+    }
+
+    // rows of gravity that already happened
+    while (bot->next_action < bot->action_count && bot->actions[bot->next_action] == MoveActionDown
+        && state->falling_shape.y > bot->expected_y)
+    {
+        bot->expected_y++;
+        bot->next_action++;
+    }
+
+    // nothing left but falling (or the plan got out of step with gravity): speed the shape down
+    auto only_falling_left = true;
+    for (auto i = bot->next_action; i < bot->action_count; i++) { only_falling_left &= bot->actions[i] == MoveActionDown; }
+    if (only_falling_left || state->falling_shape.y > bot->expected_y)
+    {
+        input.down = true;
+        return input;
+    }
+
+    switch (bot->actions[bot->next_action])
+    {
+        case MoveActionLeft: input.left = true; break;
+        case MoveActionRight: input.right = true; break;
+        case MoveActionRotate: input.r = true; break;
+        case MoveActionMirror: input.one = true; break;
+        // wait for gravity
+        case MoveActionDown: return input;
+        case MoveActionSpawn: break;
+    }
+    bot->next_action++;
+    return input;
+}
+
+void toggle_bot(Bot* bot)
+{
+    bot->enabled = !bot->enabled;
+    if (bot->enabled)
+    {
+        bot->weights = DEFAULT_BOT_WEIGHTS;
+        bot->planned_shape = 0;
+        log_info("Bot enabled");
+    }
+    else
+    {
+        log_info("Bot disabled, shapes placed: ", bot->stats.shapes_placed);
+        log_info("Bot placements evaluated per second: ", get_placements_per_second(bot->stats));
+    }
+}
+
+// turbo autoplay for the windowed game: the bot plays many TURBO_TICK_MS ticks per displayed frame and only the state
+// after the last one gets drawn, so long games (board color cycles, power ups piling up) play out in minutes
+#define TURBO_TICK_MS 16 // a frame at the normal 60 frames/sec, so the game plays by the same timing
+#define TURBO_FRAME_BUDGET_MS 12 // ticks stop early past this, so the window keeps its frame rate
+
+int TURBO_TICKS_PER_FRAME[] = { 1, 10, 100, 1000, 10000 }; // by turbo level; level 0 is off
+
+struct Turbo
+{
+    int level;
+    float ticks_per_second; // over the last frame
+    float speed; // simulated time per real time over the last frame
+};
+
+Turbo g_turbo;
+
+// the next turbo level, back to off after the fastest; turbo turns the bot on
+void cycle_turbo(Turbo* turbo, Bot* bot)
+{
+    turbo->level = (turbo->level + 1) % countof(TURBO_TICKS_PER_FRAME);
+    if (turbo->level != 0 && !bot->enabled) { toggle_bot(bot); }
+    log_info("Turbo ticks per frame: ", turbo->level == 0 ? 0 : TURBO_TICKS_PER_FRAME[turbo->level]);
+}
+
+struct BotGameBatch
+{
+    s32 seed;
+    int max_shapes;
+    TrainingExporter* exporter;
+    BotStats* stats; // one per game
+};
+
+void play_bot_game_batch(void* data, int begin, int end)
+{
+    auto batch = (BotGameBatch*)data;
+    for (auto i = begin; i < end; i++) { play_bot_game(batch->seed + i, DEFAULT_BOT_WEIGHTS, batch->max_shapes, batch->exporter, &batch->stats[i]); }
+}
+
+// games run in parallel on the job system; placements per second is for the whole batch, across all workers
+int run_bot_games(int games, int max_shapes, s32 seed, TrainingExporter* exporter)
+{
+    initialize_shape_cell_maps();
+    BotGameBatch batch;
+    batch.seed = seed;
+    batch.max_shapes = max_shapes;
+    batch.exporter = exporter;
+    batch.stats = (BotStats*)SDL_calloc(games, sizeof(BotStats));
+    if (batch.stats == NULL) { panic("Out of memory for bot stats"); }
+    reset_job_stats();
+    auto start = get_monotonic_nanoseconds();
+    parallel_for(play_bot_game_batch, &batch, games, 1);
+
+    BotStats total;
+    set_memory(0, sizeof(total), &total);
+    for (auto i = 0; i < games; i++)
+    {
+        auto game = batch.stats[i];
+        print("game ");
+        print((s64)i);
+        print(": score ");
+        print((s64)game.total_score);
+        print(", shapes ");
+        print(game.shapes_placed);
+        print("\n");
+
+        total.games += game.games;
+        total.shapes_placed += game.shapes_placed;
+        total.placements_evaluated += game.placements_evaluated;
+        total.total_score += game.total_score;
+        total.best_score = MAX(total.best_score, game.best_score);
+    }
+    total.nanoseconds = get_monotonic_nanoseconds() - start;
+    print("average score: ");
+    print((float)total.total_score / (float)MAX(1, total.games));
+    print(", best score: ");
+    print((s64)total.best_score);
+    print("\nplacements evaluated: ");
+    print(total.placements_evaluated);
+    print(" (");
+    print(get_placements_per_second(total));
+    print(" per second)\n");
+    print_job_stats();
+    SDL_free(batch.stats);
+    return 0;
+}
+
+// bot games as training data; the time includes writing out what was still buffered at the end
+int export_bot_games(char* directory, int games, int max_shapes, s32 seed)
+{
+    TrainingExporter exporter;
+    if (!start_training_export(&exporter, directory, DEFAULT_TRAINING_SHARD_BYTES))
+    {
+        print("The export directory's path is too long\n");
+        return 1;
+    }
+    auto start = get_monotonic_nanoseconds();
+    auto result = run_bot_games(games, max_shapes, seed, &exporter);
+    stop_training_export(&exporter);
+    auto nanoseconds = get_monotonic_nanoseconds() - start;
+    print_training_export_stats(&exporter);
+    print(get_nodes_per_second(exporter.written_records, nanoseconds));
+    print(" records/sec\n");
+    if (exporter.failed_writes != 0) { return 1; }
+    return result;
+}
+
+#define DEFAULT_EVALUATION_BENCHMARK_POSITIONS 200
+#define EVALUATION_BENCHMARK_REPETITIONS 20
+
+// positions come from a bot game; every evaluator scores every placement of each one, and the batch evaluators have to
+// give exactly the scores evaluate_placement gives. Returns non-zero on any mismatch.
+int benchmark_board_evaluation(int position_count)
+{
+    initialize_shape_cell_maps();
+    auto generation = (MoveGeneration*)SDL_malloc(sizeof(MoveGeneration));
+    auto placements = (Placement*)SDL_malloc(MAX_LOCK_POSITIONS * sizeof(Placement));
+    auto expected = (float*)SDL_malloc(MAX_LOCK_POSITIONS * sizeof(float));
+    if (generation == NULL || placements == NULL || expected == NULL) { panic("Out of memory for evaluation benchmark"); }
+
+    auto best_level = get_best_memory_primitives_level();
+    u64 candidates = 0;
+    u64 per_board_nanoseconds = 0;
+    u64 batch_nanoseconds[countof(MEMORY_PRIMITIVES_LEVEL_NAMES)] = {};
+    int mismatches[countof(MEMORY_PRIMITIVES_LEVEL_NAMES)] = {};
+
+    BotStats stats;
+    set_memory(0, sizeof(stats), &stats);
+    GameState state;
+    s32 seed = 1;
+    initialize_game_state(seed, &state);
+    for (auto position = 0; position < position_count; position++)
+    {
+        auto count = enumerate_placements(&state, generation, placements);
+        candidates += count;
+
+        auto start = get_monotonic_nanoseconds();
+        for (auto repetition = 0; repetition < EVALUATION_BENCHMARK_REPETITIONS; repetition++)
+        {
+            for (auto i = 0; i < count; i++) { expected[i] = evaluate_placement(placements[i], &state, DEFAULT_BOT_WEIGHTS); }
+        }
+        per_board_nanoseconds += get_monotonic_nanoseconds() - start;
+
+        for (auto level = 0; level <= best_level; level++)
+        {
+            auto evaluator = make_board_batch_evaluator((MemoryPrimitivesLevel)level);
+            start = get_monotonic_nanoseconds();
+            for (auto repetition = 0; repetition < EVALUATION_BENCHMARK_REPETITIONS; repetition++)
+            { score_placements(evaluator, &state, generation, placements, count, DEFAULT_BOT_WEIGHTS, 0); }
+            batch_nanoseconds[level] += get_monotonic_nanoseconds() - start;
+            for (auto i = 0; i < count; i++) { mismatches[level] += placements[i].score != expected[i]; }
+        }
+
+        // next position: the bot's move, or a new game once this one is over
+        Placement placement;
+        if (find_best_placement(&state, DEFAULT_BOT_WEIGHTS, generation, &placement, &stats)) { apply_placement(placement, &state); }
+        else { state.mode = GameModeLost; }
+        if (state.mode != GameModePlaying) { initialize_game_state(++seed, &state); }
+    }
+
+    auto evaluations = candidates * EVALUATION_BENCHMARK_REPETITIONS;
+    auto per_board_speed = get_nodes_per_second(evaluations, per_board_nanoseconds);
+    print("positions: ");
+    print((s64)position_count);
+    print(", candidates: ");
+    print(candidates);
+    print("\nper board: ");
+    print(per_board_speed);
+    print(" candidates/sec\n");
+    auto failures = 0;
+    for (auto level = 0; level <= best_level; level++)
+    {
+        auto speed = get_nodes_per_second(evaluations, batch_nanoseconds[level]);
+        print("batch ");
+        print(MEMORY_PRIMITIVES_LEVEL_NAMES[level]);
+        print(": ");
+        print(speed);
+        print(" candidates/sec, ");
+        print(per_board_speed == 0 ? 0.0f : speed / per_board_speed);
+        print("x per board, mismatches ");
+        print((s64)mismatches[level]);
+        print("\n");
+        failures += mismatches[level];
+    }
+
+    SDL_free(generation);
+    SDL_free(placements);
+    SDL_free(expected);
+    return failures == 0 ? 0 : 1;
+}
+
+// the same positions as benchmark_board_evaluation, scored by the network at every level on this thread alone, so the
+// speeds are per core. Every level has to give exactly the portable scores. Returns non-zero on any mismatch.
+int benchmark_board_network(char* file_name, int position_count)
+{
+    initialize_shape_cell_maps();
+    auto network = load_board_network(file_name);
+    if (network == NULL)
+    {
+        print("Can't load the network file\n");
+        return 1;
+    }
+    auto generation = (MoveGeneration*)SDL_malloc(sizeof(MoveGeneration));
+    auto placements = (Placement*)SDL_malloc(MAX_LOCK_POSITIONS * sizeof(Placement));
+    auto expected = (float*)SDL_malloc(MAX_LOCK_POSITIONS * sizeof(float));
+    if (generation == NULL || placements == NULL || expected == NULL) { panic("Out of memory for network benchmark"); }
+
+    auto best_level = get_best_memory_primitives_level();
+    u64 candidates = 0;
+    u64 features_nanoseconds = 0;
+    u64 network_nanoseconds[countof(MEMORY_PRIMITIVES_LEVEL_NAMES)] = {};
+    int mismatches[countof(MEMORY_PRIMITIVES_LEVEL_NAMES)] = {};
+
+    BotStats stats;
+    set_memory(0, sizeof(stats), &stats);
+    GameState state;
+    s32 seed = 1;
+    initialize_game_state(seed, &state);
+    for (auto position = 0; position < position_count; position++)
+    {
+        auto count = enumerate_placements(&state, generation, placements);
+        candidates += count;
+
+        auto start = get_monotonic_nanoseconds();
+        for (auto repetition = 0; repetition < EVALUATION_BENCHMARK_REPETITIONS; repetition++)
+        { score_placements(g_board_batch_evaluator, &state, generation, placements, count, DEFAULT_BOT_WEIGHTS, 0); }
+        features_nanoseconds += get_monotonic_nanoseconds() - start;
+
+        for (auto level = 0; level <= best_level; level++)
+        {
+            auto evaluator = make_board_network_evaluator((MemoryPrimitivesLevel)level);
+            start = get_monotonic_nanoseconds();
+            for (auto repetition = 0; repetition < EVALUATION_BENCHMARK_REPETITIONS; repetition++)
+            { score_placements_with_network(evaluator, network, &state, generation, placements, count, DEFAULT_BOT_WEIGHTS, 0); }
+            network_nanoseconds[level] += get_monotonic_nanoseconds() - start;
+            for (auto i = 0; i < count; i++)
+            {
+                if (level == 0) { expected[i] = placements[i].score; }
+                else { mismatches[level] += placements[i].score != expected[i]; }
+            }
+        }
+
+        // the positions come from the feature bot, so every network sees the same ones
+        Placement placement;
+        if (find_best_placement(&state, DEFAULT_BOT_WEIGHTS, generation, &placement, &stats)) { apply_placement(placement, &state); }
+        else { state.mode = GameModeLost; }
+        if (state.mode != GameModePlaying) { initialize_game_state(++seed, &state); }
+    }
+
+    auto evaluations = candidates * EVALUATION_BENCHMARK_REPETITIONS;
+    print("positions: ");
+    print((s64)position_count);
+    print(", candidates: ");
+    print(candidates);
+    print("\nfeatures batch ");
+    print(MEMORY_PRIMITIVES_LEVEL_NAMES[g_board_batch_evaluator.level]);
+    print(": ");
+    print(get_nodes_per_second(evaluations, features_nanoseconds));
+    print(" evaluations/sec\n");
+    auto failures = 0;
+    for (auto level = 0; level <= best_level; level++)
+    {
+        print("network ");
+        print(MEMORY_PRIMITIVES_LEVEL_NAMES[level]);
+        print(": ");
+        print(get_nodes_per_second(evaluations, network_nanoseconds[level]));
+        print(" evaluations/sec, mismatches ");
+        print((s64)mismatches[level]);
+        print("\n");
+        failures += mismatches[level];
+    }
+
+    SDL_free(network);
+    SDL_free(generation);
+    SDL_free(placements);
+    SDL_free(expected);
+    return failures == 0 ? 0 : 1;
+}
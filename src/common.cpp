@@ -23,7 +23,47 @@ typedef u32 Pixel;
 #define LIGHT_PURPLE 0x770077
 #define PURPLE 0xff00ff
 
-HANDLE g_stdout = NULL;
+struct SystemTime
+{
+    u32 year;
+    u32 month;
+    u32 day;
+    u32 hour;
+    u32 minute;
+    u32 second;
+    u32 milliseconds;
+};
+
+struct UdpDatagram
+{
+    u32 address;
+    u16 port;
+    void* data;
+    u64 size; // of data; a receive sets it to the size of the datagram
+};
+
+// implemented once per OS, in platform_windows.cpp and platform_posix.cpp
+bool platform_write_to_stdout(char* data, u64 size); // false if stdout can't be acquired
+void platform_show_error_and_exit(char* message);
+SystemTime get_system_time();
+u64 get_monotonic_nanoseconds();
+s64 platform_read_file(char* file_name, void* buffer, u64 buffer_size); // -1 if the file can't be opened
+bool platform_write_file(char* file_name, void* data, u64 size);
+bool platform_append_file(char* file_name, void* data, u64 size); // creates the file if it doesn't exist
+bool platform_pin_thread_to_core(int core); // false where pinning isn't supported
+bool platform_enable_terminal_escapes(); // false if stdout isn't a terminal that takes ANSI escape sequences
+// non-blocking IPv4 UDP, addresses and ports in host byte order; -1 if the socket can't be opened or bound
+s64 platform_open_udp_socket(u16 port);
+bool platform_send_udp(s64 socket, u32 address, u16 port, void* data, u64 size);
+s64 platform_receive_udp(s64 socket, void* buffer, u64 buffer_size, u32* address, u16* port); // -1 if nothing is waiting
+void platform_close_udp_socket(s64 socket);
+// many datagrams per system call where the OS can (sendmmsg and recvmmsg on Linux); return how many went out or came in
+int platform_send_udp_batch(s64 socket, UdpDatagram* datagrams, int count);
+int platform_receive_udp_batch(s64 socket, UdpDatagram* datagrams, int count);
+// waits on one UDP socket: epoll on Linux, poll elsewhere
+s64 platform_open_udp_poller(s64 socket); // -1 on failure
+bool platform_wait_for_udp(s64 poller, int timeout_ms); // false if nothing arrived in time
+void platform_close_udp_poller(s64 poller);
 
 s64 absolute(s64 value) { return value >= 0 ? value : -value; }
 
@@ -51,6 +91,17 @@ void push(char* c_string, String* string)
     { push(c_string[i], string); }
 }
 
+// the line starting at *position without its "\n" or "\r\n"; moves *position to the start of the next one
+String get_next_line(String text, u64* position)
+{
+    auto end = *position;
+    while (end < text.size && text.data[end] != '\n') { end++; }
+    auto result = make_string(end - *position, text.data + *position);
+    if (result.size != 0 && result.data[result.size - 1] == '\r') { result.size--; }
+    *position = end + 1;
+    return result;
+}
+
 struct Vector { int x, y; };
 
 Vector make_vector(int x, int y)
@@ -79,41 +130,34 @@ int c_string_length(char* string)
     return result;
 }
 
+bool c_string_equals(char* left, char* right)
+{
+    auto i = 0;
+    while (left[i] != '\0' && left[i] == right[i]) { i++; }
+    return left[i] == right[i];
+}
+
 #define panic(message) panic_implementation(message, __FILE__, __LINE__)
 
 void panic_implementation(char* message, char* filename, int line);
 
+void flush_log();
+
 bool g_stdout_initialization_failed;
 
 void print(char* message, int length)
 {
-    if (g_stdout == NULL)
+    if (!platform_write_to_stdout(message, length))
     {
-        g_stdout = GetStdHandle(STD_OUTPUT_HANDLE);
-        if (g_stdout == NULL || g_stdout == INVALID_HANDLE_VALUE)
-        {
-            g_stdout_initialization_failed = true;
-            panic("Stdout initialization failed");
-        }
+        g_stdout_initialization_failed = true;
+        panic("Stdout initialization failed");
     }
-    WriteFile(g_stdout, message, length, NULL, NULL);
 }
 
 void print(String string) { print(string.data, string.size); }
 
 void print(char* message) { print(message, c_string_length(message)); }
 
-void set_memory(char value, u64 size, void* data)
-{
-    for (u64 i = 0; i < size; i++)
-    { ((char*)data)[i] = value; }
-}
-
-void copy_memory(u64 size, void* from, void* to)
-{
-    for (u64 i = 0; i < size; i++) { ((char*)to)[i] = ((char*)from)[i]; }
-}
-
 #define assert(condition) assert_implementation(condition, __FILE__, __LINE__)
 
 void assert_implementation(bool condition, char* filename, int line)
@@ -224,6 +268,8 @@ void float_to_string(float value, String* result)
     auto fraction = (s64)(value * 100000);
     if (fraction == 0) { return; }
     push('.', result);
+    // the zeros right after the point, which int_to_string would drop
+    for (auto digit = 10000; digit > fraction; digit /= 10) { push('0', result); }
     while (fraction % 10 == 0) { fraction /= 10; }
     int_to_string(fraction, result);
 }
@@ -248,14 +294,14 @@ void panic_implementation(char* message, char* filename, int line)
     push(message, &buffer);
     if (!g_stdout_initialization_failed)
     {
+        flush_log();
         auto original_size = buffer.size;
         push("\n", &buffer);
         print(buffer.data, buffer.size);
         buffer.size = original_size;
     }
     push('\0', &buffer);
-    MessageBoxA(NULL, buffer.data, "Error", MB_OK);
-    ExitProcess(1);
+    platform_show_error_and_exit(buffer.data);
 }
 
 #define panic_sdl(function_name) panic_sdl_implementation(function_name, __FILE__, __LINE__)
@@ -272,36 +318,14 @@ void panic_sdl_implementation(char* function_name, char* filename, int line)
     panic_implementation(message.data, filename, line);
 }
 
-struct SystemTime
+struct RandomNumberGenerator
 {
-    u32 year;
-    u32 month;
-    u32 day;
-    u32 hour;
-    u32 minute;
-    u32 second;
-    u32 milliseconds;
+    s64 previous;
 };
 
-SystemTime get_system_time()
-{
-    SystemTime result;
-    SYSTEMTIME windows_system_time;
-    GetSystemTime(&windows_system_time);
-    result.year = windows_system_time.wYear;
-    result.month = windows_system_time.wMonth;
-    result.day = windows_system_time.wDay;
-    result.hour = windows_system_time.wHour;
-    result.minute = windows_system_time.wMinute;
-    result.second = windows_system_time.wSecond;
-    result.milliseconds = windows_system_time.wMilliseconds;
-    return result;
-}
-
-s64 previous_random = 1;
-
-s32 get_random_number() { return previous_random = previous_random * 1103515243 + 12345; }
+s32 get_random_number(RandomNumberGenerator* generator) { return generator->previous = generator->previous * 1103515243 + 12345; }
 
-void seed_random_number_generator(s32 seed) { previous_random = seed; }
+void seed_random_number_generator(s32 seed, RandomNumberGenerator* generator) { generator->previous = seed; }
 
-s32 get_random_number_in_range(s32 min, s32 max) { return modulo(get_random_number(), max - min) + min; }
+s32 get_random_number_in_range(s32 min, s32 max, RandomNumberGenerator* generator)
+{ return modulo(get_random_number(generator), max - min) + min; }
@@ -0,0 +1,265 @@
+// Vectorized environments behind the C API in environment.h. Each game keeps its GameState and, from the last
+// observation, where every placement action would put the shape, so stepping is a table lookup plus apply_placement.
+// Steps run as a parallel-for over the games on the job system.
+
+#define TETRIS_ENVIRONMENT_BUILD
+#include "environment.h"
+
+#define ENVIRONMENT_STEP_BATCH_SIZE 16
+#define DEFAULT_ENVIRONMENT_BENCHMARK_COUNT 256
+#define DEFAULT_ENVIRONMENT_BENCHMARK_STEPS 1000
+
+#if TETRIS_BOARD_WIDTH != BOARD_WIDTH || TETRIS_BOARD_HEIGHT != BOARD_HEIGHT || TETRIS_PLACEMENT_ACTIONS != MOVE_GENERATOR_ORIENTATIONS * BOARD_WIDTH
+#error "environment.h is out of date"
+#endif
+static_assert(TETRIS_SHAPE_SINGLE_CELL == countof(ALL_SHAPES), "environment.h is out of date");
+
+struct Environment
+{
+    GameState state;
+    u32 games_played;
+    s8 placement_y[TETRIS_PLACEMENT_ACTIONS]; // -1 where the placement isn't reachable
+};
+
+struct TetrisEnvironments
+{
+    int count;
+    s32 seed;
+    Environment* environments;
+    // arguments of the step in progress
+    const s32* actions;
+    TetrisObservation* observations;
+    float* rewards;
+    u8* dones;
+};
+
+bool is_environment_action_legal(Environment* environment, int action)
+{
+    auto power_ups = &environment->state.power_ups;
+    switch (action)
+    {
+        case TETRIS_ACTION_FILL_CELL: return power_ups->fill_cell != 0;
+        case TETRIS_ACTION_INVERT_BOARD: return power_ups->invert_board != 0;
+        case TETRIS_ACTION_BOMB: return power_ups->bomb != 0;
+    }
+    return action >= 0 && action < TETRIS_PLACEMENT_ACTIONS && environment->placement_y[action] >= 0;
+}
+
+// returns how many actions are legal
+int write_observation(Environment* environment, TetrisObservation* observation)
+{
+    auto state = &environment->state;
+    observation->power_ups[0] = state->power_ups.mirror;
+    observation->power_ups[1] = state->power_ups.fill_cell;
+    observation->power_ups[2] = state->power_ups.invert_board;
+    observation->power_ups[3] = state->power_ups.bomb;
+    observation->score = state->score;
+    for (auto y = 0; y < BOARD_HEIGHT; y++) { observation->board[y] = (u8)pack_cell_map_row(y, state->board); }
+    observation->shape = (u8)get_shape_index(state->falling_shape.cell_map);
+
+    // the lowest locking position for each orientation and column; orientations that repeat an earlier one get none
+    MoveGeneration generation;
+    generate_moves(state, &generation);
+    for (auto orientation = 0; orientation < MOVE_GENERATOR_ORIENTATIONS; orientation++)
+    {
+        auto shape = &generation.orientations[orientation];
+        auto distinct = shape->valid && shape->canonical == orientation;
+        for (auto x = 0; x < BOARD_WIDTH; x++)
+        {
+            auto y = BOARD_HEIGHT - 1;
+            if (distinct) { while (y >= 0 && (generation.locked[orientation][y] & (1u << x)) == 0) { y--; } }
+            environment->placement_y[orientation * BOARD_WIDTH + x] = (s8)(distinct ? y : -1);
+        }
+    }
+
+    auto legal_count = 0;
+    for (auto action = 0; action < TETRIS_ACTION_COUNT; action++)
+    {
+        auto legal = state->mode == GameModePlaying && is_environment_action_legal(environment, action);
+        observation->legal_actions[action] = legal;
+        legal_count += legal;
+    }
+    return legal_count;
+}
+
+void start_environment_game(TetrisEnvironments* environments, int index)
+{
+    auto environment = &environments->environments[index];
+    auto seed = environments->seed + index + (s32)environment->games_played * environments->count;
+    initialize_game_state(seed, &environment->state);
+}
+
+void step_environments(void* data, int begin, int end)
+{
+    auto environments = (TetrisEnvironments*)data;
+    for (auto i = begin; i < end; i++)
+    {
+        auto environment = &environments->environments[i];
+        auto state = &environment->state;
+        auto action = environments->actions[i];
+        if (!is_environment_action_legal(environment, action))
+        {
+            action = 0;
+            while (action < TETRIS_ACTION_COUNT && !is_environment_action_legal(environment, action)) { action++; }
+        }
+
+        auto score = state->score;
+        if (action < TETRIS_PLACEMENT_ACTIONS)
+        {
+            Placement placement;
+            set_memory(0, sizeof(placement), &placement);
+            placement.rotations = (action / BOARD_WIDTH) & 3;
+            placement.mirrored = action / BOARD_WIDTH >= 4;
+            placement.x = action % BOARD_WIDTH;
+            placement.y = environment->placement_y[action];
+            apply_placement(placement, state);
+        }
+        else if (action < TETRIS_ACTION_COUNT)
+        {
+            // power ups go through the same input handling as the keys, with no time passing
+            GameInput input;
+            set_memory(0, sizeof(input), &input);
+            input.two = action == TETRIS_ACTION_FILL_CELL;
+            input.three = action == TETRIS_ACTION_INVERT_BOARD;
+            input.four = action == TETRIS_ACTION_BOMB;
+            process_input(0, input, state);
+        }
+        environments->rewards[i] = (float)(state->score - score);
+
+        // a game where nothing is legal any more is over too
+        auto observation = &environments->observations[i];
+        auto done = state->mode != GameModePlaying || write_observation(environment, observation) == 0;
+        if (done)
+        {
+            environment->games_played++;
+            start_environment_game(environments, i);
+            write_observation(environment, observation);
+        }
+        environments->dones[i] = done;
+    }
+}
+
+void tetris_initialize(int worker_count)
+{
+    initialize_memory_primitives();
+    initialize_board_batch_evaluator();
+    initialize_board_network_evaluator();
+    initialize_zobrist_keys();
+    initialize_shape_cell_maps();
+    start_log(get_log_severity_from_environment(LogSeverityInfo));
+    start_jobs(worker_count > 0 ? worker_count : get_job_worker_count_from_environment(), get_pin_threads_from_environment());
+}
+
+void tetris_shutdown(void)
+{
+    stop_jobs();
+    stop_log();
+}
+
+TetrisEnvironments* tetris_create_environments(int count)
+{
+    assert(count > 0);
+    auto result = (TetrisEnvironments*)SDL_calloc(1, sizeof(TetrisEnvironments));
+    if (result == NULL) { panic("Out of memory for environments"); }
+    result->count = count;
+    result->environments = (Environment*)SDL_calloc(count, sizeof(Environment));
+    if (result->environments == NULL) { panic("Out of memory for environments"); }
+    return result;
+}
+
+void tetris_destroy_environments(TetrisEnvironments* environments)
+{
+    SDL_free(environments->environments);
+    SDL_free(environments);
+}
+
+void reset_environments(void* data, int begin, int end)
+{
+    auto environments = (TetrisEnvironments*)data;
+    for (auto i = begin; i < end; i++)
+    {
+        environments->environments[i].games_played = 0;
+        start_environment_game(environments, i);
+        write_observation(&environments->environments[i], &environments->observations[i]);
+    }
+}
+
+void tetris_reset(TetrisEnvironments* environments, int32_t seed, TetrisObservation* observations)
+{
+    environments->seed = seed;
+    environments->observations = observations;
+    parallel_for(reset_environments, environments, environments->count, ENVIRONMENT_STEP_BATCH_SIZE);
+}
+
+void tetris_step(TetrisEnvironments* environments, const int32_t* actions, TetrisObservation* observations, float* rewards, uint8_t* dones)
+{
+    environments->actions = actions;
+    environments->observations = observations;
+    environments->rewards = rewards;
+    environments->dones = dones;
+    parallel_for(step_environments, environments, environments->count, ENVIRONMENT_STEP_BATCH_SIZE);
+}
+
+// plays uniformly random legal actions, the way an untrained agent would, and times the steps only
+int benchmark_environments(int count, int steps)
+{
+    initialize_shape_cell_maps();
+    auto environments = tetris_create_environments(count);
+    auto observations = (TetrisObservation*)SDL_malloc(count * sizeof(TetrisObservation));
+    auto actions = (s32*)SDL_malloc(count * sizeof(s32));
+    auto rewards = (float*)SDL_malloc(count * sizeof(float));
+    auto dones = (u8*)SDL_malloc(count * sizeof(u8));
+    if (observations == NULL || actions == NULL || rewards == NULL || dones == NULL) { panic("Out of memory for environment benchmark"); }
+
+    RandomNumberGenerator random;
+    seed_random_number_generator(1, &random);
+    reset_job_stats();
+    tetris_reset(environments, 1, observations);
+    u64 step_nanoseconds = 0;
+    u64 games_finished = 0;
+    u64 rows_cleared = 0;
+    for (auto step = 0; step < steps; step++)
+    {
+        for (auto i = 0; i < count; i++)
+        {
+            auto legal = observations[i].legal_actions;
+            auto legal_count = 0;
+            for (auto action = 0; action < TETRIS_ACTION_COUNT; action++) { legal_count += legal[action]; }
+            auto choice = get_random_number_in_range(0, legal_count, &random);
+            actions[i] = 0;
+            for (auto action = 0; action < TETRIS_ACTION_COUNT; action++)
+            {
+                if (legal[action] && choice-- == 0) { actions[i] = action; }
+            }
+        }
+        auto start = get_monotonic_nanoseconds();
+        tetris_step(environments, actions, observations, rewards, dones);
+        step_nanoseconds += get_monotonic_nanoseconds() - start;
+        for (auto i = 0; i < count; i++)
+        {
+            games_finished += dones[i];
+            rows_cleared += (u64)rewards[i];
+        }
+    }
+
+    auto total_steps = (u64)count * steps;
+    print("environments: ");
+    print((s64)count);
+    print(", steps: ");
+    print(total_steps);
+    print(", games finished: ");
+    print(games_finished);
+    print(", rows cleared: ");
+    print(rows_cleared);
+    print("\n");
+    print(get_nodes_per_second(total_steps, step_nanoseconds));
+    print(" env steps/sec\n");
+    print_job_stats();
+
+    tetris_destroy_environments(environments);
+    SDL_free(observations);
+    SDL_free(actions);
+    SDL_free(rewards);
+    SDL_free(dones);
+    return 0;
+}
@@ -0,0 +1,66 @@
+// C API for training agents: a batch of independent games stepped together, one placement per game per step.
+// Actions 0-63 place the falling shape: orientation * TETRIS_BOARD_WIDTH + x, where orientations 0-3 are the spawned shape
+// turned 0-3 times and 4-7 the mirrored shape turned 0-3 times (using up a mirror power up). The shape goes to the lowest
+// position it can reach there with the game's own moves. Actions 64-66 use the fill cell, invert board and bomb power ups.
+// legal_actions in the observation says which actions do something; an illegal action plays the first legal one.
+// A game that ends is reset right away with its next seed, so the observation after done is the new game's first one.
+// All buffers belong to the caller and hold one entry per game; the library writes straight into them.
+// tetris_initialize has to come first, and all calls have to come from the thread that called it.
+
+#ifndef TETRIS_ENVIRONMENT_H
+#define TETRIS_ENVIRONMENT_H
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#ifdef TETRIS_ENVIRONMENT_BUILD
+#define TETRIS_API __declspec(dllexport)
+#else
+#define TETRIS_API __declspec(dllimport)
+#endif
+#else
+#define TETRIS_API __attribute__((visibility("default")))
+#endif
+
+#define TETRIS_BOARD_WIDTH 8
+#define TETRIS_BOARD_HEIGHT 20
+#define TETRIS_PLACEMENT_ACTIONS 64
+#define TETRIS_ACTION_FILL_CELL 64
+#define TETRIS_ACTION_INVERT_BOARD 65
+#define TETRIS_ACTION_BOMB 66
+#define TETRIS_ACTION_COUNT 67
+#define TETRIS_SHAPE_SINGLE_CELL 5 // what the fill cell power up turns the falling shape into
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct TetrisObservation
+{
+    int32_t power_ups[4]; // mirror, fill cell, invert board, bomb
+    int32_t score;
+    uint8_t board[TETRIS_BOARD_HEIGHT]; // from the top down, bit x set for a filled cell in column x
+    uint8_t shape; // falling shape: square, T, pipe, L, snake, or TETRIS_SHAPE_SINGLE_CELL
+    uint8_t legal_actions[TETRIS_ACTION_COUNT]; // 1 or 0
+} TetrisObservation;
+
+typedef struct TetrisEnvironments TetrisEnvironments;
+
+// worker_count threads step games in parallel, the calling thread included; 0 uses one per core
+TETRIS_API void tetris_initialize(int worker_count);
+TETRIS_API void tetris_shutdown(void);
+
+TETRIS_API TetrisEnvironments* tetris_create_environments(int count);
+TETRIS_API void tetris_destroy_environments(TetrisEnvironments* environments);
+
+// game i starts from seed + i; its later games use seed + i + count, seed + i + 2 * count, ...
+TETRIS_API void tetris_reset(TetrisEnvironments* environments, int32_t seed, TetrisObservation* observations);
+
+// rewards are rows cleared by the step, dones are 1 for games that ended and were reset
+TETRIS_API void tetris_step(TetrisEnvironments* environments, const int32_t* actions, TetrisObservation* observations, float* rewards, uint8_t* dones);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,44 @@
+// Unity build of the training environment as a shared library: the rules core and the C API from environment.h,
+// without the window, rendering or headless commands.
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <windows.h>
+#include "lib/SDL2/SDL.h"
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+#include <SDL2/SDL.h>
+#endif
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+#include "common.cpp"
+#ifdef _WIN32
+#include "platform_windows.cpp"
+#else
+#include "platform_posix.cpp"
+#endif
+#include "memory.cpp"
+#include "log.cpp"
+#include "jobs.cpp"
+#include "game_state.cpp"
+#include "move_generator.cpp"
+#include "evaluation.cpp"
+#include "network.cpp"
+#include "training_export.cpp"
+#include "bot.cpp"
+#include "environment.cpp"
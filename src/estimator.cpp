@@ -0,0 +1,308 @@
+// Monte Carlo survival and score estimator, for balancing the power ups. From a board snapshot it plays many
+// continuations with different shape sequences and estimates how likely the game survives the next shapes and how many
+// rows it clears on the way, with 95% confidence intervals: Wilson's for survival, the normal one for score.
+// Continuations are played by the greedy bot, which also uses a fill cell, invert board or bomb power up whenever the best
+// placement after using it beats the best one without, so power ups get used the way a player would use them and their
+// awards and caps in clear_solid_rows show up in the estimates. Rollouts run ESTIMATOR_BATCH_ROLLOUTS at a time on the job
+// system and stop early once both intervals are narrower than the ESTIMATOR_*_PRECISION targets.
+//
+// Snapshot files are text, one board row or setting per line:
+//   ..##.#..      a board row, '#' for a filled cell; rows go from the top down and the last one is the bottom row
+//   mirror 2      power up counts: mirror, fill_cell, invert_board, bomb (otherwise the starting 1 of each)
+//   score 7       the score so far, which decides the power up each of the next cleared rows gives (otherwise 0)
+
+#define ESTIMATOR_BATCH_ROLLOUTS 256
+#define ESTIMATOR_SURVIVAL_PRECISION 0.01f // half the width of the survival interval
+#define ESTIMATOR_SCORE_PRECISION 0.02f // half the width of the score interval, relative to the expected score
+#define ESTIMATOR_Z 1.96 // 95% confidence
+#define DEFAULT_ESTIMATOR_SHAPES 200
+#define DEFAULT_ESTIMATOR_MAX_ROLLOUTS 100000
+#define MAX_SNAPSHOT_FILE_SIZE 4096
+
+char* POWER_UP_NAMES[] = { "mirror", "fill_cell", "invert_board", "bomb" };
+
+struct Rollout
+{
+    bool survived;
+    s32 score; // rows cleared
+    u32 shapes;
+    u32 power_ups_used[countof(POWER_UP_NAMES)];
+};
+
+struct RolloutBatch
+{
+    GameState* snapshot;
+    BotWeights weights;
+    int shapes;
+    s32 seed; // of rollout 0
+    int first; // rollout of the batch's job 0
+    Rollout* rollouts;
+};
+
+s32* get_power_up_count(GameState* state, int power_up)
+{
+    switch (power_up)
+    {
+        case 0: return &state->power_ups.mirror;
+        case 1: return &state->power_ups.fill_cell;
+        case 2: return &state->power_ups.invert_board;
+    }
+    return &state->power_ups.bomb;
+}
+
+// returns false on anything it doesn't understand, after printing the line
+bool load_snapshot(char* file_name, GameState* state)
+{
+    char data[MAX_SNAPSHOT_FILE_SIZE];
+    auto size = platform_read_file(file_name, data, sizeof(data));
+    if (size < 0 || size == sizeof(data))
+    {
+        print("Can't read the snapshot file or it's too big\n");
+        return false;
+    }
+    initialize_game_state(0, state);
+    for (auto y = 0; y < BOARD_HEIGHT; y++)
+    {
+        for (auto x = 0; x < BOARD_WIDTH; x++) { set_cell(x, y, false, &state->board); }
+    }
+
+    // rows are collected from the top down and moved to the bottom once they've all been read
+    u8 rows[BOARD_HEIGHT];
+    auto row_count = 0;
+    auto line_number = 0;
+    auto text = make_string(size, data);
+    for (u64 position = 0; position < text.size;)
+    {
+        auto line = get_next_line(text, &position);
+        line_number++;
+        if (line.size == 0) { continue; }
+
+        auto is_row = line.size == BOARD_WIDTH;
+        for (auto x = 0; x < line.size; x++) { is_row &= line.data[x] == '#' || line.data[x] == '.'; }
+        auto understood = false;
+        if (is_row && row_count < BOARD_HEIGHT)
+        {
+            rows[row_count] = 0;
+            for (auto x = 0; x < BOARD_WIDTH; x++) { rows[row_count] |= (line.data[x] == '#') << x; }
+            row_count++;
+            understood = true;
+        }
+        else if (!is_row)
+        {
+            auto space = 0;
+            while (space < line.size && line.data[space] != ' ') { space++; }
+            char key[32];
+            auto key_size = MIN(space, (int)sizeof(key) - 1);
+            copy_memory(key_size, line.data, key);
+            key[key_size] = '\0';
+            auto value = string_to_int(make_string(space < line.size ? line.size - space - 1 : 0, line.data + space + 1));
+            if (value.success && value.value >= 0)
+            {
+                for (auto power_up = 0; power_up < countof(POWER_UP_NAMES); power_up++)
+                {
+                    if (c_string_equals(key, POWER_UP_NAMES[power_up]))
+                    {
+                        *get_power_up_count(state, power_up) = value.value;
+                        understood = true;
+                    }
+                }
+                if (c_string_equals(key, "score"))
+                {
+                    state->score = value.value;
+                    understood = true;
+                }
+            }
+        }
+        if (!understood)
+        {
+            print("Snapshot line ");
+            print((s64)line_number);
+            print(" isn't a board row or a setting: ");
+            print(line);
+            print("\n");
+            return false;
+        }
+    }
+    for (auto i = 0; i < row_count; i++)
+    {
+        auto y = BOARD_HEIGHT - row_count + i;
+        for (auto x = 0; x < BOARD_WIDTH; x++) { set_cell(x, y, (rows[i] >> x) & 1, &state->board); }
+    }
+    state->board_hash = hash_board(state->board);
+    state->high_score = state->score;
+    return true;
+}
+
+// one shape of the rollout policy; returns false if the shape has nowhere to go
+bool play_rollout_shape(GameState* state, BotWeights weights, Rollout* rollout)
+{
+    MoveGeneration generation;
+    BotStats stats;
+    set_memory(0, sizeof(stats), &stats);
+    Placement best;
+    auto found = find_best_placement(state, weights, &generation, &best, &stats);
+    auto best_power_up = -1;
+    GameState best_state;
+    // fill cell, invert board and bomb go through the same input handling as the keys; mirroring is a placement
+    for (auto power_up = 1; power_up < countof(POWER_UP_NAMES); power_up++)
+    {
+        if (*get_power_up_count(state, power_up) == 0) { continue; }
+        auto option = *state;
+        GameInput input;
+        set_memory(0, sizeof(input), &input);
+        input.two = power_up == 1;
+        input.three = power_up == 2;
+        input.four = power_up == 3;
+        process_input(0, input, &option);
+        Placement placement;
+        if (!find_best_placement(&option, weights, &generation, &placement, &stats)) { continue; }
+        if (!found || placement.score > best.score)
+        {
+            found = true;
+            best = placement;
+            best_power_up = power_up;
+            best_state = option;
+        }
+    }
+    if (!found) { return false; }
+    if (best_power_up >= 0)
+    {
+        *state = best_state;
+        rollout->power_ups_used[best_power_up]++;
+    }
+    rollout->power_ups_used[0] += best.mirrored;
+    apply_placement(best, state);
+    return true;
+}
+
+void play_rollouts(void* data, int begin, int end)
+{
+    auto batch = (RolloutBatch*)data;
+    for (auto i = batch->first + begin; i < batch->first + end; i++)
+    {
+        auto rollout = &batch->rollouts[i];
+        set_memory(0, sizeof(*rollout), rollout);
+        auto state = *batch->snapshot;
+        seed_random_number_generator(batch->seed + i, &state.random);
+        generate_new_falling_shape(&state);
+        check_for_game_over(&state);
+        while (state.mode == GameModePlaying && rollout->shapes < batch->shapes)
+        {
+            if (!play_rollout_shape(&state, batch->weights, rollout)) { state.mode = GameModeLost; }
+            else { rollout->shapes++; }
+        }
+        rollout->survived = state.mode == GameModePlaying;
+        rollout->score = state.score - batch->snapshot->score;
+    }
+}
+
+struct Estimate
+{
+    int rollouts;
+    float survival, survival_low, survival_high;
+    float score, score_margin; // the interval is score ± score_margin
+};
+
+Estimate get_estimate(Rollout* rollouts, int count)
+{
+    u64 survived = 0;
+    s64 score_sum = 0;
+    s64 score_square_sum = 0;
+    for (auto i = 0; i < count; i++)
+    {
+        survived += rollouts[i].survived;
+        score_sum += rollouts[i].score;
+        score_square_sum += (s64)rollouts[i].score * rollouts[i].score;
+    }
+    Estimate result;
+    result.rollouts = count;
+    double n = count;
+    auto z = ESTIMATOR_Z;
+    auto p = survived / n;
+    auto center = (p + z * z / (2 * n)) / (1 + z * z / n);
+    auto margin = z * SDL_sqrt(p * (1 - p) / n + z * z / (4 * n * n)) / (1 + z * z / n);
+    result.survival = (float)p;
+    result.survival_low = (float)MAX(center - margin, 0.0);
+    result.survival_high = (float)MIN(center + margin, 1.0);
+    auto mean = score_sum / n;
+    auto variance = count > 1 ? MAX((score_square_sum - score_sum * mean) / (n - 1), 0.0) : 0.0;
+    result.score = (float)mean;
+    result.score_margin = (float)(z * SDL_sqrt(variance / n));
+    return result;
+}
+
+bool has_estimate_converged(Estimate estimate)
+{
+    return (estimate.survival_high - estimate.survival_low) / 2 <= ESTIMATOR_SURVIVAL_PRECISION
+        && estimate.score_margin <= ESTIMATOR_SCORE_PRECISION * MAX(estimate.score, 1.0f);
+}
+
+void print_estimate(Estimate estimate)
+{
+    print("rollouts ");
+    print((s64)estimate.rollouts);
+    print(": survival ");
+    print(estimate.survival);
+    print(" (");
+    print(estimate.survival_low);
+    print(" to ");
+    print(estimate.survival_high);
+    print("), rows cleared ");
+    print(estimate.score);
+    print(" +- ");
+    print(estimate.score_margin);
+    print("\n");
+}
+
+int run_estimator(char* snapshot_file_name, int shapes, int max_rollouts, s32 seed)
+{
+    initialize_shape_cell_maps();
+    GameState snapshot;
+    if (!load_snapshot(snapshot_file_name, &snapshot)) { return 1; }
+    RolloutBatch batch;
+    batch.snapshot = &snapshot;
+    batch.weights = DEFAULT_BOT_WEIGHTS;
+    batch.shapes = shapes;
+    batch.seed = seed;
+    batch.rollouts = (Rollout*)SDL_malloc(max_rollouts * sizeof(Rollout));
+    if (batch.rollouts == NULL) { panic("Out of memory for rollouts"); }
+
+    reset_job_stats();
+    auto start = get_monotonic_nanoseconds();
+    auto count = 0;
+    Estimate estimate;
+    do
+    {
+        auto batch_count = MIN(ESTIMATOR_BATCH_ROLLOUTS, max_rollouts - count);
+        batch.first = count;
+        parallel_for(play_rollouts, &batch, batch_count, 1);
+        count += batch_count;
+        estimate = get_estimate(batch.rollouts, count);
+        print_estimate(estimate);
+    } while (count < max_rollouts && !has_estimate_converged(estimate));
+    auto nanoseconds = get_monotonic_nanoseconds() - start;
+
+    print(has_estimate_converged(estimate) ? (char*)"converged" : (char*)"stopped at the rollout limit before converging");
+    print(" after ");
+    print((float)nanoseconds / 1e9f);
+    print(" seconds, ");
+    print(get_nodes_per_second(count, nanoseconds));
+    print(" rollouts/sec\npower ups used per rollout:");
+    u64 shapes_played = 0;
+    for (auto i = 0; i < count; i++) { shapes_played += batch.rollouts[i].shapes; }
+    for (auto power_up = 0; power_up < countof(POWER_UP_NAMES); power_up++)
+    {
+        u64 used = 0;
+        for (auto i = 0; i < count; i++) { used += batch.rollouts[i].power_ups_used[power_up]; }
+        print(" ");
+        print(POWER_UP_NAMES[power_up]);
+        print(" ");
+        print((float)used / (float)count);
+    }
+    print("\nshapes per rollout: ");
+    print((float)shapes_played / (float)count);
+    print("\n");
+    print_job_stats();
+    SDL_free(batch.rollouts);
+    return 0;
+}
@@ -0,0 +1,366 @@
+// Board evaluation. get_board_features looks at one board cell by cell. The batch evaluator scores up to
+// BOARD_BATCH_SIZE candidate boards at once: each board row packs into one byte, and the batch keeps row y of every
+// candidate next to each other, so one SSE2/AVX2 register holds the same row of 16/32 boards and every feature is a
+// handful of byte-wise bit operations per row, summed top to bottom.
+// Candidates are boards with the shape cemented but before full rows are cleared. The sums only depend on the order of the
+// rows, so clearing is done by skipping full rows, plus two row transitions (one against each wall) for the empty row each
+// clear brings in at the top. The game is lost exactly when the top row has anything in it, since clearing never empties it.
+
+#define LOST_GAME_SCORE -1e30f
+#define BOARD_BATCH_SIZE 32
+
+#if BOARD_WIDTH != 8 || BOARD_HEIGHT * (BOARD_WIDTH + 1) > 255
+#error "the batch evaluator needs one byte per board row and per feature"
+#endif
+
+struct BotWeights
+{
+    float aggregate_height;
+    float holes;
+    float bumpiness;
+    float cleared_rows;
+    float row_transitions;
+};
+
+// the usual hand-tuned starting point for the first four features; row transitions are left for tuning
+BotWeights DEFAULT_BOT_WEIGHTS = { -0.510066f, -0.35663f, -0.184483f, 0.760666f, 0.0f };
+
+struct BoardFeatures
+{
+    int aggregate_height;
+    int holes;
+    int bumpiness;
+    int cleared_rows;
+    int row_transitions; // filled/empty changes along each row, the walls counting as filled
+};
+
+BoardFeatures get_board_features(CellMap board)
+{
+    BoardFeatures result;
+    set_memory(0, sizeof(result), &result);
+    int column_heights[CELL_MAP_PITCH];
+    for (auto x = 0; x < board.width; x++)
+    {
+        column_heights[x] = 0;
+        for (auto y = 0; y < board.height; y++)
+        {
+            if (get_cell(x, y, board))
+            {
+                if (column_heights[x] == 0) { column_heights[x] = board.height - y; }
+            }
+            else if (column_heights[x] != 0) { result.holes++; }
+        }
+        result.aggregate_height += column_heights[x];
+        if (x != 0) { result.bumpiness += absolute(column_heights[x] - column_heights[x - 1]); }
+    }
+    for (auto y = 0; y < board.height; y++)
+    {
+        auto previous = true;
+        for (auto x = 0; x < board.width; x++)
+        {
+            auto filled = get_cell(x, y, board);
+            if (filled != previous) { result.row_transitions++; }
+            previous = filled;
+        }
+        if (!previous) { result.row_transitions++; }
+    }
+    return result;
+}
+
+float score_board_features(BoardFeatures features, BotWeights weights)
+{
+    return features.aggregate_height * weights.aggregate_height
+        + features.holes * weights.holes
+        + features.bumpiness * weights.bumpiness
+        + features.cleared_rows * weights.cleared_rows
+        + features.row_transitions * weights.row_transitions;
+}
+
+struct BoardBatch
+{
+    int count;
+    u8 rows[BOARD_HEIGHT][BOARD_BATCH_SIZE]; // bit x of rows[y][i] is the cell at (x, y) of candidate i
+};
+
+// features after clearing full rows, one array per feature
+struct BoardBatchFeatures
+{
+    u8 aggregate_height[BOARD_BATCH_SIZE];
+    u8 holes[BOARD_BATCH_SIZE];
+    u8 bumpiness[BOARD_BATCH_SIZE];
+    u8 row_transitions[BOARD_BATCH_SIZE];
+    u8 full_rows[BOARD_BATCH_SIZE];
+    u8 lost[BOARD_BATCH_SIZE]; // 1 or 0
+};
+
+// unused candidates stay empty boards, so the kernels can always run over the whole batch
+void clear_board_batch(BoardBatch* batch)
+{
+    batch->count = 0;
+    set_memory(0, sizeof(batch->rows), batch->rows);
+}
+
+// the board with the shape's packed rows cemented at (x, y); returns the candidate's index
+int add_board_to_batch(PackedBoard* board, u32* shape_rows, int shape_height, int x, int y, BoardBatch* batch)
+{
+    assert(batch->count < BOARD_BATCH_SIZE);
+    auto index = batch->count++;
+    for (auto row = 0; row < BOARD_HEIGHT; row++) { batch->rows[row][index] = (u8)board->rows[row]; }
+    for (auto shape_y = 0; shape_y < shape_height; shape_y++)
+    { batch->rows[y + shape_y][index] |= (u8)(shape_rows[shape_y] << x); }
+    return index;
+}
+
+int count_set_bits(u32 value)
+{
+    auto result = 0;
+    for (; value != 0; value &= value - 1) { result++; }
+    return result;
+}
+
+void get_board_batch_features_portable(BoardBatch* batch, BoardBatchFeatures* features)
+{
+    for (auto i = 0; i < BOARD_BATCH_SIZE; i++)
+    {
+        u32 covered = 0;
+        auto aggregate_height = 0;
+        auto holes = 0;
+        auto bumpiness = 0;
+        auto row_transitions = 0;
+        auto full_rows = 0;
+        for (auto y = 0; y < BOARD_HEIGHT; y++)
+        {
+            u32 row = batch->rows[y][i];
+            if (row == 0xff)
+            {
+                full_rows++;
+                continue;
+            }
+            holes += count_set_bits(~row & covered);
+            covered |= row;
+            // a column counts once for every row from its top down
+            aggregate_height += count_set_bits(covered);
+            bumpiness += count_set_bits((covered ^ (covered >> 1)) & 0x7f);
+            row_transitions += count_set_bits((row ^ ((row << 1) | 1)) & 0xff) + ((row & 0x80) == 0);
+        }
+        features->aggregate_height[i] = (u8)aggregate_height;
+        features->holes[i] = (u8)holes;
+        features->bumpiness[i] = (u8)bumpiness;
+        features->row_transitions[i] = (u8)(row_transitions + 2 * full_rows);
+        features->full_rows[i] = (u8)full_rows;
+        features->lost[i] = batch->rows[0][i] != 0;
+    }
+}
+
+void score_board_batch_portable(BoardBatchFeatures* features, BotWeights weights, int cleared_rows_offset, float* scores)
+{
+    for (auto i = 0; i < BOARD_BATCH_SIZE; i++)
+    {
+        if (features->lost[i])
+        {
+            scores[i] = LOST_GAME_SCORE;
+            continue;
+        }
+        BoardFeatures board;
+        board.aggregate_height = features->aggregate_height[i];
+        board.holes = features->holes[i];
+        board.bumpiness = features->bumpiness[i];
+        board.cleared_rows = cleared_rows_offset + features->full_rows[i];
+        board.row_transitions = features->row_transitions[i];
+        scores[i] = score_board_features(board, weights);
+    }
+}
+
+#ifdef MEMORY_PRIMITIVES_X86
+
+// There are no byte shifts, so bytes shift as 16-bit lanes and masks drop the bits that crossed into the neighbour.
+// The vector scorers add the weighted features in the same order as score_board_features, so scores match it exactly.
+
+TARGET_SSE2 __m128i count_byte_bits_sse2(__m128i value)
+{
+    value = _mm_sub_epi8(value, _mm_and_si128(_mm_srli_epi16(value, 1), _mm_set1_epi8(0x55)));
+    value = _mm_add_epi8(_mm_and_si128(value, _mm_set1_epi8(0x33)), _mm_and_si128(_mm_srli_epi16(value, 2), _mm_set1_epi8(0x33)));
+    return _mm_and_si128(_mm_add_epi8(value, _mm_srli_epi16(value, 4)), _mm_set1_epi8(0x0f));
+}
+
+TARGET_SSE2 void get_board_batch_features_sse2(BoardBatch* batch, BoardBatchFeatures* features)
+{
+    auto zero = _mm_setzero_si128();
+    auto all_ones = _mm_set1_epi8(-1);
+    auto low_seven = _mm_set1_epi8(0x7f);
+    auto one = _mm_set1_epi8(1);
+    for (auto i = 0; i < BOARD_BATCH_SIZE; i += 16)
+    {
+        auto covered = zero;
+        auto aggregate_height = zero;
+        auto holes = zero;
+        auto bumpiness = zero;
+        auto row_transitions = zero;
+        auto full_rows = zero;
+        for (auto y = 0; y < BOARD_HEIGHT; y++)
+        {
+            auto row = _mm_loadu_si128((__m128i*)&batch->rows[y][i]);
+            // comparisons give -1 where true; a full row has no holes or transitions of its own
+            auto full = _mm_cmpeq_epi8(row, all_ones);
+            full_rows = _mm_sub_epi8(full_rows, full);
+            holes = _mm_add_epi8(holes, count_byte_bits_sse2(_mm_andnot_si128(row, covered)));
+            covered = _mm_or_si128(covered, _mm_andnot_si128(full, row));
+            aggregate_height = _mm_add_epi8(aggregate_height, _mm_andnot_si128(full, count_byte_bits_sse2(covered)));
+            auto steps = _mm_and_si128(_mm_xor_si128(covered, _mm_srli_epi16(covered, 1)), low_seven);
+            bumpiness = _mm_add_epi8(bumpiness, _mm_andnot_si128(full, count_byte_bits_sse2(steps)));
+            auto shifted = _mm_or_si128(_mm_add_epi8(row, row), one);
+            row_transitions = _mm_add_epi8(row_transitions, count_byte_bits_sse2(_mm_xor_si128(row, shifted)));
+            row_transitions = _mm_sub_epi8(row_transitions, _mm_cmpgt_epi8(row, all_ones));
+        }
+        row_transitions = _mm_add_epi8(row_transitions, _mm_add_epi8(full_rows, full_rows));
+        auto top = _mm_loadu_si128((__m128i*)&batch->rows[0][i]);
+        _mm_storeu_si128((__m128i*)&features->aggregate_height[i], aggregate_height);
+        _mm_storeu_si128((__m128i*)&features->holes[i], holes);
+        _mm_storeu_si128((__m128i*)&features->bumpiness[i], bumpiness);
+        _mm_storeu_si128((__m128i*)&features->row_transitions[i], row_transitions);
+        _mm_storeu_si128((__m128i*)&features->full_rows[i], full_rows);
+        _mm_storeu_si128((__m128i*)&features->lost[i], _mm_andnot_si128(_mm_cmpeq_epi8(top, zero), one));
+    }
+}
+
+// four candidates at a time, from the low 4 bytes
+TARGET_SSE2 __m128i load_u8x4_as_s32_sse2(u8* bytes)
+{
+    auto zero = _mm_setzero_si128();
+    auto value = _mm_cvtsi32_si128((int)(bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((u32)bytes[3] << 24)));
+    return _mm_unpacklo_epi16(_mm_unpacklo_epi8(value, zero), zero);
+}
+
+TARGET_SSE2 void score_board_batch_sse2(BoardBatchFeatures* features, BotWeights weights, int cleared_rows_offset, float* scores)
+{
+    auto offset = _mm_set1_epi32(cleared_rows_offset);
+    auto lost_score = _mm_set1_ps(LOST_GAME_SCORE);
+    for (auto i = 0; i < BOARD_BATCH_SIZE; i += 4)
+    {
+        auto aggregate_height = _mm_cvtepi32_ps(load_u8x4_as_s32_sse2(&features->aggregate_height[i]));
+        auto holes = _mm_cvtepi32_ps(load_u8x4_as_s32_sse2(&features->holes[i]));
+        auto bumpiness = _mm_cvtepi32_ps(load_u8x4_as_s32_sse2(&features->bumpiness[i]));
+        auto cleared_rows = _mm_cvtepi32_ps(_mm_add_epi32(load_u8x4_as_s32_sse2(&features->full_rows[i]), offset));
+        auto row_transitions = _mm_cvtepi32_ps(load_u8x4_as_s32_sse2(&features->row_transitions[i]));
+        auto score = _mm_mul_ps(aggregate_height, _mm_set1_ps(weights.aggregate_height));
+        score = _mm_add_ps(score, _mm_mul_ps(holes, _mm_set1_ps(weights.holes)));
+        score = _mm_add_ps(score, _mm_mul_ps(bumpiness, _mm_set1_ps(weights.bumpiness)));
+        score = _mm_add_ps(score, _mm_mul_ps(cleared_rows, _mm_set1_ps(weights.cleared_rows)));
+        score = _mm_add_ps(score, _mm_mul_ps(row_transitions, _mm_set1_ps(weights.row_transitions)));
+        auto lost = _mm_castsi128_ps(_mm_cmpgt_epi32(load_u8x4_as_s32_sse2(&features->lost[i]), _mm_setzero_si128()));
+        _mm_storeu_ps(scores + i, _mm_or_ps(_mm_and_ps(lost, lost_score), _mm_andnot_ps(lost, score)));
+    }
+}
+
+// bit counts from a 16-entry table per nibble instead of the shift-and-add steps
+TARGET_AVX2 __m256i count_byte_bits_avx2(__m256i value)
+{
+    auto table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    auto low_nibbles = _mm256_set1_epi8(0x0f);
+    auto low = _mm256_shuffle_epi8(table, _mm256_and_si256(value, low_nibbles));
+    auto high = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(value, 4), low_nibbles));
+    return _mm256_add_epi8(low, high);
+}
+
+TARGET_AVX2 void get_board_batch_features_avx2(BoardBatch* batch, BoardBatchFeatures* features)
+{
+    auto zero = _mm256_setzero_si256();
+    auto all_ones = _mm256_set1_epi8(-1);
+    auto low_seven = _mm256_set1_epi8(0x7f);
+    auto one = _mm256_set1_epi8(1);
+    auto covered = zero;
+    auto aggregate_height = zero;
+    auto holes = zero;
+    auto bumpiness = zero;
+    auto row_transitions = zero;
+    auto full_rows = zero;
+    for (auto y = 0; y < BOARD_HEIGHT; y++)
+    {
+        auto row = _mm256_loadu_si256((__m256i*)batch->rows[y]);
+        auto full = _mm256_cmpeq_epi8(row, all_ones);
+        full_rows = _mm256_sub_epi8(full_rows, full);
+        holes = _mm256_add_epi8(holes, count_byte_bits_avx2(_mm256_andnot_si256(row, covered)));
+        covered = _mm256_or_si256(covered, _mm256_andnot_si256(full, row));
+        aggregate_height = _mm256_add_epi8(aggregate_height, _mm256_andnot_si256(full, count_byte_bits_avx2(covered)));
+        auto steps = _mm256_and_si256(_mm256_xor_si256(covered, _mm256_srli_epi16(covered, 1)), low_seven);
+        bumpiness = _mm256_add_epi8(bumpiness, _mm256_andnot_si256(full, count_byte_bits_avx2(steps)));
+        auto shifted = _mm256_or_si256(_mm256_add_epi8(row, row), one);
+        row_transitions = _mm256_add_epi8(row_transitions, count_byte_bits_avx2(_mm256_xor_si256(row, shifted)));
+        row_transitions = _mm256_sub_epi8(row_transitions, _mm256_cmpgt_epi8(row, all_ones));
+    }
+    row_transitions = _mm256_add_epi8(row_transitions, _mm256_add_epi8(full_rows, full_rows));
+    auto top = _mm256_loadu_si256((__m256i*)batch->rows[0]);
+    _mm256_storeu_si256((__m256i*)features->aggregate_height, aggregate_height);
+    _mm256_storeu_si256((__m256i*)features->holes, holes);
+    _mm256_storeu_si256((__m256i*)features->bumpiness, bumpiness);
+    _mm256_storeu_si256((__m256i*)features->row_transitions, row_transitions);
+    _mm256_storeu_si256((__m256i*)features->full_rows, full_rows);
+    _mm256_storeu_si256((__m256i*)features->lost, _mm256_andnot_si256(_mm256_cmpeq_epi8(top, zero), one));
+}
+
+// eight candidates at a time
+TARGET_AVX2 __m256 load_u8x8_as_float_avx2(u8* bytes) { return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i*)bytes))); }
+
+TARGET_AVX2 void score_board_batch_avx2(BoardBatchFeatures* features, BotWeights weights, int cleared_rows_offset, float* scores)
+{
+    auto offset = _mm256_set1_epi32(cleared_rows_offset);
+    auto lost_score = _mm256_set1_ps(LOST_GAME_SCORE);
+    for (auto i = 0; i < BOARD_BATCH_SIZE; i += 8)
+    {
+        auto full_rows = _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i*)&features->full_rows[i]));
+        auto cleared_rows = _mm256_cvtepi32_ps(_mm256_add_epi32(full_rows, offset));
+        auto score = _mm256_mul_ps(load_u8x8_as_float_avx2(&features->aggregate_height[i]), _mm256_set1_ps(weights.aggregate_height));
+        score = _mm256_add_ps(score, _mm256_mul_ps(load_u8x8_as_float_avx2(&features->holes[i]), _mm256_set1_ps(weights.holes)));
+        score = _mm256_add_ps(score, _mm256_mul_ps(load_u8x8_as_float_avx2(&features->bumpiness[i]), _mm256_set1_ps(weights.bumpiness)));
+        score = _mm256_add_ps(score, _mm256_mul_ps(cleared_rows, _mm256_set1_ps(weights.cleared_rows)));
+        score = _mm256_add_ps(score, _mm256_mul_ps(load_u8x8_as_float_avx2(&features->row_transitions[i]), _mm256_set1_ps(weights.row_transitions)));
+        auto lost = _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i*)&features->lost[i]));
+        auto lost_mask = _mm256_castsi256_ps(_mm256_cmpgt_epi32(lost, _mm256_setzero_si256()));
+        _mm256_storeu_ps(scores + i, _mm256_blendv_ps(score, lost_score, lost_mask));
+    }
+}
+
+#endif
+
+struct BoardBatchEvaluator
+{
+    MemoryPrimitivesLevel level;
+    void (*get_features)(BoardBatch* batch, BoardBatchFeatures* features);
+    void (*score)(BoardBatchFeatures* features, BotWeights weights, int cleared_rows_offset, float* scores);
+};
+
+BoardBatchEvaluator make_board_batch_evaluator(MemoryPrimitivesLevel level)
+{
+    BoardBatchEvaluator result;
+    result.level = MemoryPrimitivesLevelPortable;
+    result.get_features = get_board_batch_features_portable;
+    result.score = score_board_batch_portable;
+#ifdef MEMORY_PRIMITIVES_X86
+    if (level == MemoryPrimitivesLevelSSE2)
+    {
+        result.level = level;
+        result.get_features = get_board_batch_features_sse2;
+        result.score = score_board_batch_sse2;
+    }
+    else if (level == MemoryPrimitivesLevelAVX2)
+    {
+        result.level = level;
+        result.get_features = get_board_batch_features_avx2;
+        result.score = score_board_batch_avx2;
+    }
+#endif
+    return result;
+}
+
+BoardBatchEvaluator g_board_batch_evaluator = make_board_batch_evaluator(MemoryPrimitivesLevelPortable);
+
+// picks the same instruction set as the memory primitives
+void initialize_board_batch_evaluator() { g_board_batch_evaluator = make_board_batch_evaluator(get_best_memory_primitives_level()); }
+
+// scores[i] for candidate i, cleared rows counting cleared_rows_offset plus the candidate's own full rows
+void evaluate_board_batch(BoardBatchEvaluator evaluator, BoardBatch* batch, BotWeights weights, int cleared_rows_offset, float* scores)
+{
+    BoardBatchFeatures features;
+    evaluator.get_features(batch, &features);
+    evaluator.score(&features, weights, cleared_rows_offset, scores);
+}
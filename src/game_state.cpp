@@ -3,26 +3,18 @@
 #define FALLING_SHAPE_PERIOD_MS 500
 #define QUICK_FALL_PERIOD_MS 50
 #define MINIMUM_BOARD_COLOR_PERIOD 1
-#define CELL_MAP_PITCH 20
+// shapes are at most 3 cells wide in any orientation, so the board is the widest map; nothing may write outside a map's
+// width and height (the bomb clips its border to the board), since with this pitch a column past the edge is a cell
+// of the next row
+#define CELL_MAP_PITCH BOARD_WIDTH
 
 char* HIGH_SCORE_FILE_NAME = "game_data.txt";
 
 int load_high_score()
 {
-    auto file_handle = CreateFileA(
-        HIGH_SCORE_FILE_NAME,
-        GENERIC_READ,
-        FILE_SHARE_READ,
-        NULL,
-        OPEN_ALWAYS,
-        FILE_ATTRIBUTE_NORMAL,
-        NULL
-    );
-    assert(file_handle != INVALID_HANDLE_VALUE);
     char buffer[20];
-    DWORD bytes_read;
-    ReadFile(file_handle, buffer, countof(buffer), &bytes_read, NULL);
-    CloseHandle(file_handle);
+    auto bytes_read = platform_read_file(HIGH_SCORE_FILE_NAME, buffer, countof(buffer));
+    if (bytes_read < 0) { return 0; }
     auto parsed = string_to_int(make_string((u64)bytes_read, buffer));
     if (!parsed.success) { return 0; }
     return parsed.value;
@@ -30,26 +22,17 @@ int load_high_score()
 
 void save_high_score(int value)
 {
-    auto file_handle = CreateFileA(
-        HIGH_SCORE_FILE_NAME,
-        GENERIC_WRITE,
-        FILE_SHARE_READ,
-        NULL,
-        OPEN_ALWAYS,
-        FILE_ATTRIBUTE_NORMAL,
-        NULL
-    );
     char buffer_data[20];
     auto buffer = make_string(0, buffer_data);
     int_to_string(value, &buffer);
-    WriteFile(file_handle, buffer.data, buffer.size, NULL, NULL);
-    CloseHandle(file_handle);
+    if (!platform_write_file(HIGH_SCORE_FILE_NAME, buffer.data, buffer.size))
+    { log_warning("Failed to save high score: ", value); }
 }
 
 struct CellMap
 {
     int width, height;
-    bool data[CELL_MAP_PITCH * CELL_MAP_PITCH];
+    bool data[CELL_MAP_PITCH * BOARD_HEIGHT];
 };
 
 CellMap make_cell_map(int width, int height)
@@ -95,16 +78,101 @@ void mirror(CellMap* cell_map)
     }
 }
 
-struct FallingShape
+// compares only the cells inside the maps, the rest of the data can hold leftovers (see the fill cell power up)
+bool cell_maps_equal(CellMap left, CellMap right)
 {
-    CellMap cell_map;
-    int x, y;
+    if (left.width != right.width || left.height != right.height) { return false; }
+    for (auto y = 0; y < left.height; y++)
+    {
+        for (auto x = 0; x < left.width; x++)
+        {
+            if (get_cell(x, y, left) != get_cell(x, y, right)) { return false; }
+        }
+    }
+    return true;
+}
+
+u32 pack_cell_map_row(int y, CellMap cell_map)
+{
+    u32 result = 0;
+    for (auto x = 0; x < cell_map.width; x++) { result |= (u32)get_cell(x, y, cell_map) << x; }
+    return result;
+}
+
+// one bit per cell: bit x of rows[y] is the cell at (x, y)
+struct PackedBoard
+{
+    u32 rows[BOARD_HEIGHT];
 };
 
-struct FallingShapeSavedState
+PackedBoard pack_board(CellMap board)
+{
+    PackedBoard result;
+    for (auto y = 0; y < BOARD_HEIGHT; y++) { result.rows[y] = pack_cell_map_row(y, board); }
+    return result;
+}
+
+// Zobrist hashing, one key per (row, packed row contents) rather than per cell, so cementing a shape or shifting a row
+// costs one xor pair per row. Empty rows have key 0 and never need updating.
+#define MAX_ZOBRIST_SHAPE_SIZE 4
+#define MAX_POWER_UP_COUNT 10
+
+u64 ZOBRIST_ROW_KEYS[BOARD_HEIGHT][1 << BOARD_WIDTH];
+u64 ZOBRIST_SHAPE_CELL_KEYS[MAX_ZOBRIST_SHAPE_SIZE][MAX_ZOBRIST_SHAPE_SIZE];
+u64 ZOBRIST_MIRROR_KEYS[MAX_POWER_UP_COUNT + 1];
+u64 ZOBRIST_SCORE_PHASE_KEYS[3];
+
+// splitmix64, fixed seed so hashes are the same on every run
+u64 get_next_zobrist_key(u64* seed)
+{
+    auto z = (*seed += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+void initialize_zobrist_keys()
+{
+    u64 seed = 0x7e7715;
+    for (auto y = 0; y < BOARD_HEIGHT; y++)
+    {
+        ZOBRIST_ROW_KEYS[y][0] = 0;
+        for (auto bits = 1; bits < countof(ZOBRIST_ROW_KEYS[y]); bits++) { ZOBRIST_ROW_KEYS[y][bits] = get_next_zobrist_key(&seed); }
+    }
+    for (auto y = 0; y < MAX_ZOBRIST_SHAPE_SIZE; y++)
+    {
+        for (auto x = 0; x < MAX_ZOBRIST_SHAPE_SIZE; x++) { ZOBRIST_SHAPE_CELL_KEYS[y][x] = get_next_zobrist_key(&seed); }
+    }
+    for (auto i = 0; i < countof(ZOBRIST_MIRROR_KEYS); i++) { ZOBRIST_MIRROR_KEYS[i] = get_next_zobrist_key(&seed); }
+    for (auto i = 0; i < countof(ZOBRIST_SCORE_PHASE_KEYS); i++) { ZOBRIST_SCORE_PHASE_KEYS[i] = get_next_zobrist_key(&seed); }
+}
+
+u64 hash_board(CellMap board)
+{
+    u64 result = 0;
+    for (auto y = 0; y < BOARD_HEIGHT; y++) { result ^= ZOBRIST_ROW_KEYS[y][pack_cell_map_row(y, board)]; }
+    return result;
+}
+
+// shape cells relative to the shape's corner, so every orientation hashes differently
+u64 hash_shape(CellMap shape)
+{
+    assert(shape.width <= MAX_ZOBRIST_SHAPE_SIZE && shape.height <= MAX_ZOBRIST_SHAPE_SIZE);
+    u64 result = 0;
+    for (auto y = 0; y < shape.height; y++)
+    {
+        for (auto x = 0; x < shape.width; x++)
+        {
+            if (get_cell(x, y, shape)) { result ^= ZOBRIST_SHAPE_CELL_KEYS[y][x]; }
+        }
+    }
+    return result;
+}
+
+struct FallingShape
 {
-    int x, y;
     CellMap cell_map;
+    int x, y;
 };
 
 enum GameMode
@@ -129,21 +197,25 @@ struct GameInput
     bool four;
 };
 
-int g_starting_board_color_period;
-
 struct GameState
 {
     u32 time;
     GameMode mode;
     CellMap board;
+    u64 board_hash; // hash_board(board), kept up to date as the board changes
     FallingShape falling_shape;
-    int falling_shape_saved_states_size;
-    FallingShapeSavedState falling_shape_saved_states[4];
     bool quick_fall_mode;
+    u32 shapes_spawned;
+    u32 shapes_locked;
+    FallingShape locked_shape; // where the last shape was cemented
     int score;
     int high_score;
     Pixel board_color;
     bool board_color_going_negative;
+    int starting_board_color_period;
+    // the windowed player's game, as opposed to bot and simulation games: saves the high score and logs
+    bool is_interactive;
+    RandomNumberGenerator random;
     struct
     {
         s32 shape_fall;
@@ -156,11 +228,6 @@ struct GameState
         s32 invert_board;
         s32 bomb;
     } power_ups;
-    struct
-    {
-        TTF_Font* font16;
-        TTF_Font* font32;
-    } resources;
 };
 
 GameState g_game_state;
@@ -213,87 +280,86 @@ void initialize_shape_cell_maps()
     )
 }
 
-void save_falling_shape_state()
-{
-    assert(g_game_state.falling_shape_saved_states_size != countof(g_game_state.falling_shape_saved_states));
-    auto i = g_game_state.falling_shape_saved_states_size;
-    g_game_state.falling_shape_saved_states[i].x = g_game_state.falling_shape.x;
-    g_game_state.falling_shape_saved_states[i].y = g_game_state.falling_shape.y;
-    g_game_state.falling_shape_saved_states[i].cell_map = g_game_state.falling_shape.cell_map;
-    g_game_state.falling_shape_saved_states_size++;
-}
-
-void discard_falling_shape_state()
-{
-    assert(g_game_state.falling_shape_saved_states_size != 0);
-    g_game_state.falling_shape_saved_states_size--;
-}
-
-void restore_falling_shape_state()
-{
-    assert(g_game_state.falling_shape_saved_states_size != 0);
-    auto i = g_game_state.falling_shape_saved_states_size - 1;
-    g_game_state.falling_shape.x = g_game_state.falling_shape_saved_states[i].x;
-    g_game_state.falling_shape.y = g_game_state.falling_shape_saved_states[i].y;
-    g_game_state.falling_shape.cell_map = g_game_state.falling_shape_saved_states[i].cell_map;
-    g_game_state.falling_shape_saved_states_size--;
-}
-
-void cement_falling_shape()
+void cement_falling_shape(GameState* state)
 {
-    auto cell_map = g_game_state.falling_shape.cell_map;
+    auto cell_map = state->falling_shape.cell_map;
 
     for (auto y = 0; y < cell_map.height; y++)
     {
+        auto board_y = y + state->falling_shape.y;
+        auto old_row = pack_cell_map_row(board_y, state->board);
         for (auto x = 0; x < cell_map.width; x++)
         {
             if (get_cell(x, y, cell_map))
             {
-                set_cell(x + g_game_state.falling_shape.x, y + g_game_state.falling_shape.y, true, &g_game_state.board);
+                set_cell(x + state->falling_shape.x, board_y, true, &state->board);
             }
         }
+        auto new_row = old_row | (pack_cell_map_row(y, cell_map) << state->falling_shape.x);
+        state->board_hash ^= ZOBRIST_ROW_KEYS[board_y][old_row] ^ ZOBRIST_ROW_KEYS[board_y][new_row];
     }
 }
 
-void generate_new_falling_shape()
+void spawn_falling_shape(CellMap cell_map, GameState* state)
 {
-    g_game_state.falling_shape.cell_map = *ALL_SHAPES[get_random_number_in_range(0, countof(ALL_SHAPES))];
-    g_game_state.falling_shape.x = 3;
-    g_game_state.falling_shape.y = 0;
-    g_game_state.timers.shape_fall = 0;
-    g_game_state.quick_fall_mode = false;
+    state->falling_shape.cell_map = cell_map;
+    state->falling_shape.x = 3;
+    state->falling_shape.y = 0;
+    state->timers.shape_fall = 0;
+    state->quick_fall_mode = false;
+    state->shapes_spawned++;
 }
 
-void check_for_game_over()
+// index into ALL_SHAPES of a shape as spawned; countof(ALL_SHAPES) for anything else, like the fill cell power up's cell
+int get_shape_index(CellMap cell_map)
 {
-    for (auto x = 0; x < g_game_state.board.width; x++)
+    for (auto i = 0; i < countof(ALL_SHAPES); i++)
     {
-        if (get_cell(x, 0, g_game_state.board))
+        if (cell_maps_equal(*ALL_SHAPES[i], cell_map)) { return i; }
+    }
+    return countof(ALL_SHAPES);
+}
+
+void generate_new_falling_shape(GameState* state)
+{
+    spawn_falling_shape(*ALL_SHAPES[get_random_number_in_range(0, countof(ALL_SHAPES), &state->random)], state);
+}
+
+void check_for_game_over(GameState* state)
+{
+    for (auto x = 0; x < state->board.width; x++)
+    {
+        if (get_cell(x, 0, state->board))
         {
-            g_game_state.mode = GameModeLost;
+            state->mode = GameModeLost;
+            if (state->is_interactive) { log_info("Game over, score: ", state->score); }
             break;
         }
     }
 }
 
-void shift_everything_down(int until_y)
+void shift_everything_down(int until_y, GameState* state)
 {
+    auto overwritten_row = pack_cell_map_row(until_y, state->board);
     for (auto y = until_y - 1; y >= 0; y--)
     {
-        for (auto x = 0; x < g_game_state.board.width; x++)
-        { set_cell(x, y + 1, get_cell(x, y, g_game_state.board), &g_game_state.board); }
+        auto moved_row = pack_cell_map_row(y, state->board);
+        state->board_hash ^= ZOBRIST_ROW_KEYS[y + 1][overwritten_row] ^ ZOBRIST_ROW_KEYS[y + 1][moved_row];
+        overwritten_row = moved_row;
+        auto row = state->board.data + y * CELL_MAP_PITCH;
+        copy_memory(state->board.width * sizeof(bool), row, row + CELL_MAP_PITCH);
     }
 }
 
-void clear_solid_rows()
+void clear_solid_rows(GameState* state)
 {
     // starting from 1, because if the top row is filled, it's game over
-    for (auto y = 1; y < g_game_state.board.height; y++)
+    for (auto y = 1; y < state->board.height; y++)
     {
         auto gaps = false;
-        for (auto x = 0; x < g_game_state.board.width; x++)
+        for (auto x = 0; x < state->board.width; x++)
         {
-            if (!get_cell(x, y, g_game_state.board))
+            if (!get_cell(x, y, state->board))
             {
                 gaps = true;
                 break;
@@ -301,112 +367,197 @@ void clear_solid_rows()
         }
         if (!gaps)
         {
-            for (auto x = 0; x < g_game_state.board.width; x++)
-            { set_cell(x, y, false, &g_game_state.board); }
-            shift_everything_down(y);
-            g_game_state.score++;
+            state->board_hash ^= ZOBRIST_ROW_KEYS[y][pack_cell_map_row(y, state->board)];
+            set_memory(false, state->board.width * sizeof(bool), state->board.data + y * CELL_MAP_PITCH);
+            shift_everything_down(y, state);
+            state->score++;
 
-            if (g_game_state.score > g_game_state.high_score)
+            if (state->score > state->high_score)
             {
-                g_game_state.high_score = g_game_state.score;
-                save_high_score(g_game_state.score);
+                state->high_score = state->score;
+                if (state->is_interactive) { save_high_score(state->score); }
             }
 
-            switch (g_game_state.score % 3)
+            switch (state->score % 3)
             {
-                case 1: g_game_state.power_ups.mirror = MIN(10, g_game_state.power_ups.mirror + 1); break;
-                case 2: g_game_state.power_ups.fill_cell = MIN(10, g_game_state.power_ups.fill_cell + 1); break;
-                case 0: g_game_state.power_ups.bomb = MIN(10, g_game_state.power_ups.bomb + 1); break;
+                case 1: state->power_ups.mirror = MIN(MAX_POWER_UP_COUNT, state->power_ups.mirror + 1); break;
+                case 2: state->power_ups.fill_cell = MIN(MAX_POWER_UP_COUNT, state->power_ups.fill_cell + 1); break;
+                case 0: state->power_ups.bomb = MIN(MAX_POWER_UP_COUNT, state->power_ups.bomb + 1); break;
             }
 
-            if (g_game_state.score % 5 == 0) { g_game_state.power_ups.invert_board++; }
+            if (state->score % 5 == 0) { state->power_ups.invert_board++; }
         }
     }
 }
 
-bool does_falling_shape_conflict_with_board()
+bool does_falling_shape_conflict_with_board(GameState* state);
+
+// versus garbage: pushes the board up by count rows, each new bottom row full but for a hole at hole_x; the game is
+// lost if that pushes cells off the top or into the falling shape
+void add_garbage_rows(int count, int hole_x, GameState* state)
 {
-    if (g_game_state.falling_shape.x < 0 || g_game_state.falling_shape.x + g_game_state.falling_shape.cell_map.width > g_game_state.board.width
-        || g_game_state.falling_shape.y + g_game_state.falling_shape.cell_map.height > g_game_state.board.height)
+    count = MIN(count, BOARD_HEIGHT);
+    auto overflowed = false;
+    for (auto y = 0; y < count; y++) { overflowed |= pack_cell_map_row(y, state->board) != 0; }
+    for (auto y = 0; y < BOARD_HEIGHT - count; y++)
+    {
+        copy_memory(state->board.width * sizeof(bool), state->board.data + (y + count) * CELL_MAP_PITCH, state->board.data + y * CELL_MAP_PITCH);
+    }
+    for (auto y = BOARD_HEIGHT - count; y < BOARD_HEIGHT; y++)
+    {
+        for (auto x = 0; x < BOARD_WIDTH; x++) { set_cell(x, y, x != hole_x, &state->board); }
+    }
+    state->board_hash = hash_board(state->board);
+    if (overflowed || does_falling_shape_conflict_with_board(state)) { state->mode = GameModeLost; }
+    else { check_for_game_over(state); }
+}
+
+bool does_falling_shape_conflict_with_board(GameState* state)
+{
+    if (state->falling_shape.x < 0 || state->falling_shape.x + state->falling_shape.cell_map.width > state->board.width
+        || state->falling_shape.y + state->falling_shape.cell_map.height > state->board.height)
     { return true; }
-    for (auto shape_y = 0; shape_y < g_game_state.falling_shape.cell_map.height; shape_y++)
+    for (auto shape_y = 0; shape_y < state->falling_shape.cell_map.height; shape_y++)
     {
-        for (auto shape_x = 0; shape_x < g_game_state.falling_shape.cell_map.width; shape_x++)
+        for (auto shape_x = 0; shape_x < state->falling_shape.cell_map.width; shape_x++)
         {
-            if (get_cell(shape_x, shape_y, g_game_state.falling_shape.cell_map)
-                && get_cell(g_game_state.falling_shape.x + shape_x, g_game_state.falling_shape.y + shape_y, g_game_state.board))
+            if (get_cell(shape_x, shape_y, state->falling_shape.cell_map)
+                && get_cell(state->falling_shape.x + shape_x, state->falling_shape.y + shape_y, state->board))
             { return true; }
         }
     }
     return false;
 }
 
-void generate_initial_board_layout()
+void generate_initial_board_layout(GameState* state)
 {
-    auto hole1 = get_random_number_in_range(0, BOARD_WIDTH);
-    auto hole2 = get_random_number_in_range(0, BOARD_WIDTH);
+    auto hole1 = get_random_number_in_range(0, BOARD_WIDTH, &state->random);
+    auto hole2 = get_random_number_in_range(0, BOARD_WIDTH, &state->random);
     for (auto y = 0; y < BOARD_HEIGHT; y++)
     {
         for (auto x = 0; x < BOARD_WIDTH; x++)
         {
-            if (y < BOARD_HEIGHT - 2) { set_cell(x, y, false, &g_game_state.board); }
+            if (y < BOARD_HEIGHT - 2) { set_cell(x, y, false, &state->board); }
             else if (y == BOARD_HEIGHT - 2)
-            { set_cell(x, y, x != hole1, &g_game_state.board); }
-            else { set_cell(x, y, x != hole2, &g_game_state.board); }
+            { set_cell(x, y, x != hole1, &state->board); }
+            else { set_cell(x, y, x != hole2, &state->board); }
         }
     }
+    state->board_hash = hash_board(state->board);
+}
+
+// the shape has landed: make it part of the board and move on to the next one
+void lock_falling_shape(GameState* state)
+{
+    state->locked_shape = state->falling_shape;
+    state->shapes_locked++;
+    cement_falling_shape(state);
+    clear_solid_rows(state);
+    generate_new_falling_shape(state);
+    check_for_game_over(state);
+}
+
+// everything that decides which placements a freshly spawned shape has and where they lead: the board, the shape in its
+// current orientation, mirror power ups left, and the score modulo 3, which picks the power up the next cleared row gives
+u64 get_position_hash(GameState* state)
+{
+    return state->board_hash ^ hash_shape(state->falling_shape.cell_map)
+        ^ ZOBRIST_MIRROR_KEYS[MIN(MAX(state->power_ups.mirror, 0), MAX_POWER_UP_COUNT)]
+        ^ ZOBRIST_SCORE_PHASE_KEYS[state->score % 3];
+}
 
+// folds one more word into a running hash, with the splitmix64 finalizer so neighbouring values land far apart
+u64 mix_hash(u64 hash, u64 word)
+{
+    auto seed = hash ^ word;
+    return get_next_zobrist_key(&seed);
 }
 
+// A checksum of everything process_input reads and writes, so two games with the same checksum go on the same way. The
+// board is already hashed incrementally, so this is a dozen words however full the board is. The time, the high score
+// and is_interactive belong to the window and are left out.
+u64 hash_game_state(GameState* state)
+{
+    u64 words[] =
+    {
+        (u64)state->mode | (u64)state->quick_fall_mode << 8 | (u64)state->board_color_going_negative << 16,
+        (u64)(u32)state->falling_shape.x | (u64)(u32)state->falling_shape.y << 32,
+        hash_shape(state->falling_shape.cell_map),
+        (u64)(u32)state->locked_shape.x | (u64)(u32)state->locked_shape.y << 32,
+        hash_shape(state->locked_shape.cell_map),
+        (u64)state->shapes_spawned | (u64)state->shapes_locked << 32,
+        (u64)(u32)state->score | (u64)state->board_color << 32,
+        (u64)(u32)state->starting_board_color_period,
+        (u64)state->random.previous,
+        (u64)(u32)state->timers.shape_fall | (u64)(u32)state->timers.board_color << 32,
+        (u64)(u32)state->power_ups.mirror | (u64)(u32)state->power_ups.fill_cell << 32,
+        (u64)(u32)state->power_ups.invert_board | (u64)(u32)state->power_ups.bomb << 32,
+    };
+    auto result = state->board_hash;
+    for (auto i = 0; i < countof(words); i++) { result = mix_hash(result, words[i]); }
+    return result;
+}
 
-void process_input(float dt, GameInput input)
+// leaves the high score at 0 and the game non-interactive, the windowed game sets both up afterwards
+void initialize_game_state(s32 seed, GameState* state)
 {
-    // initialize g_starting_board_color_period
-    if (g_starting_board_color_period == 0) { g_starting_board_color_period = MAX(200, g_game_state.high_score * 10); }
+    set_memory(0, sizeof(*state), state);
+    seed_random_number_generator(seed, &state->random);
+    state->board = make_cell_map(BOARD_WIDTH,BOARD_HEIGHT);
+    state->score = 0;
+    state->high_score = 0;
+    state->board_color = PURPLE;
+    state->board_color_going_negative = false;
+    state->power_ups.mirror = 1;
+    state->power_ups.fill_cell = 1;
+    state->power_ups.invert_board = 1;
+    state->power_ups.bomb = 1;
+    state->time = SDL_GetTicks();
+    generate_new_falling_shape(state);
+    generate_initial_board_layout(state);
+}
+
+void process_input(float dt, GameInput input, GameState* state)
+{
+    // initialize starting_board_color_period
+    if (state->starting_board_color_period == 0) { state->starting_board_color_period = MAX(200, state->high_score * 10); }
 
-    if (g_game_state.mode == GameModePlaying)
+    if (state->mode == GameModePlaying)
     {
-        if (input.escape) { g_game_state.mode = GameModePause; }
+        if (input.escape) { state->mode = GameModePause; }
         if (input.r)
         {
-            save_falling_shape_state();
-            rotate(&g_game_state.falling_shape.cell_map);
-            if (does_falling_shape_conflict_with_board())
+            auto saved = state->falling_shape;
+            rotate(&state->falling_shape.cell_map);
+            if (does_falling_shape_conflict_with_board(state))
             {
-                g_game_state.falling_shape.x -= MAX(0, g_game_state.falling_shape.x + g_game_state.falling_shape.cell_map.width - g_game_state.board.width);
-                if (does_falling_shape_conflict_with_board())
-                { restore_falling_shape_state(); }
-                else { discard_falling_shape_state(); }
+                state->falling_shape.x -= MAX(0, state->falling_shape.x + state->falling_shape.cell_map.width - state->board.width);
+                if (does_falling_shape_conflict_with_board(state)) { state->falling_shape = saved; }
             }
-            else { discard_falling_shape_state(); }
         }
         if (input.one)
         {
-            if (g_game_state.power_ups.mirror != 0)
+            if (state->power_ups.mirror != 0)
             {
-                save_falling_shape_state();
-                mirror(&g_game_state.falling_shape.cell_map);
-                if (!does_falling_shape_conflict_with_board())
-                {
-                    g_game_state.power_ups.mirror--;
-                    discard_falling_shape_state();
-                }
-                else { restore_falling_shape_state(); }
+                auto saved = state->falling_shape;
+                mirror(&state->falling_shape.cell_map);
+                if (!does_falling_shape_conflict_with_board(state)) { state->power_ups.mirror--; }
+                else { state->falling_shape = saved; }
             }
         }
         if (input.two)
         {
-            if (g_game_state.power_ups.fill_cell != 0)
+            if (state->power_ups.fill_cell != 0)
             {
-                g_game_state.falling_shape.cell_map.width = 1;
-                g_game_state.falling_shape.cell_map.height = 1;
-                g_game_state.falling_shape.cell_map.data[0] = 1;
-                g_game_state.power_ups.fill_cell--;
+                state->falling_shape.cell_map.width = 1;
+                state->falling_shape.cell_map.height = 1;
+                state->falling_shape.cell_map.data[0] = 1;
+                state->power_ups.fill_cell--;
             }
         }
         if (input.three)
         {
-            if (g_game_state.power_ups.invert_board != 0)
+            if (state->power_ups.invert_board != 0)
             {
                 auto y0 = 0;
                 for (auto y = 0; y < BOARD_HEIGHT; y++)
@@ -414,7 +565,7 @@ void process_input(float dt, GameInput input)
                     auto all_cells_blank = true;
                     for (auto x = 0; x < BOARD_WIDTH; x++)
                     {
-                        if (get_cell(x, y, g_game_state.board))
+                        if (get_cell(x, y, state->board))
                         {
                             all_cells_blank = false;
                             break;
@@ -431,91 +582,91 @@ void process_input(float dt, GameInput input)
                 {
                     for (auto x = 0; x < BOARD_WIDTH; x++)
                     {
-                        auto temp = get_cell(x, y, g_game_state.board);
-                        set_cell(x, y, get_cell(x, BOARD_HEIGHT - (y - y0) - 1, g_game_state.board), &g_game_state.board);
-                        set_cell(x, BOARD_HEIGHT - (y - y0) - 1, temp, &g_game_state.board);
+                        auto temp = get_cell(x, y, state->board);
+                        set_cell(x, y, get_cell(x, BOARD_HEIGHT - (y - y0) - 1, state->board), &state->board);
+                        set_cell(x, BOARD_HEIGHT - (y - y0) - 1, temp, &state->board);
                     }
                 }
-                g_game_state.power_ups.invert_board--;
+                state->board_hash = hash_board(state->board);
+                state->power_ups.invert_board--;
             }
         }
         if (input.four)
         {
-            if (g_game_state.power_ups.bomb != 0)
+            if (state->power_ups.bomb != 0)
             {
-                for (auto y = g_game_state.falling_shape.y - 1; y < g_game_state.falling_shape.y + g_game_state.falling_shape.cell_map.height + 1; y++)
+                // the shape and a one cell border around it, clipped to the board
+                auto shape = &state->falling_shape;
+                auto x0 = MAX(shape->x - 1, 0);
+                auto x1 = MIN(shape->x + shape->cell_map.width + 1, state->board.width);
+                auto y0 = MAX(shape->y - 1, 0);
+                auto y1 = MIN(shape->y + shape->cell_map.height + 1, state->board.height);
+                for (auto y = y0; y < y1; y++)
                 {
-                    for (auto x = g_game_state.falling_shape.x - 1; x < g_game_state.falling_shape.x + g_game_state.falling_shape.cell_map.width + 1; x++)
-                    { set_cell(x, y, false, &g_game_state.board); }
+                    for (auto x = x0; x < x1; x++) { set_cell(x, y, false, &state->board); }
                 }
-                generate_new_falling_shape();
-                g_game_state.power_ups.bomb--;
+                state->board_hash = hash_board(state->board);
+                generate_new_falling_shape(state);
+                state->power_ups.bomb--;
             }
         }
         if (input.left || input.right)
         {
-            save_falling_shape_state();
-            g_game_state.falling_shape.x += input.left ? -1 : 1;
-            if (does_falling_shape_conflict_with_board())
-            { restore_falling_shape_state(); }
-            else { discard_falling_shape_state(); }
+            auto saved_x = state->falling_shape.x;
+            state->falling_shape.x += input.left ? -1 : 1;
+            if (does_falling_shape_conflict_with_board(state)) { state->falling_shape.x = saved_x; }
         }
         // double checks here to prevent timer reset
-        if (input.down && !g_game_state.quick_fall_mode) { g_game_state.quick_fall_mode = true; g_game_state.timers.shape_fall = 0; }
-        if (input.up && g_game_state.quick_fall_mode) { g_game_state.quick_fall_mode = false; g_game_state.timers.shape_fall = 0; }
+        if (input.down && !state->quick_fall_mode) { state->quick_fall_mode = true; state->timers.shape_fall = 0; }
+        if (input.up && state->quick_fall_mode) { state->quick_fall_mode = false; state->timers.shape_fall = 0; }
     }
-    else if (g_game_state.mode == GameModeLost)
+    else if (state->mode == GameModeLost)
     {
         if (input.enter)
         {
-            g_game_state.mode = GameModePlaying;
-            generate_new_falling_shape();
-            g_game_state.timers.board_color = 0;
-            g_game_state.board_color = PURPLE;
-            g_game_state.board_color_going_negative = false;
-            g_game_state.score = 0;
-            generate_initial_board_layout();
+            state->mode = GameModePlaying;
+            generate_new_falling_shape(state);
+            state->timers.board_color = 0;
+            state->board_color = PURPLE;
+            state->board_color_going_negative = false;
+            state->score = 0;
+            generate_initial_board_layout(state);
         }
     }
     else
     {
-        if (input.escape) { g_game_state.mode = GameModePlaying; }
+        if (input.escape) { state->mode = GameModePlaying; }
     }
 
-    if (g_game_state.mode == GameModePlaying)
+    if (state->mode == GameModePlaying)
     {
-        g_game_state.timers.shape_fall += dt;
-        auto falling_shape_period = g_game_state.quick_fall_mode ? QUICK_FALL_PERIOD_MS : FALLING_SHAPE_PERIOD_MS;
-        if (g_game_state.timers.shape_fall >= falling_shape_period)
+        state->timers.shape_fall += dt;
+        auto falling_shape_period = state->quick_fall_mode ? QUICK_FALL_PERIOD_MS : FALLING_SHAPE_PERIOD_MS;
+        if (state->timers.shape_fall >= falling_shape_period)
         {
-            g_game_state.timers.shape_fall -= falling_shape_period;
-            save_falling_shape_state();
-            g_game_state.falling_shape.y++;
-            if (does_falling_shape_conflict_with_board())
+            state->timers.shape_fall -= falling_shape_period;
+            state->falling_shape.y++;
+            if (does_falling_shape_conflict_with_board(state))
             {
-                restore_falling_shape_state();
-                cement_falling_shape();
-                clear_solid_rows();
-                generate_new_falling_shape();
-                check_for_game_over();
+                state->falling_shape.y--;
+                lock_falling_shape(state);
             }
-            else { discard_falling_shape_state(); }
         }
     }
 
-    if (g_game_state.score != 0)
+    if (state->score != 0)
     {
-        g_game_state.timers.board_color += dt;
-        auto period = MAX(MINIMUM_BOARD_COLOR_PERIOD, g_starting_board_color_period - g_game_state.score * 10);
-        if (g_game_state.timers.board_color >= period)
+        state->timers.board_color += dt;
+        auto period = MAX(MINIMUM_BOARD_COLOR_PERIOD, state->starting_board_color_period - state->score * 10);
+        if (state->timers.board_color >= period)
         {
-            while (g_game_state.timers.board_color > 0)
+            while (state->timers.board_color > 0)
             {
-                g_game_state.timers.board_color -= period;
-                if ((g_game_state.board_color & 0xff) == 0xff) { g_game_state.board_color_going_negative = true; }
-                else if ((g_game_state.board_color & 0xff) == 0) { g_game_state.board_color_going_negative = false; }
-                auto channel = ((g_game_state.board_color & 0xff) + (g_game_state.board_color_going_negative ? -1 : 1)) % 0x100;
-                g_game_state.board_color = 0xff0000 | ((0xff - channel) << 8) | channel;
+                state->timers.board_color -= period;
+                if ((state->board_color & 0xff) == 0xff) { state->board_color_going_negative = true; }
+                else if ((state->board_color & 0xff) == 0) { state->board_color_going_negative = false; }
+                auto channel = ((state->board_color & 0xff) + (state->board_color_going_negative ? -1 : 1)) % 0x100;
+                state->board_color = 0xff0000 | ((0xff - channel) << 8) | channel;
             }
         }
     }
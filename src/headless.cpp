@@ -0,0 +1,463 @@
+// Command line modes that run without a window: frame dumps, golden image comparison and benchmarks.
+// Rendering here draws through the same draw_game as the windowed build, just into an owned bitmap.
+// --check-frames is the golden image regression check; scripts/check_golden_frames.sh runs it in CI against frames
+// dumped by a pinned baseline build, since the HUD text makes frames from another machine's SDL_ttf differ.
+
+#define GOLDEN_SEED 1234
+#define DEFAULT_RENDER_BENCHMARK_FRAMES 1000
+
+enum GoldenScreen
+{
+    GoldenScreenPlaying,
+    GoldenScreenPause,
+    GoldenScreenLost,
+};
+
+char* GOLDEN_SCREEN_NAMES[] = { "playing", "pause", "game_over" };
+
+Vector GOLDEN_FRAME_SIZES[] = { { 320, 240 }, { 500, 500 }, { 800, 600 }, { 1920, 1080 } };
+
+void initialize_headless()
+{
+    if (SDL_Init(SDL_INIT_TIMER) < 0) { panic_sdl("SDL_Init"); }
+    if (TTF_Init() < 0) { panic_sdl("TTF_Init"); }
+    initialize_shape_cell_maps();
+    load_resources();
+}
+
+// puts the game into a fixed state so that the same screen renders identically on every machine
+void prepare_golden_screen(GoldenScreen screen)
+{
+    initialize_game_state(GOLDEN_SEED, &g_game_state);
+    g_game_state.time = 0;
+    g_game_state.score = 3;
+    g_game_state.high_score = 12;
+    g_game_state.power_ups.mirror = 2;
+    g_game_state.power_ups.bomb = 4;
+    g_game_state.falling_shape.y = 6;
+    switch (screen)
+    {
+        case GoldenScreenPlaying: g_game_state.mode = GameModePlaying; break;
+        case GoldenScreenPause: g_game_state.mode = GameModePause; break;
+        case GoldenScreenLost: g_game_state.mode = GameModeLost; break;
+    }
+}
+
+void golden_frame_path(char* directory, GoldenScreen screen, Vector size, char* extension, String* result)
+{
+    push(directory, result);
+    push('/', result);
+    push(GOLDEN_SCREEN_NAMES[screen], result);
+    push('_', result);
+    int_to_string(size.x, result);
+    push('x', result);
+    int_to_string(size.y, result);
+    push(extension, result);
+    push('\0', result);
+}
+
+int dump_golden_frames(char* directory)
+{
+    auto failures = 0;
+    for (auto screen = 0; screen < countof(GOLDEN_SCREEN_NAMES); screen++)
+    {
+        for (auto size_index = 0; size_index < countof(GOLDEN_FRAME_SIZES); size_index++)
+        {
+            auto size = GOLDEN_FRAME_SIZES[size_index];
+            auto frame = allocate_bitmap(size.x, size.y);
+            prepare_golden_screen((GoldenScreen)screen);
+            draw_game(frame);
+
+            char path_data[512];
+            auto path = make_string(0, path_data);
+            golden_frame_path(directory, (GoldenScreen)screen, size, ".ppm", &path);
+            if (!save_bitmap_as_ppm(frame, path.data)) { print("Failed to write "); print(path.data); print("\n"); failures++; }
+            path.size = 0;
+            golden_frame_path(directory, (GoldenScreen)screen, size, ".bmp", &path);
+            if (!save_bitmap_as_bmp(frame, path.data)) { print("Failed to write "); print(path.data); print("\n"); failures++; }
+
+            free_bitmap(frame);
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+int check_golden_frames(char* directory)
+{
+    auto failures = 0;
+    for (auto screen = 0; screen < countof(GOLDEN_SCREEN_NAMES); screen++)
+    {
+        for (auto size_index = 0; size_index < countof(GOLDEN_FRAME_SIZES); size_index++)
+        {
+            auto size = GOLDEN_FRAME_SIZES[size_index];
+            char path_data[512];
+            auto path = make_string(0, path_data);
+            golden_frame_path(directory, (GoldenScreen)screen, size, ".ppm", &path);
+
+            auto frame = allocate_bitmap(size.x, size.y);
+            auto tiled_frame = allocate_bitmap(size.x, size.y);
+            prepare_golden_screen((GoldenScreen)screen);
+            draw_game(frame);
+            draw_game_tiled(tiled_frame);
+
+            auto expected = load_bitmap_from_ppm(path.data);
+            if (expected.data == NULL)
+            {
+                print("MISSING ");
+                print(path.data);
+                print("\n");
+                failures++;
+            }
+            else if (expected.width != frame.width || expected.height != frame.height)
+            {
+                print("SIZE MISMATCH ");
+                print(path.data);
+                print("\n");
+                failures++;
+            }
+            else
+            {
+                // the tiled renderer has to match the golden frame just as exactly
+                u64 mismatched_pixels = 0;
+                for (u64 i = 0; i < frame.width * frame.height; i++)
+                {
+                    mismatched_pixels += (frame.data[i] & 0xffffff) != expected.data[i];
+                    mismatched_pixels += (tiled_frame.data[i] & 0xffffff) != expected.data[i];
+                }
+                print(mismatched_pixels == 0 ? (char*)"OK " : (char*)"FAIL ");
+                print(path.data);
+                if (mismatched_pixels != 0)
+                {
+                    print(" (");
+                    print(mismatched_pixels);
+                    print(" pixels differ)");
+                    failures++;
+                }
+                print("\n");
+            }
+
+            if (expected.data != NULL) { free_bitmap(expected); }
+            free_bitmap(frame);
+            free_bitmap(tiled_frame);
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+int benchmark_rendering(int frame_count)
+{
+    reset_job_stats();
+    for (auto size_index = 0; size_index < countof(GOLDEN_FRAME_SIZES); size_index++)
+    {
+        auto size = GOLDEN_FRAME_SIZES[size_index];
+        auto frame = allocate_bitmap(size.x, size.y);
+        prepare_golden_screen(GoldenScreenPlaying);
+
+        auto start = get_monotonic_nanoseconds();
+        for (auto i = 0; i < frame_count; i++) { draw_game(frame); }
+        auto seconds = (float)(get_monotonic_nanoseconds() - start) / 1e9f;
+
+        start = get_monotonic_nanoseconds();
+        for (auto i = 0; i < frame_count; i++) { draw_game_tiled(frame); }
+        auto tiled_seconds = (float)(get_monotonic_nanoseconds() - start) / 1e9f;
+
+        print((s64)size.x);
+        print("x");
+        print((s64)size.y);
+        print(": ");
+        print((float)frame_count / seconds);
+        print(" frames/sec, tiled: ");
+        print((float)frame_count / tiled_seconds);
+        print(" frames/sec\n");
+        free_bitmap(frame);
+    }
+    print_job_stats();
+    return 0;
+}
+
+void print_headless_usage()
+{
+    print(
+        "usage:\n"
+        "  tetris --dump-frames <directory>     render the golden screens as PPM and BMP files\n"
+        "  tetris --check-frames <directory>    compare the golden screens against PPM files in directory\n"
+        "  tetris --bench-render [frames]       measure offscreen rendering throughput\n"
+        "  tetris --bench-memory                measure fill/copy/compare speed for each instruction set\n"
+        "  tetris --bench-eval [positions]      compare batch and per-board placement scoring speed and results\n"
+        "  tetris --bench-network <file> [positions]\n"
+        "                                       compare network scoring speed per core and results at each instruction set\n"
+        "  tetris --write-network <file> [seed] write a network file with small random weights\n"
+        "  tetris --bot [games] [max shapes] [seed]\n"
+        "                                       play bot games without a window and report placements/sec\n"
+        "  tetris --export-bot <directory> [games] [max shapes] [seed]\n"
+        "                                       play bot games and write every placement to training data shards\n"
+        "  tetris --tune <checkpoint file> [generations] [games per candidate] [max shapes] [seed]\n"
+        "                                       tune the bot's weights over headless games, resuming from the checkpoint\n"
+        "  tetris --estimate <snapshot file> [shapes] [max rollouts] [seed]\n"
+        "                                       estimate survival and rows cleared over the next shapes from a snapshot\n"
+        "  tetris --tournament <results prefix> [games] [max shapes] [seed] [roster file]\n"
+        "                                       play every bot on the same seeds, write ratings and paired comparisons\n"
+        "  tetris --search [games] [max shapes] [seed] [budget ms]\n"
+        "                                       play with lookahead search, report depth and nodes/sec per shape\n"
+        "  tetris --bench-env [environments] [steps]\n"
+        "                                       step games through the training API with random actions, report steps/sec\n"
+        "  tetris --bench-versus [ticks] [packet loss %] [input delay] [rollback ticks] [port]\n"
+        "                                       two bots play versus over loopback UDP, check both sides stay in step\n"
+        "  tetris --bench-rollback [ticks]      time state checksums and versus frames that roll back 1 to 16 ticks\n"
+        "  tetris --bench-server [sessions] [seconds] [port]\n"
+        "                                       serve simulated thin clients over loopback UDP, report tick latency\n"
+        "  tetris --server [port] [max sessions]\n"
+        "                                       host independent games for thin clients until killed\n"
+        "  tetris --bench-spectators [viewers] [seconds] [port]\n"
+        "                                       stream a bot's game to simulated viewers as XOR deltas, report cost per viewer\n"
+        "  tetris --broadcast [port] [max viewers]\n"
+        "                                       stream a bot's game to spectators until killed\n"
+        "  tetris --terminal [max shapes] [seed] [ticks per frame]\n"
+        "                                       watch the bot play in the terminal, drawn with ANSI escape sequences\n"
+        "  tetris --perft [depth]               count placement sequences from fixed positions against stored counts\n"
+        "window:\n"
+        "  tetris --versus <local port> <peer address> <peer port> [input delay] [rollback ticks]\n"
+        "                                       play against another instance in lockstep; input delay 0 tunes itself,\n"
+        "                                       rollback lets the game run that many ticks ahead of the other side\n"
+        "environment:\n"
+        "  TETRIS_JOB_WORKERS=<count>           threads in the job system, the main thread included (default: cores)\n"
+        "  TETRIS_PIN_THREADS=1                 pin each job worker to its own core\n"
+        "  TETRIS_EXPORT_DIRECTORY=<directory>  write the windowed game's placements to training data shards\n"
+        "  TETRIS_NETWORK=<file>                score the bot's placements with the network in file\n"
+    );
+}
+
+int run_headless_command(int argument_count, char** arguments)
+{
+    auto command = arguments[0];
+    if (c_string_equals(command, "--dump-frames") && argument_count == 2)
+    {
+        initialize_headless();
+        return dump_golden_frames(arguments[1]);
+    }
+    if (c_string_equals(command, "--check-frames") && argument_count == 2)
+    {
+        initialize_headless();
+        return check_golden_frames(arguments[1]);
+    }
+    if (c_string_equals(command, "--bench-render") && argument_count <= 2)
+    {
+        auto frame_count = DEFAULT_RENDER_BENCHMARK_FRAMES;
+        if (argument_count == 2)
+        {
+            auto parsed = string_to_int(make_string(c_string_length(arguments[1]), arguments[1]));
+            if (!parsed.success || parsed.value <= 0) { print_headless_usage(); return 1; }
+            frame_count = parsed.value;
+        }
+        initialize_headless();
+        return benchmark_rendering(frame_count);
+    }
+    if (c_string_equals(command, "--bench-memory") && argument_count == 1) { return benchmark_memory_primitives(); }
+    if (c_string_equals(command, "--bench-eval") && argument_count <= 2)
+    {
+        auto position_count = DEFAULT_EVALUATION_BENCHMARK_POSITIONS;
+        if (argument_count == 2)
+        {
+            auto parsed = string_to_int(make_string(c_string_length(arguments[1]), arguments[1]));
+            if (!parsed.success || parsed.value <= 0) { print_headless_usage(); return 1; }
+            position_count = parsed.value;
+        }
+        return benchmark_board_evaluation(position_count);
+    }
+    if (c_string_equals(command, "--bench-network") && argument_count >= 2 && argument_count <= 3)
+    {
+        auto position_count = DEFAULT_EVALUATION_BENCHMARK_POSITIONS;
+        if (argument_count == 3)
+        {
+            auto parsed = string_to_int(make_string(c_string_length(arguments[2]), arguments[2]));
+            if (!parsed.success || parsed.value <= 0) { print_headless_usage(); return 1; }
+            position_count = parsed.value;
+        }
+        return benchmark_board_network(arguments[1], position_count);
+    }
+    if (c_string_equals(command, "--write-network") && argument_count >= 2 && argument_count <= 3)
+    {
+        s32 seed = 1;
+        if (argument_count == 3)
+        {
+            auto parsed = string_to_int(make_string(c_string_length(arguments[2]), arguments[2]));
+            if (!parsed.success) { print_headless_usage(); return 1; }
+            seed = parsed.value;
+        }
+        return write_random_board_network(arguments[1], seed);
+    }
+    if (c_string_equals(command, "--bot") && argument_count <= 4)
+    {
+        int values[] = { 10, 10000, 1 };
+        for (auto i = 1; i < argument_count; i++)
+        {
+            auto parsed = string_to_int(make_string(c_string_length(arguments[i]), arguments[i]));
+            if (!parsed.success || (i < 3 && parsed.value <= 0)) { print_headless_usage(); return 1; }
+            values[i - 1] = parsed.value;
+        }
+        return run_bot_games(values[0], values[1], values[2], NULL);
+    }
+    if (c_string_equals(command, "--export-bot") && argument_count >= 2 && argument_count <= 5)
+    {
+        int values[] = { 10, 10000, 1 };
+        for (auto i = 2; i < argument_count; i++)
+        {
+            auto parsed = string_to_int(make_string(c_string_length(arguments[i]), arguments[i]));
+            if (!parsed.success || (i < 4 && parsed.value <= 0)) { print_headless_usage(); return 1; }
+            values[i - 2] = parsed.value;
+        }
+        return export_bot_games(arguments[1], values[0], values[1], values[2]);
+    }
+    if (c_string_equals(command, "--tune") && argument_count >= 2 && argument_count <= 6)
+    {
+        int values[] = { DEFAULT_TUNER_GENERATIONS, DEFAULT_TUNER_GAMES, DEFAULT_TUNER_MAX_SHAPES, 1 };
+        for (auto i = 2; i < argument_count; i++)
+        {
+            auto parsed = string_to_int(make_string(c_string_length(arguments[i]), arguments[i]));
+            if (!parsed.success || (i < 5 && parsed.value <= 0)) { print_headless_usage(); return 1; }
+            values[i - 2] = parsed.value;
+        }
+        return run_tuner(arguments[1], values[0], values[1], values[2], values[3]);
+    }
+    if (c_string_equals(command, "--estimate") && argument_count >= 2 && argument_count <= 5)
+    {
+        int values[] = { DEFAULT_ESTIMATOR_SHAPES, DEFAULT_ESTIMATOR_MAX_ROLLOUTS, 1 };
+        for (auto i = 2; i < argument_count; i++)
+        {
+            auto parsed = string_to_int(make_string(c_string_length(arguments[i]), arguments[i]));
+            if (!parsed.success || (i < 4 && parsed.value <= 0)) { print_headless_usage(); return 1; }
+            values[i - 2] = parsed.value;
+        }
+        return run_estimator(arguments[1], values[0], values[1], values[2]);
+    }
+    if (c_string_equals(command, "--tournament") && argument_count >= 2 && argument_count <= 6)
+    {
+        int values[] = { DEFAULT_TOURNAMENT_GAMES, DEFAULT_TOURNAMENT_MAX_SHAPES, 1 };
+        for (auto i = 2; i < MIN(argument_count, 5); i++)
+        {
+            auto parsed = string_to_int(make_string(c_string_length(arguments[i]), arguments[i]));
+            if (!parsed.success || (i < 4 && parsed.value <= 0)) { print_headless_usage(); return 1; }
+            values[i - 2] = parsed.value;
+        }
+        auto roster_file_name = argument_count == 6 ? arguments[5] : NULL;
+        return run_tournament(arguments[1], values[0], values[1], values[2], roster_file_name);
+    }
+    if (c_string_equals(command, "--search") && argument_count <= 5)
+    {
+        int values[] = { 1, 200, 1, DEFAULT_SEARCH_BUDGET_MS };
+        for (auto i = 1; i < argument_count; i++)
+        {
+            auto parsed = string_to_int(make_string(c_string_length(arguments[i]), arguments[i]));
+            if (!parsed.success || (i != 3 && parsed.value <= 0)) { print_headless_usage(); return 1; }
+            values[i - 1] = parsed.value;
+        }
+        return run_search_games(values[0], values[1], values[2], values[3]);
+    }
+    if (c_string_equals(command, "--bench-env") && argument_count <= 3)
+    {
+        int values[] = { DEFAULT_ENVIRONMENT_BENCHMARK_COUNT, DEFAULT_ENVIRONMENT_BENCHMARK_STEPS };
+        for (auto i = 1; i < argument_count; i++)
+        {
+            auto parsed = string_to_int(make_string(c_string_length(arguments[i]), arguments[i]));
+            if (!parsed.success || parsed.value <= 0) { print_headless_usage(); return 1; }
+            values[i - 1] = parsed.value;
+        }
+        return benchmark_environments(values[0], values[1]);
+    }
+    if (c_string_equals(command, "--bench-versus") && argument_count <= 6)
+    {
+        // packet loss, input delay and rollback can be 0, the delay then tunes itself
+        int values[] = { DEFAULT_VERSUS_BENCH_TICKS, 0, 0, 0, DEFAULT_VERSUS_PORT };
+        int limits[] = { 1 << 30, 99, VERSUS_MAX_INPUT_DELAY, VERSUS_MAX_ROLLBACK_TICKS, 65534 };
+        for (auto i = 1; i < argument_count; i++)
+        {
+            auto parsed = string_to_int(make_string(c_string_length(arguments[i]), arguments[i]));
+            if (!parsed.success || parsed.value < (i == 1 || i == 5) || parsed.value > limits[i - 1]) { print_headless_usage(); return 1; }
+            values[i - 1] = parsed.value;
+        }
+        return run_versus_benchmark(values[0], values[1], values[2], values[3], values[4]);
+    }
+    if (c_string_equals(command, "--bench-rollback") && argument_count <= 2)
+    {
+        auto ticks = DEFAULT_ROLLBACK_BENCH_TICKS;
+        if (argument_count == 2)
+        {
+            auto parsed = string_to_int(make_string(c_string_length(arguments[1]), arguments[1]));
+            if (!parsed.success || parsed.value <= 0) { print_headless_usage(); return 1; }
+            ticks = parsed.value;
+        }
+        return run_rollback_benchmark(ticks);
+    }
+    if (c_string_equals(command, "--bench-server") && argument_count <= 4)
+    {
+        int values[] = { DEFAULT_SERVER_BENCH_SESSIONS, DEFAULT_SERVER_BENCH_SECONDS, DEFAULT_SERVER_PORT };
+        int limits[] = { 1 << 20, 1 << 20, 65535 - SERVER_SIMULATOR_SOCKETS };
+        for (auto i = 1; i < argument_count; i++)
+        {
+            auto parsed = string_to_int(make_string(c_string_length(arguments[i]), arguments[i]));
+            if (!parsed.success || parsed.value <= 0 || parsed.value > limits[i - 1]) { print_headless_usage(); return 1; }
+            values[i - 1] = parsed.value;
+        }
+        return run_server_benchmark(values[0], values[1], values[2]);
+    }
+    if (c_string_equals(command, "--server") && argument_count <= 3)
+    {
+        int values[] = { DEFAULT_SERVER_PORT, DEFAULT_MAX_SERVER_SESSIONS };
+        int limits[] = { 65535, 1 << 24 };
+        for (auto i = 1; i < argument_count; i++)
+        {
+            auto parsed = string_to_int(make_string(c_string_length(arguments[i]), arguments[i]));
+            if (!parsed.success || parsed.value <= 0 || parsed.value > limits[i - 1]) { print_headless_usage(); return 1; }
+            values[i - 1] = parsed.value;
+        }
+        return run_server_command(values[0], values[1]);
+    }
+    if (c_string_equals(command, "--bench-spectators") && argument_count <= 4)
+    {
+        int values[] = { DEFAULT_SPECTATOR_BENCH_VIEWERS, DEFAULT_SPECTATOR_BENCH_SECONDS, DEFAULT_SPECTATOR_PORT };
+        int limits[] = { 1 << 20, 1 << 20, 65535 - SPECTATOR_SIMULATOR_SOCKETS };
+        for (auto i = 1; i < argument_count; i++)
+        {
+            auto parsed = string_to_int(make_string(c_string_length(arguments[i]), arguments[i]));
+            if (!parsed.success || parsed.value <= 0 || parsed.value > limits[i - 1]) { print_headless_usage(); return 1; }
+            values[i - 1] = parsed.value;
+        }
+        return run_spectator_benchmark(values[0], values[1], values[2]);
+    }
+    if (c_string_equals(command, "--broadcast") && argument_count <= 3)
+    {
+        int values[] = { DEFAULT_SPECTATOR_PORT, DEFAULT_MAX_SPECTATORS };
+        int limits[] = { 65535, 1 << 24 };
+        for (auto i = 1; i < argument_count; i++)
+        {
+            auto parsed = string_to_int(make_string(c_string_length(arguments[i]), arguments[i]));
+            if (!parsed.success || parsed.value <= 0 || parsed.value > limits[i - 1]) { print_headless_usage(); return 1; }
+            values[i - 1] = parsed.value;
+        }
+        return run_spectator_command(values[0], values[1]);
+    }
+    if (c_string_equals(command, "--terminal") && argument_count <= 4)
+    {
+        int values[] = { DEFAULT_TERMINAL_MAX_SHAPES, 1, 1 };
+        for (auto i = 1; i < argument_count; i++)
+        {
+            auto parsed = string_to_int(make_string(c_string_length(arguments[i]), arguments[i]));
+            if (!parsed.success || (i != 2 && parsed.value <= 0)) { print_headless_usage(); return 1; }
+            values[i - 1] = parsed.value;
+        }
+        return run_terminal_game(values[0], values[1], values[2]);
+    }
+    if (c_string_equals(command, "--perft") && argument_count <= 2)
+    {
+        auto depth = DEFAULT_PERFT_DEPTH;
+        if (argument_count == 2)
+        {
+            auto parsed = string_to_int(make_string(c_string_length(arguments[1]), arguments[1]));
+            if (!parsed.success || parsed.value <= 0) { print_headless_usage(); return 1; }
+            depth = parsed.value;
+        }
+        return run_perft(depth);
+    }
+    print_headless_usage();
+    return 1;
+}
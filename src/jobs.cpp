@@ -0,0 +1,321 @@
+// Work-stealing job system. Every worker thread, and the main thread as worker 0, owns a deque of jobs: the owner
+// pushes and pops at the bottom, idle workers steal from the top of a random victim (Chase-Lev). Waiting on a job group
+// runs other jobs instead of blocking, so jobs can submit and wait on jobs of their own.
+// A parallel-for is one job over the whole range, which keeps splitting off its upper half for others to steal until
+// what is left is a single batch.
+
+#define MAX_JOB_WORKERS 64
+#define JOB_DEQUE_CAPACITY 1024 // must be a power of two
+#define JOB_SPIN_ROUNDS 64 // failed rounds of stealing before an idle worker goes to sleep
+#define JOB_IDLE_SLEEP_MS 1
+
+typedef void (*JobFunction)(void* data, int begin, int end);
+
+struct JobGroup
+{
+    SDL_atomic_t pending;
+};
+
+struct Job
+{
+    JobFunction function;
+    void* data;
+    int begin, end;
+    int batch_size;
+    JobGroup* group;
+};
+
+// written only by the owning worker; read for reports while the system is idle
+struct JobWorkerStats
+{
+    u64 jobs;
+    u64 steals;
+    u64 failed_steals;
+    u64 busy_nanoseconds;
+};
+
+struct JobWorker
+{
+    int index;
+    SDL_Thread* thread;
+    SDL_atomic_t top; // advanced by thieves and by the owner taking the last job
+    SDL_atomic_t bottom; // moved only by the owner
+    Job jobs[JOB_DEQUE_CAPACITY];
+    RandomNumberGenerator random;
+    int nesting; // jobs run from inside a wait_for_jobs count as busy time only once
+    JobWorkerStats stats;
+};
+
+struct JobSystem
+{
+    int worker_count;
+    bool pin_threads;
+    SDL_atomic_t running;
+    SDL_atomic_t sleeping;
+    SDL_sem* wake;
+    u64 stats_start_time;
+    JobWorker* workers;
+};
+
+JobSystem g_jobs;
+
+thread_local JobWorker* t_job_worker;
+
+JobGroup make_job_group()
+{
+    JobGroup result;
+    SDL_AtomicSet(&result.pending, 0);
+    return result;
+}
+
+// index into per-worker scratch memory; 0 on threads outside the job system
+int get_job_worker_index() { return t_job_worker != NULL ? t_job_worker->index : 0; }
+
+int get_job_worker_count() { return MAX(1, g_jobs.worker_count); }
+
+bool push_job(JobWorker* worker, Job job)
+{
+    auto bottom = (u32)SDL_AtomicGet(&worker->bottom);
+    auto top = (u32)SDL_AtomicGet(&worker->top);
+    if (bottom - top >= JOB_DEQUE_CAPACITY) { return false; }
+    worker->jobs[bottom % JOB_DEQUE_CAPACITY] = job;
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&worker->bottom, (int)(bottom + 1));
+    return true;
+}
+
+bool pop_job(JobWorker* worker, Job* job)
+{
+    // the add is a full barrier, so thieves see the smaller bottom before we look at top
+    auto bottom = (u32)SDL_AtomicAdd(&worker->bottom, -1) - 1;
+    auto top = (u32)SDL_AtomicGet(&worker->top);
+    auto remaining = (s32)(bottom - top);
+    if (remaining < 0)
+    {
+        SDL_AtomicSet(&worker->bottom, (int)top);
+        return false;
+    }
+    *job = worker->jobs[bottom % JOB_DEQUE_CAPACITY];
+    if (remaining > 0) { return true; }
+
+    // the last job: thieves may be going for it too
+    auto won = SDL_AtomicCAS(&worker->top, (int)top, (int)(top + 1));
+    SDL_AtomicSet(&worker->bottom, (int)(top + 1));
+    return won == SDL_TRUE;
+}
+
+// a job read while the owner overwrites its slot is thrown away, since the owner only does that after top moved on
+bool steal_job(JobWorker* victim, Job* job)
+{
+    auto top = (u32)SDL_AtomicGet(&victim->top);
+    auto bottom = (u32)SDL_AtomicGet(&victim->bottom);
+    if ((s32)(bottom - top) <= 0) { return false; }
+    *job = victim->jobs[top % JOB_DEQUE_CAPACITY];
+    return SDL_AtomicCAS(&victim->top, (int)top, (int)(top + 1)) == SDL_TRUE;
+}
+
+void wake_job_workers()
+{
+    if (SDL_AtomicGet(&g_jobs.sleeping) > 0) { SDL_SemPost(g_jobs.wake); }
+}
+
+void execute_job(JobWorker* worker, Job job)
+{
+    auto start = get_monotonic_nanoseconds();
+    worker->nesting++;
+    while (job.end - job.begin > job.batch_size)
+    {
+        auto middle = job.begin + (job.end - job.begin) / 2;
+        auto upper = job;
+        upper.begin = middle;
+        SDL_AtomicIncRef(&job.group->pending);
+        if (!push_job(worker, upper))
+        {
+            // deque full: run the rest right here
+            SDL_AtomicAdd(&job.group->pending, -1);
+            break;
+        }
+        wake_job_workers();
+        job.end = middle;
+    }
+    job.function(job.data, job.begin, job.end);
+    // the waiter may return as soon as this drops to zero, so the group is not touched after it
+    SDL_AtomicAdd(&job.group->pending, -1);
+    worker->nesting--;
+    worker->stats.jobs++;
+    if (worker->nesting == 0) { worker->stats.busy_nanoseconds += get_monotonic_nanoseconds() - start; }
+}
+
+bool run_one_job(JobWorker* worker)
+{
+    Job job;
+    if (pop_job(worker, &job))
+    {
+        execute_job(worker, job);
+        return true;
+    }
+    auto first_victim = get_random_number_in_range(0, g_jobs.worker_count, &worker->random);
+    for (auto i = 0; i < g_jobs.worker_count; i++)
+    {
+        auto victim = &g_jobs.workers[(first_victim + i) % g_jobs.worker_count];
+        if (victim == worker) { continue; }
+        if (steal_job(victim, &job))
+        {
+            worker->stats.steals++;
+            execute_job(worker, job);
+            return true;
+        }
+        worker->stats.failed_steals++;
+    }
+    return false;
+}
+
+// runs function(data, begin, end) over pieces of [0, count) no smaller than batch_size, unless count itself is smaller
+void submit_jobs(JobGroup* group, JobFunction function, void* data, int count, int batch_size)
+{
+    if (count <= 0) { return; }
+    Job job;
+    job.function = function;
+    job.data = data;
+    job.begin = 0;
+    job.end = count;
+    job.batch_size = MAX(1, batch_size);
+    job.group = group;
+
+    // outside the job system, or with a full deque, the work happens right away on this thread
+    auto worker = t_job_worker;
+    SDL_AtomicIncRef(&group->pending);
+    if (worker == NULL || !push_job(worker, job))
+    {
+        SDL_AtomicAdd(&group->pending, -1);
+        function(data, 0, count);
+        return;
+    }
+    wake_job_workers();
+}
+
+void submit_job(JobGroup* group, JobFunction function, void* data) { submit_jobs(group, function, data, 1, 1); }
+
+void wait_for_jobs(JobGroup* group)
+{
+    auto worker = t_job_worker;
+    while (SDL_AtomicGet(&group->pending) != 0)
+    {
+        if (worker == NULL || !run_one_job(worker)) { SDL_Delay(0); }
+    }
+}
+
+void parallel_for(JobFunction function, void* data, int count, int batch_size)
+{
+    auto group = make_job_group();
+    submit_jobs(&group, function, data, count, batch_size);
+    wait_for_jobs(&group);
+}
+
+int job_worker_thread(void* data)
+{
+    auto worker = (JobWorker*)data;
+    t_job_worker = worker;
+    if (g_jobs.pin_threads) { platform_pin_thread_to_core(worker->index % SDL_GetCPUCount()); }
+    auto idle_rounds = 0;
+    while (SDL_AtomicGet(&g_jobs.running))
+    {
+        if (run_one_job(worker))
+        {
+            idle_rounds = 0;
+            continue;
+        }
+        if (++idle_rounds < JOB_SPIN_ROUNDS) { continue; }
+        SDL_AtomicIncRef(&g_jobs.sleeping);
+        SDL_SemWaitTimeout(g_jobs.wake, JOB_IDLE_SLEEP_MS);
+        SDL_AtomicAdd(&g_jobs.sleeping, -1);
+    }
+    return 0;
+}
+
+// TETRIS_JOB_WORKERS overrides the worker count (the main thread included), TETRIS_PIN_THREADS=1 pins workers to cores
+int get_job_worker_count_from_environment()
+{
+    auto value = SDL_getenv("TETRIS_JOB_WORKERS");
+    if (value != NULL)
+    {
+        auto parsed = string_to_int(make_string(c_string_length(value), value));
+        if (parsed.success && parsed.value > 0) { return parsed.value; }
+    }
+    return SDL_GetCPUCount();
+}
+
+bool get_pin_threads_from_environment()
+{
+    auto value = SDL_getenv("TETRIS_PIN_THREADS");
+    return value != NULL && c_string_equals(value, "1");
+}
+
+void reset_job_stats()
+{
+    for (auto i = 0; i < g_jobs.worker_count; i++)
+    { set_memory(0, sizeof(g_jobs.workers[i].stats), &g_jobs.workers[i].stats); }
+    g_jobs.stats_start_time = get_monotonic_nanoseconds();
+}
+
+// the calling thread becomes worker 0 and has to be the one that calls stop_jobs
+void start_jobs(int worker_count, bool pin_threads)
+{
+    g_jobs.worker_count = MIN(MAX(worker_count, 1), MAX_JOB_WORKERS);
+    g_jobs.pin_threads = pin_threads;
+    g_jobs.workers = (JobWorker*)SDL_calloc(g_jobs.worker_count, sizeof(JobWorker));
+    if (g_jobs.workers == NULL) { panic("Out of memory for job workers"); }
+    g_jobs.wake = SDL_CreateSemaphore(0);
+    if (g_jobs.wake == NULL) { panic_sdl("SDL_CreateSemaphore"); }
+    SDL_AtomicSet(&g_jobs.running, 1);
+    reset_job_stats();
+
+    for (auto i = 0; i < g_jobs.worker_count; i++)
+    {
+        auto worker = &g_jobs.workers[i];
+        worker->index = i;
+        seed_random_number_generator(i + 1, &worker->random);
+    }
+    t_job_worker = &g_jobs.workers[0];
+    if (pin_threads) { platform_pin_thread_to_core(0); }
+    for (auto i = 1; i < g_jobs.worker_count; i++)
+    {
+        auto worker = &g_jobs.workers[i];
+        worker->thread = SDL_CreateThread(job_worker_thread, "job worker", worker);
+        if (worker->thread == NULL) { panic_sdl("SDL_CreateThread"); }
+    }
+}
+
+void stop_jobs()
+{
+    if (g_jobs.workers == NULL) { return; }
+    SDL_AtomicSet(&g_jobs.running, 0);
+    for (auto i = 1; i < g_jobs.worker_count; i++) { SDL_SemPost(g_jobs.wake); }
+    for (auto i = 1; i < g_jobs.worker_count; i++) { SDL_WaitThread(g_jobs.workers[i].thread, NULL); }
+    SDL_DestroySemaphore(g_jobs.wake);
+    SDL_free(g_jobs.workers);
+    g_jobs.workers = NULL;
+    g_jobs.worker_count = 0;
+    t_job_worker = NULL;
+}
+
+// utilization is time spent running jobs since the last reset_job_stats
+void print_job_stats()
+{
+    auto elapsed = get_monotonic_nanoseconds() - g_jobs.stats_start_time;
+    for (auto i = 0; i < g_jobs.worker_count; i++)
+    {
+        auto stats = g_jobs.workers[i].stats;
+        print("worker ");
+        print((s64)i);
+        print(": jobs ");
+        print(stats.jobs);
+        print(", steals ");
+        print(stats.steals);
+        print(", failed steals ");
+        print(stats.failed_steals);
+        print(", busy ");
+        print(elapsed == 0 ? 0.0f : 100.0f * (float)stats.busy_nanoseconds / (float)elapsed);
+        print("%\n");
+    }
+}
@@ -0,0 +1,283 @@
+// Buffered logging. Every thread that logs gets its own single-producer ring of unformatted records, so logging
+// from the simulation or rendering never takes a lock or touches the console. A background thread drains the rings,
+// formats the records and writes them to stdout in large batches.
+// Messages must be string literals (or otherwise outlive the flush), since only the pointer is stored.
+// stop_log gives every ring back, so a library that starts and stops the log many times, each time with new threads,
+// doesn't run out of them; a thread that logged before takes a new ring on its next record.
+
+#define MAX_LOG_THREADS 64
+#define LOG_RING_CAPACITY 512 // must be a power of two
+#define LOG_FLUSH_PERIOD_MS 10
+#define LOG_OUTPUT_BUFFER_SIZE 16384
+
+enum LogSeverity
+{
+    LogSeverityDebug,
+    LogSeverityInfo,
+    LogSeverityWarning,
+    LogSeverityError,
+};
+
+char* LOG_SEVERITY_NAMES[] = { "DEBUG", "INFO", "WARNING", "ERROR" };
+
+enum LogArgumentType
+{
+    LogArgumentTypeNone,
+    LogArgumentTypeSigned,
+    LogArgumentTypeUnsigned,
+    LogArgumentTypeFloat,
+};
+
+struct LogRecord
+{
+    u64 time;
+    char* message;
+    LogSeverity severity;
+    LogArgumentType argument_type;
+    union
+    {
+        s64 signed_value;
+        u64 unsigned_value;
+        float float_value;
+    } argument;
+};
+
+struct LogRing
+{
+    SDL_atomic_t write_index; // advanced only by the owning thread
+    SDL_atomic_t read_index; // advanced only by whoever holds g_log.flush_mutex
+    LogRecord records[LOG_RING_CAPACITY];
+};
+
+struct Log
+{
+    SDL_atomic_t minimum_severity;
+    SDL_atomic_t ring_count;
+    SDL_atomic_t generation; // counts stop_log calls, a thread's ring from an older one isn't its own any more
+    SDL_atomic_t dropped_records;
+    SDL_atomic_t running;
+    u64 start_time;
+    SDL_Thread* flusher;
+    SDL_mutex* flush_mutex;
+    LogRing rings[MAX_LOG_THREADS];
+};
+
+Log g_log;
+
+thread_local LogRing* t_log_ring;
+thread_local int t_log_generation;
+
+void set_log_severity(LogSeverity minimum_severity) { SDL_AtomicSet(&g_log.minimum_severity, minimum_severity); }
+
+bool is_log_severity_enabled(LogSeverity severity) { return severity >= SDL_AtomicGet(&g_log.minimum_severity); }
+
+LogRing* get_log_ring_for_this_thread()
+{
+    auto generation = SDL_AtomicGet(&g_log.generation);
+    if (t_log_ring == NULL || t_log_generation != generation)
+    {
+        t_log_ring = NULL;
+        t_log_generation = generation;
+        auto index = SDL_AtomicAdd(&g_log.ring_count, 1);
+        if (index >= MAX_LOG_THREADS)
+        {
+            SDL_AtomicAdd(&g_log.ring_count, -1);
+            return NULL;
+        }
+        t_log_ring = &g_log.rings[index];
+    }
+    return t_log_ring;
+}
+
+void push_log_record(LogRecord record)
+{
+    auto ring = get_log_ring_for_this_thread();
+    if (ring == NULL)
+    {
+        SDL_AtomicIncRef(&g_log.dropped_records);
+        return;
+    }
+    auto write_index = (u32)SDL_AtomicGet(&ring->write_index);
+    auto read_index = (u32)SDL_AtomicGet(&ring->read_index);
+    if (write_index - read_index == LOG_RING_CAPACITY)
+    {
+        // the flusher is behind: dropping is better than stalling the caller
+        SDL_AtomicIncRef(&g_log.dropped_records);
+        return;
+    }
+    record.time = get_monotonic_nanoseconds();
+    ring->records[write_index % LOG_RING_CAPACITY] = record;
+    SDL_AtomicSet(&ring->write_index, (int)(write_index + 1));
+}
+
+LogRecord make_log_record(LogSeverity severity, char* message)
+{
+    LogRecord result;
+    result.severity = severity;
+    result.message = message;
+    result.argument_type = LogArgumentTypeNone;
+    result.argument.unsigned_value = 0;
+    return result;
+}
+
+void log_message(LogSeverity severity, char* message)
+{
+    if (!is_log_severity_enabled(severity)) { return; }
+    push_log_record(make_log_record(severity, message));
+}
+
+void log_message(LogSeverity severity, char* message, s64 value)
+{
+    if (!is_log_severity_enabled(severity)) { return; }
+    auto record = make_log_record(severity, message);
+    record.argument_type = LogArgumentTypeSigned;
+    record.argument.signed_value = value;
+    push_log_record(record);
+}
+
+void log_message(LogSeverity severity, char* message, int value) { log_message(severity, message, (s64)value); }
+
+void log_message(LogSeverity severity, char* message, u64 value)
+{
+    if (!is_log_severity_enabled(severity)) { return; }
+    auto record = make_log_record(severity, message);
+    record.argument_type = LogArgumentTypeUnsigned;
+    record.argument.unsigned_value = value;
+    push_log_record(record);
+}
+
+void log_message(LogSeverity severity, char* message, float value)
+{
+    if (!is_log_severity_enabled(severity)) { return; }
+    auto record = make_log_record(severity, message);
+    record.argument_type = LogArgumentTypeFloat;
+    record.argument.float_value = value;
+    push_log_record(record);
+}
+
+void format_log_record(LogRecord record, String* result)
+{
+    auto elapsed_ms = (record.time - MIN(record.time, g_log.start_time)) / 1000000;
+    push('[', result);
+    uint_to_string(elapsed_ms / 1000, result);
+    push('.', result);
+    auto milliseconds = elapsed_ms % 1000;
+    push('0' + milliseconds / 100, result);
+    push('0' + milliseconds / 10 % 10, result);
+    push('0' + milliseconds % 10, result);
+    push("] ", result);
+    push(LOG_SEVERITY_NAMES[record.severity], result);
+    push(' ', result);
+    push(record.message, result);
+    switch (record.argument_type)
+    {
+        case LogArgumentTypeNone: break;
+        case LogArgumentTypeSigned: int_to_string(record.argument.signed_value, result); break;
+        case LogArgumentTypeUnsigned: uint_to_string(record.argument.unsigned_value, result); break;
+        case LogArgumentTypeFloat: float_to_string(record.argument.float_value, result); break;
+    }
+    push('\n', result);
+}
+
+// drains every ring; safe to call from any thread, e.g. right before exiting
+void flush_log()
+{
+    if (g_log.flush_mutex != NULL) { SDL_LockMutex(g_log.flush_mutex); }
+
+    static char output_data[LOG_OUTPUT_BUFFER_SIZE];
+    auto output = make_string(0, output_data);
+    auto ring_count = MIN(SDL_AtomicGet(&g_log.ring_count), MAX_LOG_THREADS);
+    for (auto ring_index = 0; ring_index < ring_count; ring_index++)
+    {
+        auto ring = &g_log.rings[ring_index];
+        auto read_index = (u32)SDL_AtomicGet(&ring->read_index);
+        auto write_index = (u32)SDL_AtomicGet(&ring->write_index);
+        while (read_index != write_index)
+        {
+            auto record = ring->records[read_index % LOG_RING_CAPACITY];
+            read_index++;
+            SDL_AtomicSet(&ring->read_index, (int)read_index);
+
+            // 64 bytes covers the timestamp, severity and any formatted argument
+            auto needed = c_string_length(record.message) + 64;
+            if (output.size + needed > LOG_OUTPUT_BUFFER_SIZE)
+            {
+                print(output);
+                output.size = 0;
+            }
+            if (needed > LOG_OUTPUT_BUFFER_SIZE) { print(record.message); print("\n"); }
+            else { format_log_record(record, &output); }
+        }
+    }
+
+    auto dropped_records = SDL_AtomicSet(&g_log.dropped_records, 0);
+    if (dropped_records != 0)
+    {
+        push("[log] dropped ", &output);
+        uint_to_string(dropped_records, &output);
+        push(" records\n", &output);
+    }
+    if (output.size != 0) { print(output); }
+
+    if (g_log.flush_mutex != NULL) { SDL_UnlockMutex(g_log.flush_mutex); }
+}
+
+int log_flusher_thread(void*)
+{
+    while (SDL_AtomicGet(&g_log.running))
+    {
+        flush_log();
+        SDL_Delay(LOG_FLUSH_PERIOD_MS);
+    }
+    flush_log();
+    return 0;
+}
+
+// TETRIS_LOG_LEVEL can be one of debug, info, warning or error
+LogSeverity get_log_severity_from_environment(LogSeverity default_severity)
+{
+    auto value = SDL_getenv("TETRIS_LOG_LEVEL");
+    if (value == NULL) { return default_severity; }
+    if (c_string_equals(value, "debug")) { return LogSeverityDebug; }
+    if (c_string_equals(value, "info")) { return LogSeverityInfo; }
+    if (c_string_equals(value, "warning")) { return LogSeverityWarning; }
+    if (c_string_equals(value, "error")) { return LogSeverityError; }
+    return default_severity;
+}
+
+void start_log(LogSeverity minimum_severity)
+{
+    set_log_severity(minimum_severity);
+    g_log.start_time = get_monotonic_nanoseconds();
+    g_log.flush_mutex = SDL_CreateMutex();
+    if (g_log.flush_mutex == NULL) { panic_sdl("SDL_CreateMutex"); }
+    SDL_AtomicSet(&g_log.running, 1);
+    g_log.flusher = SDL_CreateThread(log_flusher_thread, "log flusher", NULL);
+    if (g_log.flusher == NULL) { panic_sdl("SDL_CreateThread"); }
+}
+
+// nothing else may be logging while the log stops
+void stop_log()
+{
+    if (g_log.flusher == NULL) { return; }
+    SDL_AtomicSet(&g_log.running, 0);
+    SDL_WaitThread(g_log.flusher, NULL);
+    g_log.flusher = NULL;
+    SDL_DestroyMutex(g_log.flush_mutex);
+    g_log.flush_mutex = NULL;
+
+    // the flusher drained every ring on its way out
+    auto ring_count = MIN(SDL_AtomicGet(&g_log.ring_count), MAX_LOG_THREADS);
+    for (auto i = 0; i < ring_count; i++)
+    {
+        SDL_AtomicSet(&g_log.rings[i].write_index, 0);
+        SDL_AtomicSet(&g_log.rings[i].read_index, 0);
+    }
+    SDL_AtomicSet(&g_log.ring_count, 0);
+    SDL_AtomicAdd(&g_log.generation, 1);
+}
+
+#define log_debug(...) log_message(LogSeverityDebug, __VA_ARGS__)
+#define log_info(...) log_message(LogSeverityInfo, __VA_ARGS__)
+#define log_warning(...) log_message(LogSeverityWarning, __VA_ARGS__)
+#define log_error(...) log_message(LogSeverityError, __VA_ARGS__)
@@ -1,10 +1,58 @@
+#ifdef _WIN32
+#include <winsock2.h>
 #include <windows.h>
 #include "lib/SDL2/SDL.h"
 #include "lib/SDL2/SDL_ttf.h"
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#endif
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
 
 #include "common.cpp"
+#ifdef _WIN32
+#include "platform_windows.cpp"
+#else
+#include "platform_posix.cpp"
+#endif
+#include "memory.cpp"
+#include "log.cpp"
+#include "jobs.cpp"
 #include "game_state.cpp"
+#include "move_generator.cpp"
+#include "evaluation.cpp"
+#include "network.cpp"
+#include "training_export.cpp"
+#include "bot.cpp"
+#include "transposition_table.cpp"
+#include "search.cpp"
+#include "perft.cpp"
+#include "tuner.cpp"
+#include "estimator.cpp"
+#include "tournament.cpp"
+#include "environment.cpp"
 #include "rendering.cpp"
+#include "versus.cpp"
+#include "server.cpp"
+#include "spectator.cpp"
+#include "terminal.cpp"
+#include "headless.cpp"
 
 #define SCREEN_WIDTH 500
 #define SCREEN_HEIGHT 500
@@ -21,9 +69,36 @@
 // [ ] textures for blocks?
 // [ ] lagging?
 
-int main(int, char**)
+int main(int argument_count, char** arguments)
 {
-    seed_random_number_generator(get_system_time().milliseconds);
+    initialize_memory_primitives();
+    initialize_board_batch_evaluator();
+    initialize_board_network_evaluator();
+    initialize_zobrist_keys();
+    start_log(get_log_severity_from_environment(LogSeverityInfo));
+    start_jobs(get_job_worker_count_from_environment(), get_pin_threads_from_environment());
+    load_board_network_from_environment();
+
+    // versus runs in the window, everything else given on the command line runs without one
+    Versus* versus = NULL;
+    if (argument_count > 1 && c_string_equals(arguments[1], "--versus"))
+    {
+        versus = start_versus_from_arguments(argument_count - 2, arguments + 2);
+        if (versus == NULL)
+        {
+            print_headless_usage();
+            stop_jobs();
+            stop_log();
+            return 1;
+        }
+    }
+    else if (argument_count > 1)
+    {
+        auto result = run_headless_command(argument_count - 1, arguments + 1);
+        stop_jobs();
+        stop_log();
+        return result;
+    }
 
     auto sdl_init_result = SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
     if (sdl_init_result < 0) { panic_sdl("SDL_Init"); }
@@ -41,25 +116,20 @@ int main(int, char**)
     );
     if (!window) { panic_sdl("SDL_CreateWindow"); }
 
-    g_game_state.resources.font16 = TTF_OpenFont("res/Sans.ttf", 16);
-    if (g_game_state.resources.font16 == NULL) { panic_sdl("TTF_OpenFont"); }
-    g_game_state.resources.font32 = TTF_OpenFont("res/Sans.ttf", 32);
-    if (g_game_state.resources.font32 == NULL) { panic_sdl("TTF_OpenFont"); }
+    load_resources();
 
     initialize_shape_cell_maps();
 
-    g_game_state.board = make_cell_map(BOARD_WIDTH,BOARD_HEIGHT);
-    g_game_state.score = 0;
+    initialize_game_state(get_system_time().milliseconds, &g_game_state);
     g_game_state.high_score = load_high_score();
-    g_game_state.board_color = PURPLE;
-    g_game_state.board_color_going_negative = false;
-    g_game_state.power_ups.mirror = 1;
-    g_game_state.power_ups.fill_cell = 1;
-    g_game_state.power_ups.invert_board = 1;
-    g_game_state.power_ups.bomb = 1;
-    g_game_state.time = SDL_GetTicks();
-    generate_new_falling_shape();
-    generate_initial_board_layout();
+    g_game_state.is_interactive = true;
+
+    auto export_directory = get_training_export_directory_from_environment();
+    if (export_directory != NULL && !start_training_export(&g_training_exporter, export_directory, DEFAULT_TRAINING_SHARD_BYTES))
+    {
+        log_error("TETRIS_EXPORT_DIRECTORY is too long, not exporting");
+        export_directory = NULL;
+    }
 
     float fps = 0;
     int dt = 0;
@@ -94,6 +164,8 @@ int main(int, char**)
                     input.two |= sym == SDLK_2;
                     input.three |= sym == SDLK_3;
                     input.four |= sym == SDLK_4;
+                    if (sym == SDLK_b) { toggle_bot(&g_bot); }
+                    if (sym == SDLK_t && versus == NULL) { cycle_turbo(&g_turbo, &g_bot); }
                     break;
                 }
             }
@@ -104,17 +176,51 @@ int main(int, char**)
         if (screen_surface == NULL) { panic_sdl("SDL_GetWindowSurface"); }
         auto screen = make_bitmap(screen_surface->w, screen_surface->h, (Pixel*)screen_surface->pixels);
 
-        process_input(dt, input);
+        // in turbo the bot plays a frame's worth of ticks at a time and only the last one is drawn
+        auto tick_count = TURBO_TICKS_PER_FRAME[g_turbo.level];
+        auto tick_dt = g_turbo.level == 0 ? dt : TURBO_TICK_MS;
+        auto ticks = 0;
+        if (versus != NULL)
+        {
+            // both games step in lockstep with the other instance, the window shows the local one
+            auto local_input = input;
+            if (g_bot.enabled) { local_input = get_bot_input(&g_bot, &versus->simulation.players[versus->local].state); }
+            update_versus(versus, local_input, get_due_versus_ticks(versus));
+            g_game_state = get_versus_display_state(versus);
+        }
+        else
+        {
+            while (ticks < tick_count)
+            {
+                if (g_bot.enabled)
+                {
+                    auto bot_input = get_bot_input(&g_bot, &g_game_state);
+                    bot_input.escape = input.escape;
+                    input = bot_input;
+                }
+
+                process_input(tick_dt, input, &g_game_state);
+                if (export_directory != NULL) { record_game_for_training(&g_training_exporter, &g_training_recorder, &g_game_state); }
+                set_memory(0, sizeof(input), &input);
+                ticks++;
+                if (ticks % 16 == 0 && (int)SDL_GetTicks() - frame_start >= TURBO_FRAME_BUDGET_MS) { break; }
+            }
+        }
 
         // rendering
         {
-            draw_game(screen);
+            draw_game_tiled(screen);
 
-            char fps_buffer_data[20];
-            auto fps_buffer = make_string(0, fps_buffer_data);
-            float_to_string(fps, &fps_buffer);
-            push('\0', &fps_buffer);
-            draw_text(0, 0, RED, g_game_state.resources.font16, fps_buffer.data, screen);
+            auto fps_text = get_numeric_label_text(&g_hud.fps, fps, &g_hud.digits16);
+            draw_text_mask(0, 0, RED, fps_text, screen);
+            if (g_turbo.level != 0)
+            {
+                auto ticks_text = get_numeric_label_text(&g_hud.ticks_per_second, (s64)g_turbo.ticks_per_second, &g_hud.digits16);
+                draw_text_mask(0, fps_text.height, RED, ticks_text, screen);
+                auto speed_text = get_numeric_label_text(&g_hud.sim_speed, (s64)g_turbo.speed, &g_hud.digits16);
+                draw_text_mask(0, fps_text.height + ticks_text.height, RED, speed_text, screen);
+            }
+            if (versus != NULL) { draw_versus_hud(versus, fps_text.height, screen); }
 
             SDL_UpdateWindowSurface(window);
         }
@@ -123,7 +229,14 @@ int main(int, char**)
         SDL_Delay(MAX(0, 16 - (frame_end - frame_start)));
         dt = ((int)SDL_GetTicks() - frame_start);
         fps = 1000.0f / (float)dt;
+        g_turbo.ticks_per_second = ticks * fps;
+        g_turbo.speed = ticks * tick_dt / (float)dt;
+        log_debug("Frame time ms: ", dt);
     }
 
+    if (versus != NULL) { free_versus(versus); }
+    stop_training_export(&g_training_exporter);
+    stop_jobs();
+    stop_log();
     return 0;
 }
@@ -0,0 +1,328 @@
+// Bulk memory primitives. The portable versions are always usable; initialize_memory_primitives swaps in SSE2 or
+// AVX2 versions based on what SDL reports about the CPU, so call it once at startup before any hot loops run.
+// copy_memory doesn't handle overlapping ranges.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MEMORY_PRIMITIVES_X86 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#define TARGET_SSE2
+#define TARGET_AVX2
+#else
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+void set_memory_portable(char value, u64 size, void* data)
+{
+    for (u64 i = 0; i < size; i++)
+    { ((char*)data)[i] = value; }
+}
+
+void set_memory_u32_portable(u32 value, u64 count, u32* data)
+{
+    for (u64 i = 0; i < count; i++) { data[i] = value; }
+}
+
+void copy_memory_portable(u64 size, void* from, void* to)
+{
+    for (u64 i = 0; i < size; i++) { ((char*)to)[i] = ((char*)from)[i]; }
+}
+
+bool memory_equals_portable(u64 size, void* left, void* right)
+{
+    for (u64 i = 0; i < size; i++)
+    {
+        if (((char*)left)[i] != ((char*)right)[i]) { return false; }
+    }
+    return true;
+}
+
+#ifdef MEMORY_PRIMITIVES_X86
+
+// Vector versions finish with one unaligned store or load that overlaps the previous one instead of a byte loop,
+// and hand sizes below one vector to the narrower version.
+
+TARGET_SSE2 void set_memory_sse2(char value, u64 size, void* data)
+{
+    auto bytes = (char*)data;
+    if (size < 16)
+    {
+        set_memory_portable(value, size, data);
+        return;
+    }
+    auto fill = _mm_set1_epi8(value);
+    u64 i = 0;
+    for (; i + 64 <= size; i += 64)
+    {
+        _mm_storeu_si128((__m128i*)(bytes + i), fill);
+        _mm_storeu_si128((__m128i*)(bytes + i + 16), fill);
+        _mm_storeu_si128((__m128i*)(bytes + i + 32), fill);
+        _mm_storeu_si128((__m128i*)(bytes + i + 48), fill);
+    }
+    for (; i + 16 <= size; i += 16) { _mm_storeu_si128((__m128i*)(bytes + i), fill); }
+    if (i < size) { _mm_storeu_si128((__m128i*)(bytes + size - 16), fill); }
+}
+
+TARGET_SSE2 void set_memory_u32_sse2(u32 value, u64 count, u32* data)
+{
+    if (count < 4)
+    {
+        set_memory_u32_portable(value, count, data);
+        return;
+    }
+    auto fill = _mm_set1_epi32((int)value);
+    u64 i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        _mm_storeu_si128((__m128i*)(data + i), fill);
+        _mm_storeu_si128((__m128i*)(data + i + 4), fill);
+        _mm_storeu_si128((__m128i*)(data + i + 8), fill);
+        _mm_storeu_si128((__m128i*)(data + i + 12), fill);
+    }
+    for (; i + 4 <= count; i += 4) { _mm_storeu_si128((__m128i*)(data + i), fill); }
+    if (i < count) { _mm_storeu_si128((__m128i*)(data + count - 4), fill); }
+}
+
+TARGET_SSE2 void copy_memory_sse2(u64 size, void* from, void* to)
+{
+    auto source = (char*)from;
+    auto destination = (char*)to;
+    if (size < 16)
+    {
+        copy_memory_portable(size, from, to);
+        return;
+    }
+    u64 i = 0;
+    for (; i + 16 <= size; i += 16)
+    { _mm_storeu_si128((__m128i*)(destination + i), _mm_loadu_si128((__m128i*)(source + i))); }
+    if (i < size)
+    { _mm_storeu_si128((__m128i*)(destination + size - 16), _mm_loadu_si128((__m128i*)(source + size - 16))); }
+}
+
+TARGET_SSE2 bool memory_equals_sse2(u64 size, void* left, void* right)
+{
+    auto a = (char*)left;
+    auto b = (char*)right;
+    if (size < 16) { return memory_equals_portable(size, left, right); }
+    u64 i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        auto equal = _mm_cmpeq_epi8(_mm_loadu_si128((__m128i*)(a + i)), _mm_loadu_si128((__m128i*)(b + i)));
+        if (_mm_movemask_epi8(equal) != 0xffff) { return false; }
+    }
+    if (i < size)
+    {
+        auto equal = _mm_cmpeq_epi8(_mm_loadu_si128((__m128i*)(a + size - 16)), _mm_loadu_si128((__m128i*)(b + size - 16)));
+        if (_mm_movemask_epi8(equal) != 0xffff) { return false; }
+    }
+    return true;
+}
+
+TARGET_AVX2 void set_memory_avx2(char value, u64 size, void* data)
+{
+    auto bytes = (char*)data;
+    if (size < 32)
+    {
+        set_memory_sse2(value, size, data);
+        return;
+    }
+    auto fill = _mm256_set1_epi8(value);
+    u64 i = 0;
+    for (; i + 128 <= size; i += 128)
+    {
+        _mm256_storeu_si256((__m256i*)(bytes + i), fill);
+        _mm256_storeu_si256((__m256i*)(bytes + i + 32), fill);
+        _mm256_storeu_si256((__m256i*)(bytes + i + 64), fill);
+        _mm256_storeu_si256((__m256i*)(bytes + i + 96), fill);
+    }
+    for (; i + 32 <= size; i += 32) { _mm256_storeu_si256((__m256i*)(bytes + i), fill); }
+    if (i < size) { _mm256_storeu_si256((__m256i*)(bytes + size - 32), fill); }
+}
+
+TARGET_AVX2 void set_memory_u32_avx2(u32 value, u64 count, u32* data)
+{
+    if (count < 8)
+    {
+        set_memory_u32_sse2(value, count, data);
+        return;
+    }
+    auto fill = _mm256_set1_epi32((int)value);
+    u64 i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        _mm256_storeu_si256((__m256i*)(data + i), fill);
+        _mm256_storeu_si256((__m256i*)(data + i + 8), fill);
+        _mm256_storeu_si256((__m256i*)(data + i + 16), fill);
+        _mm256_storeu_si256((__m256i*)(data + i + 24), fill);
+    }
+    for (; i + 8 <= count; i += 8) { _mm256_storeu_si256((__m256i*)(data + i), fill); }
+    if (i < count) { _mm256_storeu_si256((__m256i*)(data + count - 8), fill); }
+}
+
+TARGET_AVX2 void copy_memory_avx2(u64 size, void* from, void* to)
+{
+    auto source = (char*)from;
+    auto destination = (char*)to;
+    if (size < 32)
+    {
+        copy_memory_sse2(size, from, to);
+        return;
+    }
+    u64 i = 0;
+    for (; i + 32 <= size; i += 32)
+    { _mm256_storeu_si256((__m256i*)(destination + i), _mm256_loadu_si256((__m256i*)(source + i))); }
+    if (i < size)
+    { _mm256_storeu_si256((__m256i*)(destination + size - 32), _mm256_loadu_si256((__m256i*)(source + size - 32))); }
+}
+
+TARGET_AVX2 bool memory_equals_avx2(u64 size, void* left, void* right)
+{
+    auto a = (char*)left;
+    auto b = (char*)right;
+    if (size < 32) { return memory_equals_sse2(size, left, right); }
+    u64 i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        auto equal = _mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i*)(a + i)), _mm256_loadu_si256((__m256i*)(b + i)));
+        if ((u32)_mm256_movemask_epi8(equal) != 0xffffffff) { return false; }
+    }
+    if (i < size)
+    {
+        auto equal = _mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i*)(a + size - 32)), _mm256_loadu_si256((__m256i*)(b + size - 32)));
+        if ((u32)_mm256_movemask_epi8(equal) != 0xffffffff) { return false; }
+    }
+    return true;
+}
+
+#endif
+
+enum MemoryPrimitivesLevel
+{
+    MemoryPrimitivesLevelPortable,
+    MemoryPrimitivesLevelSSE2,
+    MemoryPrimitivesLevelAVX2,
+};
+
+char* MEMORY_PRIMITIVES_LEVEL_NAMES[] = { "portable", "SSE2", "AVX2" };
+
+struct MemoryPrimitives
+{
+    MemoryPrimitivesLevel level;
+    void (*set)(char value, u64 size, void* data);
+    void (*set_u32)(u32 value, u64 count, u32* data);
+    void (*copy)(u64 size, void* from, void* to);
+    bool (*equals)(u64 size, void* left, void* right);
+};
+
+MemoryPrimitives make_memory_primitives(MemoryPrimitivesLevel level)
+{
+    MemoryPrimitives result;
+    result.level = MemoryPrimitivesLevelPortable;
+    result.set = set_memory_portable;
+    result.set_u32 = set_memory_u32_portable;
+    result.copy = copy_memory_portable;
+    result.equals = memory_equals_portable;
+#ifdef MEMORY_PRIMITIVES_X86
+    if (level == MemoryPrimitivesLevelSSE2)
+    {
+        result.level = level;
+        result.set = set_memory_sse2;
+        result.set_u32 = set_memory_u32_sse2;
+        result.copy = copy_memory_sse2;
+        result.equals = memory_equals_sse2;
+    }
+    else if (level == MemoryPrimitivesLevelAVX2)
+    {
+        result.level = level;
+        result.set = set_memory_avx2;
+        result.set_u32 = set_memory_u32_avx2;
+        result.copy = copy_memory_avx2;
+        result.equals = memory_equals_avx2;
+    }
+#endif
+    return result;
+}
+
+MemoryPrimitives g_memory_primitives = make_memory_primitives(MemoryPrimitivesLevelPortable);
+
+MemoryPrimitivesLevel get_best_memory_primitives_level()
+{
+#ifdef MEMORY_PRIMITIVES_X86
+    if (SDL_HasAVX2()) { return MemoryPrimitivesLevelAVX2; }
+    if (SDL_HasSSE2()) { return MemoryPrimitivesLevelSSE2; }
+#endif
+    return MemoryPrimitivesLevelPortable;
+}
+
+void initialize_memory_primitives() { g_memory_primitives = make_memory_primitives(get_best_memory_primitives_level()); }
+
+void set_memory(char value, u64 size, void* data) { g_memory_primitives.set(value, size, data); }
+
+void set_memory_u32(u32 value, u64 count, u32* data) { g_memory_primitives.set_u32(value, count, data); }
+
+void copy_memory(u64 size, void* from, void* to) { g_memory_primitives.copy(size, from, to); }
+
+bool memory_equals(u64 size, void* left, void* right) { return g_memory_primitives.equals(size, left, right); }
+
+float measure_memory_primitive_gigabytes_per_second(MemoryPrimitives primitives, int operation, u64 size, char* a, char* b)
+{
+    // repeat small sizes enough that the timer resolution doesn't matter
+    auto repetitions = MAX(4, (64 * 1024 * 1024) / size);
+    auto start = get_monotonic_nanoseconds();
+    auto equal_count = 0;
+    for (u64 i = 0; i < repetitions; i++)
+    {
+        switch (operation)
+        {
+            case 0: primitives.set((char)i, size, a); break;
+            case 1: primitives.copy(size, a, b); break;
+            case 2: equal_count += primitives.equals(size, a, b); break;
+        }
+    }
+    auto seconds = (float)(get_monotonic_nanoseconds() - start) / 1e9f;
+    // keeps the comparisons from being optimized away
+    if (equal_count < 0) { print("unreachable"); }
+    return (float)(size * repetitions) / seconds / 1e9f;
+}
+
+int benchmark_memory_primitives()
+{
+    u64 sizes[] = { 16, 64, 256, 1024, 4 * 1024, 64 * 1024, 1024 * 1024, 8 * 1024 * 1024 };
+    char* operation_names[] = { "set", "copy", "equals" };
+    auto max_size = sizes[countof(sizes) - 1];
+    auto a = (char*)SDL_malloc(max_size);
+    auto b = (char*)SDL_malloc(max_size);
+    if (a == NULL || b == NULL) { panic("Failed to allocate benchmark buffers"); }
+    set_memory_portable(1, max_size, a);
+    set_memory_portable(1, max_size, b);
+
+    auto best_level = get_best_memory_primitives_level();
+    print("selected: ");
+    print(MEMORY_PRIMITIVES_LEVEL_NAMES[best_level]);
+    print("\n");
+    for (auto operation = 0; operation < countof(operation_names); operation++)
+    {
+        for (auto size_index = 0; size_index < countof(sizes); size_index++)
+        {
+            for (auto level = 0; level <= best_level; level++)
+            {
+                auto primitives = make_memory_primitives((MemoryPrimitivesLevel)level);
+                // equals runs after the copy pass has made a and b identical, so it always scans the full size
+                auto speed = measure_memory_primitive_gigabytes_per_second(primitives, operation, sizes[size_index], a, b);
+                print(operation_names[operation]);
+                print(" ");
+                print(sizes[size_index]);
+                print(" bytes ");
+                print(MEMORY_PRIMITIVES_LEVEL_NAMES[level]);
+                print(": ");
+                print(speed);
+                print(" GB/s\n");
+            }
+        }
+    }
+
+    SDL_free(a);
+    SDL_free(b);
+    return 0;
+}
@@ -0,0 +1,261 @@
+// Exact move generation. Explores every (x, y, orientation) the falling shape can reach with the game's own moves:
+// left/right, rotate with the rotate handler's shift-left wall kick, a single mirror while mirror power ups last, and one row
+// of gravity at a time. Since a row of gravity lasts many frames, any number of moves is allowed within a row.
+// Each row is a bitmask over x, so sideways movement is a shift-and-mask flood fill and collision for a whole row of
+// positions is a handful of shifts over the packed board.
+
+// orientations 0-3 are the spawned shape rotated 0-3 times, 4-7 are the mirrored shape rotated 0-3 times
+#define MOVE_GENERATOR_ORIENTATIONS 8
+#define MAX_LOCK_POSITIONS (MOVE_GENERATOR_ORIENTATIONS * BOARD_HEIGHT * BOARD_WIDTH)
+// the first-reached paths aren't the shortest, but they visit each (x, y, orientation) at most once
+#define MAX_MOVE_SEQUENCE (MOVE_GENERATOR_ORIENTATIONS * BOARD_WIDTH * BOARD_HEIGHT)
+
+enum MoveAction
+{
+    MoveActionSpawn,
+    MoveActionLeft,
+    MoveActionRight,
+    MoveActionRotate,
+    MoveActionMirror,
+    MoveActionDown,
+};
+
+struct ShapeOrientation
+{
+    bool valid;
+    int canonical; // lowest orientation with the same cells, placements are reported only once per distinct shape
+    CellMap cell_map;
+    u32 rows[CELL_MAP_PITCH];
+    u32 fits[BOARD_HEIGHT]; // bit x set when the shape fits at (x, y)
+};
+
+// how a state was first reached, followed backwards to rebuild the input sequence
+struct MoveStep
+{
+    u8 action;
+    u8 parent_orientation;
+    s8 parent_x;
+};
+
+struct LockPosition
+{
+    int orientation;
+    int x, y;
+};
+
+struct MoveGeneration
+{
+    ShapeOrientation orientations[MOVE_GENERATOR_ORIENTATIONS];
+    u32 reachable[MOVE_GENERATOR_ORIENTATIONS][BOARD_HEIGHT];
+    u32 locked[MOVE_GENERATOR_ORIENTATIONS][BOARD_HEIGHT]; // indexed by canonical orientation
+    MoveStep steps[MOVE_GENERATOR_ORIENTATIONS][BOARD_HEIGHT][BOARD_WIDTH];
+    int lock_count;
+    LockPosition locks[MAX_LOCK_POSITIONS];
+};
+
+int get_rotated_orientation(int orientation) { return (orientation & 4) | ((orientation + 1) & 3); }
+
+// mirroring a shape turned r times gives the mirrored shape turned -r times
+int get_mirrored_orientation(int orientation) { return 4 + (4 - (orientation & 3)) % 4; }
+
+u32 get_valid_x_mask(CellMap cell_map) { return (1u << (BOARD_WIDTH - cell_map.width + 1)) - 1; }
+
+u32 get_fitting_positions(ShapeOrientation* orientation, int y, PackedBoard* board)
+{
+    if (y < 0 || y + orientation->cell_map.height > BOARD_HEIGHT) { return 0; }
+    u32 blocked = 0;
+    for (auto shape_y = 0; shape_y < orientation->cell_map.height; shape_y++)
+    {
+        auto row = orientation->rows[shape_y];
+        for (auto shape_x = 0; row != 0; shape_x++, row >>= 1)
+        {
+            if (row & 1) { blocked |= board->rows[y + shape_y] >> shape_x; }
+        }
+    }
+    return ~blocked & get_valid_x_mask(orientation->cell_map);
+}
+
+void mark_reached(MoveGeneration* generation, int orientation, int y, u32 bits, MoveAction action, int parent_orientation, int parent_x_offset, int fixed_parent_x)
+{
+    generation->reachable[orientation][y] |= bits;
+    for (auto x = 0; bits != 0; x++, bits >>= 1)
+    {
+        if ((bits & 1) == 0) { continue; }
+        auto step = &generation->steps[orientation][y][x];
+        step->action = action;
+        step->parent_orientation = parent_orientation;
+        step->parent_x = fixed_parent_x >= 0 ? fixed_parent_x : x + parent_x_offset;
+    }
+}
+
+// fills every move that stays within row y until nothing new is reached
+void flood_fill_row(MoveGeneration* generation, int y)
+{
+    auto changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (auto orientation = 0; orientation < MOVE_GENERATOR_ORIENTATIONS; orientation++)
+        {
+            auto shape = &generation->orientations[orientation];
+            if (!shape->valid) { continue; }
+
+            // sideways: spread reached bits one column at a time until they stop growing
+            while (true)
+            {
+                auto reached = generation->reachable[orientation][y];
+                auto left = (reached >> 1) & shape->fits[y] & ~reached;
+                auto right = (reached << 1) & shape->fits[y] & ~reached & ~left;
+                if ((left | right) == 0) { break; }
+                mark_reached(generation, orientation, y, left, MoveActionLeft, orientation, 1, -1);
+                mark_reached(generation, orientation, y, right, MoveActionRight, orientation, -1, -1);
+                changed = true;
+            }
+
+            auto reached = generation->reachable[orientation][y];
+
+            // rotate: positions that still fit keep their x, the rest get shifted left against the right wall
+            auto rotated = get_rotated_orientation(orientation);
+            auto rotated_shape = &generation->orientations[rotated];
+            if (rotated_shape->valid)
+            {
+                auto target = &generation->reachable[rotated][y];
+                auto valid = get_valid_x_mask(rotated_shape->cell_map);
+                auto in_place = reached & valid & rotated_shape->fits[y] & ~*target;
+                if (in_place != 0)
+                {
+                    mark_reached(generation, rotated, y, in_place, MoveActionRotate, orientation, 0, -1);
+                    changed = true;
+                }
+                auto overflowing = reached & ~valid;
+                auto kicked_x = BOARD_WIDTH - rotated_shape->cell_map.width;
+                auto kicked = 1u << kicked_x;
+                if (overflowing != 0 && (rotated_shape->fits[y] & kicked) && (*target & kicked) == 0)
+                {
+                    auto parent_x = 0;
+                    while (((overflowing >> parent_x) & 1) == 0) { parent_x++; }
+                    mark_reached(generation, rotated, y, kicked, MoveActionRotate, orientation, 0, parent_x);
+                    changed = true;
+                }
+            }
+
+            // mirror: no wall kick, the mirrored shape has to fit where it is
+            if (orientation < 4)
+            {
+                auto mirrored = get_mirrored_orientation(orientation);
+                auto mirrored_shape = &generation->orientations[mirrored];
+                if (mirrored_shape->valid)
+                {
+                    auto new_bits = reached & mirrored_shape->fits[y] & ~generation->reachable[mirrored][y];
+                    if (new_bits != 0)
+                    {
+                        mark_reached(generation, mirrored, y, new_bits, MoveActionMirror, orientation, 0, -1);
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void generate_moves(GameState* state, MoveGeneration* generation)
+{
+    set_memory(0, sizeof(generation->reachable), generation->reachable);
+    set_memory(0, sizeof(generation->locked), generation->locked);
+    generation->lock_count = 0;
+
+    auto board = pack_board(state->board);
+    auto mirror_available = state->power_ups.mirror != 0;
+    for (auto orientation = 0; orientation < MOVE_GENERATOR_ORIENTATIONS; orientation++)
+    {
+        auto shape = &generation->orientations[orientation];
+        shape->valid = orientation < 4 || mirror_available;
+        if (!shape->valid) { continue; }
+        shape->cell_map = state->falling_shape.cell_map;
+        if (orientation >= 4) { mirror(&shape->cell_map); }
+        for (auto i = 0; i < (orientation & 3); i++) { rotate(&shape->cell_map); }
+        shape->canonical = orientation;
+        for (auto other = 0; other < orientation; other++)
+        {
+            if (generation->orientations[other].valid && cell_maps_equal(generation->orientations[other].cell_map, shape->cell_map))
+            {
+                shape->canonical = other;
+                break;
+            }
+        }
+        for (auto y = 0; y < shape->cell_map.height; y++) { shape->rows[y] = pack_cell_map_row(y, shape->cell_map); }
+        for (auto y = 0; y < BOARD_HEIGHT; y++) { shape->fits[y] = get_fitting_positions(shape, y, &board); }
+    }
+
+    auto spawn_x = state->falling_shape.x;
+    auto spawn_y = state->falling_shape.y;
+    if (spawn_x < 0 || spawn_x >= BOARD_WIDTH || spawn_y < 0 || spawn_y >= BOARD_HEIGHT) { return; }
+    if ((generation->orientations[0].fits[spawn_y] & (1u << spawn_x)) == 0) { return; }
+    mark_reached(generation, 0, spawn_y, 1u << spawn_x, MoveActionSpawn, 0, 0, spawn_x);
+
+    for (auto y = spawn_y; y < BOARD_HEIGHT; y++)
+    {
+        if (y > spawn_y)
+        {
+            auto any_reached = false;
+            for (auto orientation = 0; orientation < MOVE_GENERATOR_ORIENTATIONS; orientation++)
+            {
+                auto shape = &generation->orientations[orientation];
+                if (!shape->valid) { continue; }
+                auto fallen = generation->reachable[orientation][y - 1] & shape->fits[y];
+                if (fallen != 0)
+                {
+                    mark_reached(generation, orientation, y, fallen, MoveActionDown, orientation, 0, -1);
+                    any_reached = true;
+                }
+            }
+            if (!any_reached) { break; }
+        }
+
+        flood_fill_row(generation, y);
+
+        // a position locks when gravity can't move it any further
+        for (auto orientation = 0; orientation < MOVE_GENERATOR_ORIENTATIONS; orientation++)
+        {
+            auto shape = &generation->orientations[orientation];
+            if (!shape->valid) { continue; }
+            auto below = y + 1 < BOARD_HEIGHT ? shape->fits[y + 1] : 0;
+            auto locking = generation->reachable[orientation][y] & ~below & ~generation->locked[shape->canonical][y];
+            generation->locked[shape->canonical][y] |= locking;
+            for (auto x = 0; locking != 0; x++, locking >>= 1)
+            {
+                if ((locking & 1) == 0) { continue; }
+                auto lock = &generation->locks[generation->lock_count++];
+                lock->orientation = orientation;
+                lock->x = x;
+                lock->y = y;
+            }
+        }
+    }
+}
+
+// writes the moves from the spawn position to the lock position, returns how many there are
+int get_move_sequence(MoveGeneration* generation, LockPosition lock, MoveAction* actions, int capacity)
+{
+    auto count = 0;
+    auto orientation = lock.orientation;
+    auto x = lock.x;
+    auto y = lock.y;
+    while (true)
+    {
+        auto step = generation->steps[orientation][y][x];
+        if (step.action == MoveActionSpawn) { break; }
+        assert(count < capacity);
+        actions[count++] = (MoveAction)step.action;
+        if (step.action == MoveActionDown) { y--; }
+        orientation = step.parent_orientation;
+        x = step.parent_x;
+    }
+    for (auto i = 0; i < count / 2; i++)
+    {
+        auto temp = actions[i];
+        actions[i] = actions[count - i - 1];
+        actions[count - i - 1] = temp;
+    }
+    return count;
+}
@@ -0,0 +1,397 @@
+// Quantized neural network board evaluator, an alternative to scoring BotWeights features. It sees the same candidate
+// boards as the batch evaluator (shape cemented, full rows still in) and scores them in three integer layers:
+// - 178 binary inputs: the 160 cells of the board after clearing, which shape was placed, and 3 thermometer bits per
+//   power up (count above 0, 1, 2). Since they're all 0 or 1, the first layer just adds up the s16 weight rows of the
+//   inputs that are set, saturating, onto the biases.
+// - the 32 accumulator sums clamped to 0-127, times s8 weights into s32 sums, shifted down by NETWORK_HIDDEN_SHIFT and
+//   clamped to 0-127 again for the 32 hidden units.
+// - one s32 output from the hidden units times s8 weights, multiplied by output_scale.
+// Everything before output_scale is integer math done in the same order at every level, so the portable, SSE2 and AVX2
+// kernels give exactly the same scores. Cleared rows aren't an input; they still count weights.cleared_rows each, which
+// keeps the search's cleared rows bookkeeping the same with and without a network.
+//
+// Network files are a NetworkFileHeader followed by the arrays in BoardNetwork's order from feature_biases to
+// output_weights, all little endian with nothing in between.
+
+#define NETWORK_INPUTS 178
+#define NETWORK_SHAPE_INPUTS (BOARD_HEIGHT * BOARD_WIDTH)
+#define NETWORK_POWER_UP_INPUTS (NETWORK_SHAPE_INPUTS + countof(ALL_SHAPES) + 1)
+#define NETWORK_POWER_UP_LEVELS 3
+#define NETWORK_ACCUMULATORS 32
+#define NETWORK_HIDDEN 32
+#define NETWORK_HIDDEN_SHIFT 6
+#define NETWORK_FILE_VERSION 1
+#define MAX_NETWORK_ACTIVE_INPUTS (NETWORK_SHAPE_INPUTS + 1 + 4 * NETWORK_POWER_UP_LEVELS)
+
+static_assert(NETWORK_POWER_UP_INPUTS + 4 * NETWORK_POWER_UP_LEVELS == NETWORK_INPUTS, "network inputs are out of date");
+
+struct NetworkFileHeader
+{
+    char magic[4]; // "TNET"
+    u8 version;
+    u8 inputs;
+    u8 accumulators;
+    u8 hidden;
+    u8 hidden_shift;
+    u8 reserved[3];
+    float output_scale;
+};
+
+struct BoardNetwork
+{
+    float output_scale;
+    s16 feature_biases[NETWORK_ACCUMULATORS];
+    s16 feature_weights[NETWORK_INPUTS][NETWORK_ACCUMULATORS];
+    s32 hidden_biases[NETWORK_HIDDEN];
+    s8 hidden_weights[NETWORK_HIDDEN][NETWORK_ACCUMULATORS];
+    s32 output_bias;
+    s8 output_weights[NETWORK_HIDDEN];
+    // not in the file: hidden_weights widened for SSE2, which can't multiply bytes
+    s16 wide_hidden_weights[NETWORK_HIDDEN][NETWORK_ACCUMULATORS];
+};
+
+// the inputs that are set for each candidate of a BoardBatch
+struct BoardNetworkInputs
+{
+    u8 count[BOARD_BATCH_SIZE];
+    u8 active[BOARD_BATCH_SIZE][MAX_NETWORK_ACTIVE_INPUTS];
+    u8 full_rows[BOARD_BATCH_SIZE];
+    u8 lost[BOARD_BATCH_SIZE];
+};
+
+// state is the game before the placements, mirrored[i] says candidate i used up a mirror power up
+void get_board_network_inputs(BoardBatch* batch, GameState* state, bool* mirrored, BoardNetworkInputs* inputs)
+{
+    auto shape = get_shape_index(state->falling_shape.cell_map);
+    auto power_ups = &state->power_ups;
+    for (auto i = 0; i < batch->count; i++)
+    {
+        auto active = inputs->active[i];
+        auto count = 0;
+        // full rows are skipped, which drops everything above them down the way clearing does
+        auto target_y = BOARD_HEIGHT - 1;
+        for (auto y = BOARD_HEIGHT - 1; y >= 0; y--)
+        {
+            u32 row = batch->rows[y][i];
+            if (row == 0xff) { continue; }
+            for (; row != 0; row &= row - 1)
+            {
+                auto x = 0;
+                while ((row & (1u << x)) == 0) { x++; }
+                active[count++] = (u8)(target_y * BOARD_WIDTH + x);
+            }
+            target_y--;
+        }
+        inputs->full_rows[i] = (u8)(target_y + 1);
+        inputs->lost[i] = batch->rows[0][i] != 0;
+
+        active[count++] = (u8)(NETWORK_SHAPE_INPUTS + shape);
+        s32 counts[] = { power_ups->mirror - mirrored[i], power_ups->fill_cell, power_ups->invert_board, power_ups->bomb };
+        for (auto power_up = 0; power_up < countof(counts); power_up++)
+        {
+            for (auto level = 0; level < NETWORK_POWER_UP_LEVELS && level < counts[power_up]; level++)
+            { active[count++] = (u8)(NETWORK_POWER_UP_INPUTS + power_up * NETWORK_POWER_UP_LEVELS + level); }
+        }
+        inputs->count[i] = (u8)count;
+    }
+}
+
+s16 add_saturated(s16 left, s16 right) { return (s16)MIN(MAX((s32)left + right, -32768), 32767); }
+
+s32 clamp_activation(s32 value) { return MIN(MAX(value, 0), 127); }
+
+void evaluate_board_network_portable(BoardNetwork* network, BoardNetworkInputs* inputs, int count, s32* outputs)
+{
+    for (auto i = 0; i < count; i++)
+    {
+        s16 accumulators[NETWORK_ACCUMULATORS];
+        copy_memory(sizeof(accumulators), network->feature_biases, accumulators);
+        for (auto input = 0; input < inputs->count[i]; input++)
+        {
+            auto weights = network->feature_weights[inputs->active[i][input]];
+            for (auto j = 0; j < NETWORK_ACCUMULATORS; j++) { accumulators[j] = add_saturated(accumulators[j], weights[j]); }
+        }
+        s32 output = network->output_bias;
+        for (auto k = 0; k < NETWORK_HIDDEN; k++)
+        {
+            auto sum = network->hidden_biases[k];
+            for (auto j = 0; j < NETWORK_ACCUMULATORS; j++) { sum += clamp_activation(accumulators[j]) * network->hidden_weights[k][j]; }
+            output += clamp_activation(sum >> NETWORK_HIDDEN_SHIFT) * network->output_weights[k];
+        }
+        outputs[i] = output;
+    }
+}
+
+#ifdef MEMORY_PRIMITIVES_X86
+
+#if NETWORK_ACCUMULATORS != 32 || NETWORK_HIDDEN != 32
+#error "the SIMD network kernels are written for 32 accumulators and 32 hidden units"
+#endif
+
+// [sum of a, sum of b, sum of c, sum of d]
+TARGET_SSE2 __m128i sum_4x4_sse2(__m128i a, __m128i b, __m128i c, __m128i d)
+{
+    auto ab = _mm_add_epi32(_mm_unpacklo_epi32(a, b), _mm_unpackhi_epi32(a, b));
+    auto cd = _mm_add_epi32(_mm_unpacklo_epi32(c, d), _mm_unpackhi_epi32(c, d));
+    return _mm_add_epi32(_mm_unpacklo_epi64(ab, cd), _mm_unpackhi_epi64(ab, cd));
+}
+
+TARGET_SSE2 void evaluate_board_network_sse2(BoardNetwork* network, BoardNetworkInputs* inputs, int count, s32* outputs)
+{
+    auto zero = _mm_setzero_si128();
+    auto max_activation = _mm_set1_epi16(127);
+    for (auto i = 0; i < count; i++)
+    {
+        __m128i accumulators[4];
+        for (auto j = 0; j < 4; j++) { accumulators[j] = _mm_loadu_si128((__m128i*)network->feature_biases + j); }
+        for (auto input = 0; input < inputs->count[i]; input++)
+        {
+            auto weights = (__m128i*)network->feature_weights[inputs->active[i][input]];
+            for (auto j = 0; j < 4; j++) { accumulators[j] = _mm_adds_epi16(accumulators[j], _mm_loadu_si128(weights + j)); }
+        }
+        for (auto j = 0; j < 4; j++) { accumulators[j] = _mm_min_epi16(_mm_max_epi16(accumulators[j], zero), max_activation); }
+
+        __m128i hidden[NETWORK_HIDDEN / 4];
+        for (auto k = 0; k < NETWORK_HIDDEN; k += 4)
+        {
+            __m128i sums[4];
+            for (auto unit = 0; unit < 4; unit++)
+            {
+                auto weights = (__m128i*)network->wide_hidden_weights[k + unit];
+                auto sum = _mm_madd_epi16(accumulators[0], _mm_loadu_si128(weights));
+                for (auto j = 1; j < 4; j++) { sum = _mm_add_epi32(sum, _mm_madd_epi16(accumulators[j], _mm_loadu_si128(weights + j))); }
+                sums[unit] = sum;
+            }
+            auto sum = _mm_add_epi32(sum_4x4_sse2(sums[0], sums[1], sums[2], sums[3]), _mm_loadu_si128((__m128i*)&network->hidden_biases[k]));
+            hidden[k / 4] = _mm_srai_epi32(sum, NETWORK_HIDDEN_SHIFT);
+        }
+        // s32 to s16 saturates without changing anything that gets clamped to 0-127
+        __m128i activations[4];
+        for (auto j = 0; j < 4; j++)
+        {
+            auto packed = _mm_packs_epi32(hidden[2 * j], hidden[2 * j + 1]);
+            activations[j] = _mm_min_epi16(_mm_max_epi16(packed, zero), max_activation);
+        }
+
+        auto output_weights = _mm_loadu_si128((__m128i*)network->output_weights);
+        auto low_weights = _mm_srai_epi16(_mm_unpacklo_epi8(output_weights, output_weights), 8);
+        auto high_weights = _mm_srai_epi16(_mm_unpackhi_epi8(output_weights, output_weights), 8);
+        output_weights = _mm_loadu_si128((__m128i*)network->output_weights + 1);
+        auto sum = _mm_add_epi32(_mm_madd_epi16(activations[0], low_weights), _mm_madd_epi16(activations[1], high_weights));
+        low_weights = _mm_srai_epi16(_mm_unpacklo_epi8(output_weights, output_weights), 8);
+        high_weights = _mm_srai_epi16(_mm_unpackhi_epi8(output_weights, output_weights), 8);
+        sum = _mm_add_epi32(sum, _mm_add_epi32(_mm_madd_epi16(activations[2], low_weights), _mm_madd_epi16(activations[3], high_weights)));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+        outputs[i] = network->output_bias + _mm_cvtsi128_si32(sum);
+    }
+}
+
+// [sum of a, sum of b, sum of c, sum of d]
+TARGET_AVX2 __m128i sum_4x8_avx2(__m256i a, __m256i b, __m256i c, __m256i d)
+{
+    auto sums = _mm256_hadd_epi32(_mm256_hadd_epi32(a, b), _mm256_hadd_epi32(c, d));
+    return _mm_add_epi32(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+}
+
+TARGET_AVX2 void evaluate_board_network_avx2(BoardNetwork* network, BoardNetworkInputs* inputs, int count, s32* outputs)
+{
+    auto zero = _mm256_setzero_si256();
+    auto ones = _mm256_set1_epi16(1);
+    for (auto i = 0; i < count; i++)
+    {
+        auto low = _mm256_loadu_si256((__m256i*)network->feature_biases);
+        auto high = _mm256_loadu_si256((__m256i*)network->feature_biases + 1);
+        for (auto input = 0; input < inputs->count[i]; input++)
+        {
+            auto weights = (__m256i*)network->feature_weights[inputs->active[i][input]];
+            low = _mm256_adds_epi16(low, _mm256_loadu_si256(weights));
+            high = _mm256_adds_epi16(high, _mm256_loadu_si256(weights + 1));
+        }
+        // packing saturates to -128-127 and works within each 128 bit lane, so the permute puts the bytes back in order
+        auto accumulators = _mm256_max_epi8(_mm256_permute4x64_epi64(_mm256_packs_epi16(low, high), _MM_SHUFFLE(3, 1, 2, 0)), zero);
+
+        // each pair of u8 × s8 products is at most 2 × 127 × 128, so the s16 sums never saturate
+        __m128i hidden[NETWORK_HIDDEN / 4];
+        for (auto k = 0; k < NETWORK_HIDDEN; k += 4)
+        {
+            __m256i sums[4];
+            for (auto unit = 0; unit < 4; unit++)
+            {
+                auto products = _mm256_maddubs_epi16(accumulators, _mm256_loadu_si256((__m256i*)network->hidden_weights[k + unit]));
+                sums[unit] = _mm256_madd_epi16(products, ones);
+            }
+            auto sum = _mm_add_epi32(sum_4x8_avx2(sums[0], sums[1], sums[2], sums[3]), _mm_loadu_si128((__m128i*)&network->hidden_biases[k]));
+            hidden[k / 4] = _mm_srai_epi32(sum, NETWORK_HIDDEN_SHIFT);
+        }
+        auto packed_low = _mm_packs_epi32(hidden[0], hidden[1]);
+        auto packed_high = _mm_packs_epi32(hidden[2], hidden[3]);
+        auto activations = _mm256_set_m128i(_mm_packs_epi16(_mm_packs_epi32(hidden[4], hidden[5]), _mm_packs_epi32(hidden[6], hidden[7])),
+            _mm_packs_epi16(packed_low, packed_high));
+        activations = _mm256_max_epi8(activations, zero);
+
+        auto products = _mm256_maddubs_epi16(activations, _mm256_loadu_si256((__m256i*)network->output_weights));
+        auto sum = _mm256_madd_epi16(products, ones);
+        auto half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+        outputs[i] = network->output_bias + _mm_cvtsi128_si32(half);
+    }
+}
+
+#endif
+
+struct BoardNetworkEvaluator
+{
+    MemoryPrimitivesLevel level;
+    void (*evaluate)(BoardNetwork* network, BoardNetworkInputs* inputs, int count, s32* outputs);
+};
+
+BoardNetworkEvaluator make_board_network_evaluator(MemoryPrimitivesLevel level)
+{
+    BoardNetworkEvaluator result;
+    result.level = MemoryPrimitivesLevelPortable;
+    result.evaluate = evaluate_board_network_portable;
+#ifdef MEMORY_PRIMITIVES_X86
+    if (level == MemoryPrimitivesLevelSSE2)
+    {
+        result.level = level;
+        result.evaluate = evaluate_board_network_sse2;
+    }
+    else if (level == MemoryPrimitivesLevelAVX2)
+    {
+        result.level = level;
+        result.evaluate = evaluate_board_network_avx2;
+    }
+#endif
+    return result;
+}
+
+BoardNetworkEvaluator g_board_network_evaluator = make_board_network_evaluator(MemoryPrimitivesLevelPortable);
+
+// picks the same instruction set as the memory primitives
+void initialize_board_network_evaluator() { g_board_network_evaluator = make_board_network_evaluator(get_best_memory_primitives_level()); }
+
+// the network bot placements get scored with instead of BotWeights features; NULL when none is loaded
+BoardNetwork* g_board_network;
+
+// scores[i] for candidate i, the same as evaluate_board_batch but with the network standing in for the board features
+void evaluate_board_network_batch(BoardNetworkEvaluator evaluator, BoardNetwork* network, BoardNetworkInputs* inputs, int count, BotWeights weights, int cleared_rows_offset, float* scores)
+{
+    s32 outputs[BOARD_BATCH_SIZE];
+    evaluator.evaluate(network, inputs, count, outputs);
+    for (auto i = 0; i < count; i++)
+    {
+        if (inputs->lost[i]) { scores[i] = LOST_GAME_SCORE; }
+        else { scores[i] = outputs[i] * network->output_scale + (cleared_rows_offset + inputs->full_rows[i]) * weights.cleared_rows; }
+    }
+}
+
+#define NETWORK_FILE_SIZE (sizeof(NetworkFileHeader) + offsetof(BoardNetwork, wide_hidden_weights) - offsetof(BoardNetwork, feature_biases))
+
+static_assert(sizeof(NetworkFileHeader) == 16, "network files need the header without padding");
+static_assert(NETWORK_FILE_SIZE == sizeof(NetworkFileHeader) + sizeof(BoardNetwork::feature_biases) + sizeof(BoardNetwork::feature_weights)
+    + sizeof(BoardNetwork::hidden_biases) + sizeof(BoardNetwork::hidden_weights) + sizeof(s32) + sizeof(BoardNetwork::output_weights),
+    "network files need the arrays without padding");
+
+void prepare_board_network(BoardNetwork* network)
+{
+    for (auto k = 0; k < NETWORK_HIDDEN; k++)
+    {
+        for (auto j = 0; j < NETWORK_ACCUMULATORS; j++) { network->wide_hidden_weights[k][j] = network->hidden_weights[k][j]; }
+    }
+}
+
+// returns NULL if the file can't be read or isn't a network of this shape; free with SDL_free
+BoardNetwork* load_board_network(char* file_name)
+{
+    auto buffer = (u8*)SDL_malloc(NETWORK_FILE_SIZE + 1);
+    if (buffer == NULL) { panic("Out of memory for the network file"); }
+    auto size = platform_read_file(file_name, buffer, NETWORK_FILE_SIZE + 1);
+    NetworkFileHeader header;
+    set_memory(0, sizeof(header), &header);
+    if (size == NETWORK_FILE_SIZE) { copy_memory(sizeof(header), buffer, &header); }
+    auto valid = size == NETWORK_FILE_SIZE
+        && memory_equals(4, header.magic, (void*)"TNET")
+        && header.version == NETWORK_FILE_VERSION
+        && header.inputs == NETWORK_INPUTS
+        && header.accumulators == NETWORK_ACCUMULATORS
+        && header.hidden == NETWORK_HIDDEN
+        && header.hidden_shift == NETWORK_HIDDEN_SHIFT;
+    BoardNetwork* result = NULL;
+    if (valid)
+    {
+        result = (BoardNetwork*)SDL_malloc(sizeof(BoardNetwork));
+        if (result == NULL) { panic("Out of memory for the network"); }
+        result->output_scale = header.output_scale;
+        copy_memory(NETWORK_FILE_SIZE - sizeof(header), buffer + sizeof(header), result->feature_biases);
+        prepare_board_network(result);
+    }
+    SDL_free(buffer);
+    return result;
+}
+
+bool save_board_network(char* file_name, BoardNetwork* network)
+{
+    auto buffer = (u8*)SDL_malloc(NETWORK_FILE_SIZE);
+    if (buffer == NULL) { panic("Out of memory for the network file"); }
+    NetworkFileHeader header;
+    set_memory(0, sizeof(header), &header);
+    copy_memory(4, (void*)"TNET", header.magic);
+    header.version = NETWORK_FILE_VERSION;
+    header.inputs = NETWORK_INPUTS;
+    header.accumulators = NETWORK_ACCUMULATORS;
+    header.hidden = NETWORK_HIDDEN;
+    header.hidden_shift = NETWORK_HIDDEN_SHIFT;
+    header.output_scale = network->output_scale;
+    copy_memory(sizeof(header), &header, buffer);
+    copy_memory(NETWORK_FILE_SIZE - sizeof(header), network->feature_biases, buffer + sizeof(header));
+    auto result = platform_write_file(file_name, buffer, NETWORK_FILE_SIZE);
+    SDL_free(buffer);
+    return result;
+}
+
+// small random weights, as a starting point for training or something to benchmark
+void randomize_board_network(s32 seed, BoardNetwork* network)
+{
+    RandomNumberGenerator random;
+    seed_random_number_generator(seed, &random);
+    network->output_scale = 1.0f / 256.0f;
+    for (auto j = 0; j < NETWORK_ACCUMULATORS; j++) { network->feature_biases[j] = (s16)get_random_number_in_range(0, 32, &random); }
+    for (auto input = 0; input < NETWORK_INPUTS; input++)
+    {
+        for (auto j = 0; j < NETWORK_ACCUMULATORS; j++) { network->feature_weights[input][j] = (s16)get_random_number_in_range(-16, 17, &random); }
+    }
+    for (auto k = 0; k < NETWORK_HIDDEN; k++)
+    {
+        network->hidden_biases[k] = get_random_number_in_range(0, 64, &random);
+        for (auto j = 0; j < NETWORK_ACCUMULATORS; j++) { network->hidden_weights[k][j] = (s8)get_random_number_in_range(-64, 65, &random); }
+        network->output_weights[k] = (s8)get_random_number_in_range(-64, 65, &random);
+    }
+    network->output_bias = 0;
+    prepare_board_network(network);
+}
+
+int write_random_board_network(char* file_name, s32 seed)
+{
+    auto network = (BoardNetwork*)SDL_malloc(sizeof(BoardNetwork));
+    if (network == NULL) { panic("Out of memory for the network"); }
+    randomize_board_network(seed, network);
+    auto written = save_board_network(file_name, network);
+    SDL_free(network);
+    if (!written)
+    {
+        print("Can't write the network file\n");
+        return 1;
+    }
+    return 0;
+}
+
+// TETRIS_NETWORK makes the bot score placements with the network in that file
+void load_board_network_from_environment()
+{
+    auto file_name = SDL_getenv("TETRIS_NETWORK");
+    if (file_name == NULL) { return; }
+    g_board_network = load_board_network(file_name);
+    if (g_board_network == NULL) { panic("Can't load the network file named by TETRIS_NETWORK"); }
+}
@@ -0,0 +1,199 @@
+// Perft: counts every placement sequence from a fixed position to a given depth, with every one of ALL_SHAPES tried as
+// each next shape. The counts only stay the same while collision, rotation, mirroring, line clears and game over all
+// behave exactly as before, so a mismatch against the stored counts points at a rules or move generator regression.
+// Lost games have no successors. The last level is counted straight from the move generator without placing anything.
+
+#define PERFT_MAX_DEPTH 4
+#define DEFAULT_PERFT_DEPTH 3
+
+struct PerftPosition
+{
+    char* name;
+    s32 seed;
+    // board rows from the bottom up, '#' for a filled cell; NULL keeps the seed's two-row starting layout
+    char* rows[BOARD_HEIGHT];
+    u64 expected[PERFT_MAX_DEPTH]; // leaf counts for depths 1 to PERFT_MAX_DEPTH
+};
+
+PerftPosition PERFT_POSITIONS[] =
+{
+    { "start, seed 1", 1, { NULL }, { 52, 5690, 624404, 68747800 } },
+    { "start, seed 2", 2, { NULL }, { 7, 875, 102712, 11756697 } },
+    { "start, seed 3", 3, { NULL }, { 14, 1750, 206461, 23864475 } },
+    {
+        "overhangs", 4,
+        {
+            "###.####",
+            "##..##.#",
+            "#......#",
+            "..##..##",
+            "...#....",
+        },
+        { 26, 3378, 405489, 47002735 }
+    },
+    {
+        "almost full rows", 5,
+        {
+            "#######.",
+            ".#######",
+            "###.####",
+            "####.###",
+            "##.#####",
+            "#####.##",
+        },
+        { 26, 2840, 310794, 34124803 }
+    },
+    {
+        "high stack", 6,
+        {
+            "#.######", "##.#####", "###.####", "####.###", "#####.##", "######.#", "#.######", "##.#####",
+            "###.####", "####.###", "#####.##", "######.#", "#.######", "##.#####", "###.####",
+            "#.......", "##......",
+        },
+        { 27, 2242, 114570, 4104002 }
+    },
+};
+
+void set_up_perft_position(PerftPosition* position, GameState* state)
+{
+    initialize_game_state(position->seed, state);
+    if (position->rows[0] == NULL) { return; }
+    for (auto y = 0; y < BOARD_HEIGHT; y++)
+    {
+        for (auto x = 0; x < BOARD_WIDTH; x++) { set_cell(x, y, false, &state->board); }
+    }
+    for (auto i = 0; i < BOARD_HEIGHT && position->rows[i] != NULL; i++)
+    {
+        auto y = BOARD_HEIGHT - 1 - i;
+        for (auto x = 0; x < BOARD_WIDTH; x++) { set_cell(x, y, position->rows[i][x] == '#', &state->board); }
+    }
+    state->board_hash = hash_board(state->board);
+}
+
+Placement get_lock_placement(LockPosition lock)
+{
+    Placement result;
+    set_memory(0, sizeof(result), &result);
+    result.rotations = lock.orientation & 3;
+    result.mirrored = lock.orientation >= 4;
+    result.x = lock.x;
+    result.y = lock.y;
+    return result;
+}
+
+u64 perft(GameState* state, int depth)
+{
+    MoveGeneration generation;
+    generate_moves(state, &generation);
+    if (depth == 1) { return generation.lock_count; }
+
+    u64 result = 0;
+    for (auto i = 0; i < generation.lock_count; i++)
+    {
+        auto child = *state;
+        apply_placement(get_lock_placement(generation.locks[i]), &child);
+        if (child.mode == GameModeLost) { continue; }
+        for (auto shape = 0; shape < countof(ALL_SHAPES); shape++)
+        {
+            auto next = child;
+            spawn_falling_shape(*ALL_SHAPES[shape], &next);
+            result += perft(&next, depth - 1);
+        }
+    }
+    return result;
+}
+
+struct PerftRoot
+{
+    GameState* state;
+    MoveGeneration generation;
+    int depth;
+    u64 counts[MAX_LOCK_POSITIONS];
+};
+
+// the first level is split over the job system, one root placement per job
+void run_perft_roots(void* data, int begin, int end)
+{
+    auto root = (PerftRoot*)data;
+    for (auto i = begin; i < end; i++)
+    {
+        auto child = *root->state;
+        apply_placement(get_lock_placement(root->generation.locks[i]), &child);
+        root->counts[i] = 0;
+        if (child.mode == GameModeLost) { continue; }
+        for (auto shape = 0; shape < countof(ALL_SHAPES); shape++)
+        {
+            auto next = child;
+            spawn_falling_shape(*ALL_SHAPES[shape], &next);
+            root->counts[i] += perft(&next, root->depth - 1);
+        }
+    }
+}
+
+u64 run_parallel_perft(GameState* state, int depth)
+{
+    auto root = (PerftRoot*)SDL_malloc(sizeof(PerftRoot));
+    if (root == NULL) { panic("Out of memory for perft"); }
+    root->state = state;
+    root->depth = depth;
+    generate_moves(state, &root->generation);
+    u64 result = root->generation.lock_count;
+    if (depth > 1)
+    {
+        parallel_for(run_perft_roots, root, root->generation.lock_count, 1);
+        result = 0;
+        for (auto i = 0; i < root->generation.lock_count; i++) { result += root->counts[i]; }
+    }
+    SDL_free(root);
+    return result;
+}
+
+// returns non-zero if any count differs from the stored one
+int run_perft(int max_depth)
+{
+    initialize_shape_cell_maps();
+    reset_job_stats();
+    auto failures = 0;
+    u64 total_nodes = 0;
+    u64 total_nanoseconds = 0;
+    for (auto position_index = 0; position_index < countof(PERFT_POSITIONS); position_index++)
+    {
+        auto position = &PERFT_POSITIONS[position_index];
+        GameState state;
+        set_up_perft_position(position, &state);
+        for (auto depth = 1; depth <= max_depth; depth++)
+        {
+            auto start = get_monotonic_nanoseconds();
+            auto nodes = run_parallel_perft(&state, depth);
+            auto nanoseconds = get_monotonic_nanoseconds() - start;
+            total_nodes += nodes;
+            total_nanoseconds += nanoseconds;
+
+            print(position->name);
+            print(", depth ");
+            print((s64)depth);
+            print(": ");
+            print(nodes);
+            print(" nodes, ");
+            print(get_nodes_per_second(nodes, nanoseconds));
+            print(" nodes/sec");
+            if (depth > PERFT_MAX_DEPTH) { print(", no stored count\n"); continue; }
+            auto expected = position->expected[depth - 1];
+            if (nodes == expected) { print(", OK\n"); }
+            else
+            {
+                print(", MISMATCH, expected ");
+                print(expected);
+                print("\n");
+                failures++;
+            }
+        }
+    }
+    print("total: ");
+    print(total_nodes);
+    print(" nodes, ");
+    print(get_nodes_per_second(total_nodes, total_nanoseconds));
+    print(" nodes/sec\n");
+    print_job_stats();
+    return failures == 0 ? 0 : 1;
+}
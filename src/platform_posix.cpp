@@ -0,0 +1,269 @@
+bool platform_write_to_stdout(char* data, u64 size)
+{
+    while (size != 0)
+    {
+        auto written = write(STDOUT_FILENO, data, size);
+        if (written < 0)
+        {
+            if (errno == EINTR) { continue; }
+            break;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+void platform_show_error_and_exit(char* message)
+{
+    // there may be no display to show a message box on, so stderr is the only reliable place for the error
+    write(STDERR_FILENO, message, c_string_length(message));
+    write(STDERR_FILENO, "\n", 1);
+    _exit(1);
+}
+
+SystemTime get_system_time()
+{
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    tm calendar_time;
+    gmtime_r(&now.tv_sec, &calendar_time);
+    SystemTime result;
+    result.year = calendar_time.tm_year + 1900;
+    result.month = calendar_time.tm_mon + 1;
+    result.day = calendar_time.tm_mday;
+    result.hour = calendar_time.tm_hour;
+    result.minute = calendar_time.tm_min;
+    result.second = calendar_time.tm_sec;
+    result.milliseconds = now.tv_nsec / 1000000;
+    return result;
+}
+
+u64 get_monotonic_nanoseconds()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000000ULL + (u64)now.tv_nsec;
+}
+
+s64 platform_read_file(char* file_name, void* buffer, u64 buffer_size)
+{
+    auto file = open(file_name, O_RDONLY);
+    if (file < 0) { return -1; }
+    u64 total = 0;
+    while (total < buffer_size)
+    {
+        auto bytes_read = read(file, (char*)buffer + total, buffer_size - total);
+        if (bytes_read < 0 && errno == EINTR) { continue; }
+        if (bytes_read < 0)
+        {
+            close(file);
+            return -1;
+        }
+        if (bytes_read == 0) { break; }
+        total += bytes_read;
+    }
+    close(file);
+    return total;
+}
+
+bool write_to_file(int flags, char* file_name, void* data, u64 size)
+{
+    auto file = open(file_name, flags, 0644);
+    if (file < 0) { return false; }
+    u64 total = 0;
+    while (total < size)
+    {
+        auto written = write(file, (char*)data + total, size - total);
+        if (written < 0 && errno == EINTR) { continue; }
+        if (written < 0) { break; }
+        total += written;
+    }
+    close(file);
+    return total == size;
+}
+
+bool platform_write_file(char* file_name, void* data, u64 size) { return write_to_file(O_WRONLY | O_CREAT | O_TRUNC, file_name, data, size); }
+
+bool platform_append_file(char* file_name, void* data, u64 size) { return write_to_file(O_WRONLY | O_CREAT | O_APPEND, file_name, data, size); }
+
+// in one step, so whoever opens target gets either the old file or the new one
+bool platform_replace_file(char* source, char* target) { return rename(source, target) == 0; }
+
+bool platform_pin_thread_to_core(int core)
+{
+#ifdef __linux__
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(core, &cpus);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+#else
+    return false;
+#endif
+}
+
+bool platform_enable_terminal_escapes() { return isatty(STDOUT_FILENO) == 1; }
+
+s64 platform_open_udp_socket(u16 port)
+{
+    auto result = socket(AF_INET, SOCK_DGRAM, 0);
+    if (result < 0) { return -1; }
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (bind(result, (sockaddr*)&address, sizeof(address)) < 0 || fcntl(result, F_SETFL, O_NONBLOCK) < 0)
+    {
+        close(result);
+        return -1;
+    }
+    return result;
+}
+
+bool platform_send_udp(s64 socket, u32 address, u16 port, void* data, u64 size)
+{
+    sockaddr_in destination = {};
+    destination.sin_family = AF_INET;
+    destination.sin_addr.s_addr = htonl(address);
+    destination.sin_port = htons(port);
+    return sendto((int)socket, data, size, 0, (sockaddr*)&destination, sizeof(destination)) == (ssize_t)size;
+}
+
+s64 platform_receive_udp(s64 socket, void* buffer, u64 buffer_size, u32* address, u16* port)
+{
+    while (true)
+    {
+        sockaddr_in source = {};
+        socklen_t source_size = sizeof(source);
+        auto received = recvfrom((int)socket, buffer, buffer_size, 0, (sockaddr*)&source, &source_size);
+        if (received < 0 && errno == EINTR) { continue; }
+        if (received < 0) { return -1; }
+        *address = ntohl(source.sin_addr.s_addr);
+        *port = ntohs(source.sin_port);
+        return received;
+    }
+}
+
+void platform_close_udp_socket(s64 socket) { close((int)socket); }
+
+#ifdef __linux__
+#define MAX_UDP_BATCH 64
+
+int platform_send_udp_batch(s64 socket, UdpDatagram* datagrams, int count)
+{
+    auto sent = 0;
+    for (auto first = 0; first < count; )
+    {
+        mmsghdr messages[MAX_UDP_BATCH] = {};
+        iovec vectors[MAX_UDP_BATCH];
+        sockaddr_in destinations[MAX_UDP_BATCH] = {};
+        auto batch = MIN(count - first, MAX_UDP_BATCH);
+        for (auto i = 0; i < batch; i++)
+        {
+            auto datagram = &datagrams[first + i];
+            destinations[i].sin_family = AF_INET;
+            destinations[i].sin_addr.s_addr = htonl(datagram->address);
+            destinations[i].sin_port = htons(datagram->port);
+            vectors[i].iov_base = datagram->data;
+            vectors[i].iov_len = datagram->size;
+            messages[i].msg_hdr.msg_name = &destinations[i];
+            messages[i].msg_hdr.msg_namelen = sizeof(destinations[i]);
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+        auto result = sendmmsg((int)socket, messages, batch, 0);
+        if (result < 0 && errno == EINTR) { continue; }
+        // the datagram that failed is skipped, the same as a failed sendto
+        if (result <= 0) { first++; }
+        else
+        {
+            first += result;
+            sent += result;
+        }
+    }
+    return sent;
+}
+
+int platform_receive_udp_batch(s64 socket, UdpDatagram* datagrams, int count)
+{
+    mmsghdr messages[MAX_UDP_BATCH] = {};
+    iovec vectors[MAX_UDP_BATCH];
+    sockaddr_in sources[MAX_UDP_BATCH];
+    count = MIN(count, MAX_UDP_BATCH);
+    for (auto i = 0; i < count; i++)
+    {
+        vectors[i].iov_base = datagrams[i].data;
+        vectors[i].iov_len = datagrams[i].size;
+        messages[i].msg_hdr.msg_name = &sources[i];
+        messages[i].msg_hdr.msg_namelen = sizeof(sources[i]);
+        messages[i].msg_hdr.msg_iov = &vectors[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+    int result;
+    while ((result = recvmmsg((int)socket, messages, count, 0, NULL)) < 0 && errno == EINTR) {}
+    if (result < 0) { return 0; }
+    for (auto i = 0; i < result; i++)
+    {
+        datagrams[i].address = ntohl(sources[i].sin_addr.s_addr);
+        datagrams[i].port = ntohs(sources[i].sin_port);
+        datagrams[i].size = messages[i].msg_len;
+    }
+    return result;
+}
+
+s64 platform_open_udp_poller(s64 socket)
+{
+    auto result = epoll_create1(0);
+    if (result < 0) { return -1; }
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = (int)socket;
+    if (epoll_ctl(result, EPOLL_CTL_ADD, (int)socket, &event) < 0)
+    {
+        close(result);
+        return -1;
+    }
+    return result;
+}
+
+bool platform_wait_for_udp(s64 poller, int timeout_ms)
+{
+    epoll_event event;
+    return epoll_wait((int)poller, &event, 1, timeout_ms) > 0;
+}
+
+void platform_close_udp_poller(s64 poller) { close((int)poller); }
+#else
+int platform_send_udp_batch(s64 socket, UdpDatagram* datagrams, int count)
+{
+    auto sent = 0;
+    for (auto i = 0; i < count; i++)
+    { sent += platform_send_udp(socket, datagrams[i].address, datagrams[i].port, datagrams[i].data, datagrams[i].size); }
+    return sent;
+}
+
+int platform_receive_udp_batch(s64 socket, UdpDatagram* datagrams, int count)
+{
+    for (auto i = 0; i < count; i++)
+    {
+        auto datagram = &datagrams[i];
+        auto size = platform_receive_udp(socket, datagram->data, datagram->size, &datagram->address, &datagram->port);
+        if (size < 0) { return i; }
+        datagram->size = (u64)size;
+    }
+    return count;
+}
+
+// the poller is the socket itself
+s64 platform_open_udp_poller(s64 socket) { return socket; }
+
+bool platform_wait_for_udp(s64 poller, int timeout_ms)
+{
+    pollfd descriptor = {};
+    descriptor.fd = (int)poller;
+    descriptor.events = POLLIN;
+    return poll(&descriptor, 1, timeout_ms) > 0;
+}
+
+void platform_close_udp_poller(s64 poller) {}
+#endif
@@ -0,0 +1,187 @@
+HANDLE g_stdout = NULL;
+
+bool platform_write_to_stdout(char* data, u64 size)
+{
+    if (g_stdout == NULL)
+    {
+        g_stdout = GetStdHandle(STD_OUTPUT_HANDLE);
+        if (g_stdout == NULL || g_stdout == INVALID_HANDLE_VALUE) { return false; }
+    }
+    WriteFile(g_stdout, data, size, NULL, NULL);
+    return true;
+}
+
+void platform_show_error_and_exit(char* message)
+{
+    MessageBoxA(NULL, message, "Error", MB_OK);
+    ExitProcess(1);
+}
+
+SystemTime get_system_time()
+{
+    SystemTime result;
+    SYSTEMTIME windows_system_time;
+    GetSystemTime(&windows_system_time);
+    result.year = windows_system_time.wYear;
+    result.month = windows_system_time.wMonth;
+    result.day = windows_system_time.wDay;
+    result.hour = windows_system_time.wHour;
+    result.minute = windows_system_time.wMinute;
+    result.second = windows_system_time.wSecond;
+    result.milliseconds = windows_system_time.wMilliseconds;
+    return result;
+}
+
+u64 get_monotonic_nanoseconds()
+{
+    static LARGE_INTEGER frequency;
+    if (frequency.QuadPart == 0) { QueryPerformanceFrequency(&frequency); }
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    // split to avoid overflowing when multiplying large counter values by a billion
+    auto seconds = (u64)counter.QuadPart / (u64)frequency.QuadPart;
+    auto remainder = (u64)counter.QuadPart % (u64)frequency.QuadPart;
+    return seconds * 1000000000ULL + remainder * 1000000000ULL / (u64)frequency.QuadPart;
+}
+
+s64 platform_read_file(char* file_name, void* buffer, u64 buffer_size)
+{
+    auto file_handle = CreateFileA(
+        file_name,
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        NULL,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        NULL
+    );
+    if (file_handle == INVALID_HANDLE_VALUE) { return -1; }
+    DWORD bytes_read = 0;
+    auto success = ReadFile(file_handle, buffer, buffer_size, &bytes_read, NULL);
+    CloseHandle(file_handle);
+    if (!success) { return -1; }
+    return bytes_read;
+}
+
+bool write_to_file(DWORD access, DWORD creation, char* file_name, void* data, u64 size)
+{
+    auto file_handle = CreateFileA(
+        file_name,
+        access,
+        FILE_SHARE_READ,
+        NULL,
+        creation,
+        FILE_ATTRIBUTE_NORMAL,
+        NULL
+    );
+    if (file_handle == INVALID_HANDLE_VALUE) { return false; }
+    DWORD bytes_written = 0;
+    auto success = WriteFile(file_handle, data, size, &bytes_written, NULL);
+    CloseHandle(file_handle);
+    return success && bytes_written == size;
+}
+
+bool platform_write_file(char* file_name, void* data, u64 size) { return write_to_file(GENERIC_WRITE, CREATE_ALWAYS, file_name, data, size); }
+
+bool platform_append_file(char* file_name, void* data, u64 size) { return write_to_file(FILE_APPEND_DATA, OPEN_ALWAYS, file_name, data, size); }
+
+// in one step, so whoever opens target gets either the old file or the new one
+bool platform_replace_file(char* source, char* target) { return MoveFileExA(source, target, MOVEFILE_REPLACE_EXISTING) != 0; }
+
+bool platform_pin_thread_to_core(int core)
+{
+    return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << core) != 0;
+}
+
+// consoles only interpret escape sequences once asked to
+bool platform_enable_terminal_escapes()
+{
+    auto handle = GetStdHandle(STD_OUTPUT_HANDLE);
+    DWORD mode;
+    if (handle == NULL || handle == INVALID_HANDLE_VALUE || !GetConsoleMode(handle, &mode)) { return false; }
+    return SetConsoleMode(handle, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING) != 0;
+}
+
+s64 platform_open_udp_socket(u16 port)
+{
+    static bool winsock_started;
+    if (!winsock_started)
+    {
+        WSADATA winsock_data;
+        if (WSAStartup(MAKEWORD(2, 2), &winsock_data) != 0) { return -1; }
+        winsock_started = true;
+    }
+    auto result = socket(AF_INET, SOCK_DGRAM, 0);
+    if (result == INVALID_SOCKET) { return -1; }
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    u_long non_blocking = 1;
+    if (bind(result, (sockaddr*)&address, sizeof(address)) != 0 || ioctlsocket(result, FIONBIO, &non_blocking) != 0)
+    {
+        closesocket(result);
+        return -1;
+    }
+    return (s64)result;
+}
+
+bool platform_send_udp(s64 socket, u32 address, u16 port, void* data, u64 size)
+{
+    sockaddr_in destination = {};
+    destination.sin_family = AF_INET;
+    destination.sin_addr.s_addr = htonl(address);
+    destination.sin_port = htons(port);
+    return sendto((SOCKET)socket, (char*)data, (int)size, 0, (sockaddr*)&destination, sizeof(destination)) == (int)size;
+}
+
+s64 platform_receive_udp(s64 socket, void* buffer, u64 buffer_size, u32* address, u16* port)
+{
+    while (true)
+    {
+        sockaddr_in source = {};
+        int source_size = sizeof(source);
+        auto received = recvfrom((SOCKET)socket, (char*)buffer, (int)buffer_size, 0, (sockaddr*)&source, &source_size);
+        // a port unreachable reply to an earlier send shows up here as an error, it isn't a packet
+        if (received < 0 && WSAGetLastError() == WSAECONNRESET) { continue; }
+        if (received < 0) { return -1; }
+        *address = ntohl(source.sin_addr.s_addr);
+        *port = ntohs(source.sin_port);
+        return received;
+    }
+}
+
+void platform_close_udp_socket(s64 socket) { closesocket((SOCKET)socket); }
+
+int platform_send_udp_batch(s64 socket, UdpDatagram* datagrams, int count)
+{
+    auto sent = 0;
+    for (auto i = 0; i < count; i++)
+    { sent += platform_send_udp(socket, datagrams[i].address, datagrams[i].port, datagrams[i].data, datagrams[i].size); }
+    return sent;
+}
+
+int platform_receive_udp_batch(s64 socket, UdpDatagram* datagrams, int count)
+{
+    for (auto i = 0; i < count; i++)
+    {
+        auto datagram = &datagrams[i];
+        auto size = platform_receive_udp(socket, datagram->data, datagram->size, &datagram->address, &datagram->port);
+        if (size < 0) { return i; }
+        datagram->size = (u64)size;
+    }
+    return count;
+}
+
+// the poller is the socket itself
+s64 platform_open_udp_poller(s64 socket) { return socket; }
+
+bool platform_wait_for_udp(s64 poller, int timeout_ms)
+{
+    WSAPOLLFD descriptor = {};
+    descriptor.fd = (SOCKET)poller;
+    descriptor.events = POLLRDNORM;
+    return WSAPoll(&descriptor, 1, timeout_ms) > 0;
+}
+
+void platform_close_udp_poller(s64 poller) {}
@@ -1,7 +1,19 @@
+struct Resources
+{
+    TTF_Font* font16;
+    TTF_Font* font32;
+};
+
+Resources g_resources;
+
+#define RENDER_TILE_HEIGHT 64
+
 struct Bitmap
 {
     u64 width, height;
     Pixel* data;
+    // drawing only touches rows clip_y0 <= y < clip_y1, so horizontal tiles of one bitmap can be drawn in parallel
+    int clip_y0, clip_y1;
 };
 
 Bitmap make_bitmap(u64 width, u64 height, Pixel* data)
@@ -10,51 +22,142 @@ Bitmap make_bitmap(u64 width, u64 height, Pixel* data)
     result.width = width;
     result.height = height;
     result.data = data;
+    result.clip_y0 = 0;
+    result.clip_y1 = (int)height;
     return result;
 }
 
-void set_pixel(int x, int y, Pixel color, Bitmap bitmap)
+Bitmap allocate_bitmap(u64 width, u64 height)
 {
-    assert(0 <= x && x < bitmap.width && 0 <= y && y < bitmap.height);
-    bitmap.data[y * bitmap.width + x] = color;
+    auto data = (Pixel*)SDL_malloc(width * height * sizeof(Pixel));
+    if (data == NULL) { panic("Failed to allocate bitmap"); }
+    return make_bitmap(width, height, data);
 }
 
-void clear_bitmap(Pixel color, Bitmap bitmap)
+void free_bitmap(Bitmap bitmap) { SDL_free(bitmap.data); }
+
+bool save_bitmap_as_ppm(Bitmap bitmap, char* file_name)
 {
-    for (u64 y = 0; y < bitmap.height; y++)
+    auto file = SDL_RWFromFile(file_name, "wb");
+    if (file == NULL) { return false; }
+
+    char header_data[64];
+    auto header = make_string(0, header_data);
+    push("P6\n", &header);
+    uint_to_string(bitmap.width, &header);
+    push(' ', &header);
+    uint_to_string(bitmap.height, &header);
+    push("\n255\n", &header);
+    auto success = SDL_RWwrite(file, header.data, 1, header.size) == header.size;
+
+    auto row = (u8*)SDL_malloc(bitmap.width * 3);
+    if (row == NULL) { panic("Failed to allocate PPM row"); }
+    for (u64 y = 0; success && y < bitmap.height; y++)
     {
         for (u64 x = 0; x < bitmap.width; x++)
         {
-            set_pixel(x, y, color, bitmap);
+            auto pixel = bitmap.data[y * bitmap.width + x];
+            row[x * 3 + 0] = (pixel >> 16) & 0xff;
+            row[x * 3 + 1] = (pixel >> 8) & 0xff;
+            row[x * 3 + 2] = pixel & 0xff;
         }
+        success = SDL_RWwrite(file, row, 3, bitmap.width) == bitmap.width;
     }
+    SDL_free(row);
+    SDL_RWclose(file);
+    return success;
+}
+
+bool save_bitmap_as_bmp(Bitmap bitmap, char* file_name)
+{
+    auto surface = SDL_CreateRGBSurfaceWithFormatFrom(
+        bitmap.data,
+        bitmap.width,
+        bitmap.height,
+        32,
+        bitmap.width * sizeof(Pixel),
+        SDL_PIXELFORMAT_RGB888
+    );
+    if (surface == NULL) { return false; }
+    auto result = SDL_SaveBMP(surface, file_name) == 0;
+    SDL_FreeSurface(surface);
+    return result;
 }
 
+// returns a bitmap with NULL data if the file is missing or isn't a binary PPM with 8-bit channels
+Bitmap load_bitmap_from_ppm(char* file_name)
+{
+    auto result = make_bitmap(0, 0, NULL);
+    auto file = SDL_RWFromFile(file_name, "rb");
+    if (file == NULL) { return result; }
+    auto file_size = SDL_RWsize(file);
+    auto contents = (char*)SDL_malloc(MAX(file_size, 1));
+    if (contents == NULL) { panic("Failed to allocate PPM file buffer"); }
+    auto bytes_read = SDL_RWread(file, contents, 1, file_size);
+    SDL_RWclose(file);
+
+    // header is "P6", width, height and max value separated by whitespace, followed by a single whitespace character
+    int header_values[3];
+    u64 i = 2;
+    if (bytes_read < 2 || contents[0] != 'P' || contents[1] != '6') { goto done; }
+    for (auto value_index = 0; value_index < countof(header_values); value_index++)
+    {
+        while (i < bytes_read && (contents[i] == ' ' || contents[i] == '\n' || contents[i] == '\r' || contents[i] == '\t')) { i++; }
+        auto start = i;
+        while (i < bytes_read && contents[i] >= '0' && contents[i] <= '9') { i++; }
+        auto parsed = string_to_int(make_string(i - start, contents + start));
+        if (!parsed.success || parsed.value <= 0) { goto done; }
+        header_values[value_index] = parsed.value;
+    }
+    i++;
+    if (header_values[2] != 255 || bytes_read - MIN(i, bytes_read) != (u64)header_values[0] * header_values[1] * 3) { goto done; }
+
+    result = allocate_bitmap(header_values[0], header_values[1]);
+    for (u64 pixel_index = 0; pixel_index < result.width * result.height; pixel_index++)
+    {
+        auto rgb = (u8*)contents + i + pixel_index * 3;
+        result.data[pixel_index] = (rgb[0] << 16) | (rgb[1] << 8) | rgb[2];
+    }
+
+    done:
+    SDL_free(contents);
+    return result;
+}
+
+void set_pixel(int x, int y, Pixel color, Bitmap bitmap)
+{
+    assert(0 <= x && x < bitmap.width && 0 <= y && y < bitmap.height);
+    if (y < bitmap.clip_y0 || y >= bitmap.clip_y1) { return; }
+    bitmap.data[y * bitmap.width + x] = color;
+}
+
+void clear_bitmap(Pixel color, Bitmap bitmap)
+{ set_memory_u32(color, bitmap.width * (bitmap.clip_y1 - bitmap.clip_y0), bitmap.data + bitmap.clip_y0 * bitmap.width); }
+
 void draw_horizontal_line(int x0, int x1, int y, Pixel color, Bitmap bitmap)
 {
     auto start = MIN(x0, x1);
     auto end = MAX(x0, x1);
-    for (int x = start; x < end; x++)
-    { set_pixel(x, y, color, bitmap); }
+    if (start == end) { return; }
+    assert(0 <= start && end <= bitmap.width && 0 <= y && y < bitmap.height);
+    if (y < bitmap.clip_y0 || y >= bitmap.clip_y1) { return; }
+    set_memory_u32(color, end - start, bitmap.data + y * bitmap.width + start);
 }
 
 void draw_vertical_line(int x, int y0, int y1, Pixel color, Bitmap bitmap)
 {
-    auto start = MIN(y0, y1);
-    auto end = MAX(y0, y1);
+    auto start = MAX(MIN(y0, y1), bitmap.clip_y0);
+    auto end = MIN(MAX(y0, y1), bitmap.clip_y1);
     for (int y = start; y < end; y++)
     { set_pixel(x, y, color, bitmap); }
 }
 
 void draw_rectangle(int x0, int y0, int width, int height, Pixel color, Bitmap bitmap)
 {
-    for (auto y = y0; y < y0 + height; y++)
-    {
-        for (auto x = x0; x < x0 + width; x++)
-        {
-            set_pixel(x, y, color, bitmap);
-        }
-    }
+    if (width <= 0 || height <= 0) { return; }
+    assert(0 <= x0 && x0 + width <= bitmap.width && 0 <= y0 && y0 + height <= bitmap.height);
+    for (auto y = MAX(y0, bitmap.clip_y0); y < MIN(y0 + height, bitmap.clip_y1); y++)
+    { set_memory_u32(color, width, bitmap.data + y * bitmap.width + x0); }
 }
 
 SDL_Surface* text_to_surface(Pixel color, TTF_Font* font, char* text)
@@ -94,7 +197,216 @@ Vector draw_text_with_shade(int x0, int y0, Pixel color, int shade, Pixel shade_
     return dimensions;
 }
 
-void draw_game_screen(Bitmap bitmap)
+// Pre-rendered text. TTF rasterization is by far the most expensive part of a frame, so HUD labels are kept as
+// 1-bit masks and only recomposed when their number changes, from a prefix and per-digit glyphs rendered at startup.
+
+struct TextMask
+{
+    int width, height;
+    u8* data; // 1 where the text is opaque
+};
+
+TextMask allocate_text_mask(int width, int height)
+{
+    TextMask result;
+    result.width = width;
+    result.height = height;
+    result.data = (u8*)SDL_malloc(MAX(1, width * height));
+    if (result.data == NULL) { panic("Failed to allocate text mask"); }
+    set_memory(0, width * height, result.data);
+    return result;
+}
+
+TextMask render_text_mask(TTF_Font* font, char* text)
+{
+    // TTF refuses to render zero-width text
+    if (text[0] == '\0') { return allocate_text_mask(0, 0); }
+    auto text_surface = text_to_surface(WHITE, font, text);
+    if (!text_surface) { panic_sdl("TTF_RenderText_Solid"); }
+    auto result = allocate_text_mask(text_surface->w, text_surface->h);
+    for (auto y = 0; y < text_surface->h; y++)
+    {
+        for (auto x = 0; x < text_surface->w; x++)
+        { result.data[y * result.width + x] = ((u8*)text_surface->pixels)[y * text_surface->pitch + x] == 1; }
+    }
+    SDL_FreeSurface(text_surface);
+    return result;
+}
+
+void blit_text_mask(int x0, int y0, TextMask source, TextMask* destination)
+{
+    for (auto y = 0; y < source.height; y++)
+    { copy_memory(source.width, source.data + y * source.width, destination->data + (y + y0) * destination->width + x0); }
+}
+
+Vector draw_text_mask(int x0, int y0, Pixel color, TextMask mask, Bitmap bitmap)
+{
+    for (auto y = MAX(0, bitmap.clip_y0 - y0); y < MIN(mask.height, bitmap.clip_y1 - y0); y++)
+    {
+        auto row = mask.data + y * mask.width;
+        for (auto x = 0; x < mask.width; x++)
+        {
+            if (row[x]) { set_pixel(x + x0, y + y0, color, bitmap); }
+        }
+    }
+    return make_vector(mask.width, mask.height);
+}
+
+// 0-9, then '.' and '-' for fractional and negative values
+#define DIGIT_GLYPH_COUNT 12
+
+struct DigitGlyphs
+{
+    TextMask glyphs[DIGIT_GLYPH_COUNT];
+};
+
+DigitGlyphs render_digit_glyphs(TTF_Font* font)
+{
+    DigitGlyphs result;
+    char glyph_text[2] = { 0, 0 };
+    for (auto i = 0; i < DIGIT_GLYPH_COUNT; i++)
+    {
+        glyph_text[0] = i < 10 ? '0' + i : i == 10 ? '.' : '-';
+        result.glyphs[i] = render_text_mask(font, glyph_text);
+    }
+    return result;
+}
+
+int get_digit_glyph_index(char c)
+{
+    if (c >= '0' && c <= '9') { return c - '0'; }
+    if (c == '.') { return 10; }
+    if (c == '-') { return 11; }
+    return -1;
+}
+
+struct NumericLabel
+{
+    TextMask prefix;
+    TextMask text; // prefix followed by the current value, NULL data until the first draw
+    bool is_float;
+    s64 int_value;
+    float float_value;
+};
+
+NumericLabel make_numeric_label(TTF_Font* font, char* prefix)
+{
+    NumericLabel result;
+    result.prefix = render_text_mask(font, prefix);
+    result.text.data = NULL;
+    result.is_float = false;
+    result.int_value = 0;
+    result.float_value = 0;
+    return result;
+}
+
+void compose_numeric_label(NumericLabel* label, String digits, DigitGlyphs* digit_glyphs)
+{
+    auto width = label->prefix.width;
+    auto height = label->prefix.height;
+    for (u64 i = 0; i < digits.size; i++)
+    {
+        auto glyph_index = get_digit_glyph_index(digits.data[i]);
+        if (glyph_index == -1) { continue; }
+        width += digit_glyphs->glyphs[glyph_index].width;
+        height = MAX(height, digit_glyphs->glyphs[glyph_index].height);
+    }
+
+    if (label->text.data != NULL) { SDL_free(label->text.data); }
+    label->text = allocate_text_mask(width, height);
+    blit_text_mask(0, 0, label->prefix, &label->text);
+    auto x = label->prefix.width;
+    for (u64 i = 0; i < digits.size; i++)
+    {
+        auto glyph_index = get_digit_glyph_index(digits.data[i]);
+        if (glyph_index == -1) { continue; }
+        blit_text_mask(x, 0, digit_glyphs->glyphs[glyph_index], &label->text);
+        x += digit_glyphs->glyphs[glyph_index].width;
+    }
+}
+
+TextMask get_numeric_label_text(NumericLabel* label, s64 value, DigitGlyphs* digit_glyphs)
+{
+    if (label->text.data == NULL || label->is_float || label->int_value != value)
+    {
+        char digits_data[24];
+        auto digits = make_string(0, digits_data);
+        int_to_string(value, &digits);
+        compose_numeric_label(label, digits, digit_glyphs);
+        label->is_float = false;
+        label->int_value = value;
+    }
+    return label->text;
+}
+
+TextMask get_numeric_label_text(NumericLabel* label, float value, DigitGlyphs* digit_glyphs)
+{
+    if (label->text.data == NULL || !label->is_float || label->float_value != value)
+    {
+        char digits_data[48];
+        auto digits = make_string(0, digits_data);
+        float_to_string(value, &digits);
+        compose_numeric_label(label, digits, digit_glyphs);
+        label->is_float = true;
+        label->float_value = value;
+    }
+    return label->text;
+}
+
+struct Hud
+{
+    DigitGlyphs digits16;
+    NumericLabel score;
+    NumericLabel high_score;
+    NumericLabel mirror;
+    NumericLabel fill_cell;
+    NumericLabel invert_board;
+    NumericLabel bomb;
+    NumericLabel fps;
+    NumericLabel ticks_per_second;
+    NumericLabel sim_speed;
+};
+
+Hud g_hud;
+
+void initialize_hud(TTF_Font* font16)
+{
+    g_hud.digits16 = render_digit_glyphs(font16);
+    g_hud.score = make_numeric_label(font16, "Score: ");
+    g_hud.high_score = make_numeric_label(font16, "High Score: ");
+    g_hud.mirror = make_numeric_label(font16, "Mirror shape: ");
+    g_hud.fill_cell = make_numeric_label(font16, "Fill cell: ");
+    g_hud.invert_board = make_numeric_label(font16, "Invert board: ");
+    g_hud.bomb = make_numeric_label(font16, "Bomb: ");
+    g_hud.fps = make_numeric_label(font16, "");
+    g_hud.ticks_per_second = make_numeric_label(font16, "Ticks/sec: ");
+    g_hud.sim_speed = make_numeric_label(font16, "Sim speed x");
+}
+
+struct HudTexts
+{
+    TextMask score;
+    TextMask high_score;
+    TextMask mirror;
+    TextMask fill_cell;
+    TextMask invert_board;
+    TextMask bomb;
+};
+
+// recomposes the labels whose numbers changed, so it runs on one thread; the masks can then be drawn from any
+HudTexts get_hud_texts()
+{
+    HudTexts result;
+    result.score = get_numeric_label_text(&g_hud.score, (s64)g_game_state.score, &g_hud.digits16);
+    result.high_score = get_numeric_label_text(&g_hud.high_score, (s64)g_game_state.high_score, &g_hud.digits16);
+    result.mirror = get_numeric_label_text(&g_hud.mirror, (s64)g_game_state.power_ups.mirror, &g_hud.digits16);
+    result.fill_cell = get_numeric_label_text(&g_hud.fill_cell, (s64)g_game_state.power_ups.fill_cell, &g_hud.digits16);
+    result.invert_board = get_numeric_label_text(&g_hud.invert_board, (s64)g_game_state.power_ups.invert_board, &g_hud.digits16);
+    result.bomb = get_numeric_label_text(&g_hud.bomb, (s64)g_game_state.power_ups.bomb, &g_hud.digits16);
+    return result;
+}
+
+void draw_game_screen(Bitmap bitmap, HudTexts* texts)
 {
     auto line_width = 1;
     auto min_side_padding = (int)(bitmap.width * .2);
@@ -177,136 +489,72 @@ void draw_game_screen(Bitmap bitmap)
     }
 
     // score
-    char buffer_data[40];
-    auto buffer = make_string(0, buffer_data);
-    push("Score: ", &buffer);
-    int_to_string(g_game_state.score, &buffer);
-    push('\0', &buffer);
-    auto score_text_dimensions = draw_text(
+    auto score_text_dimensions = draw_text_mask(
         side_padding + board_width + 10,
         top_bottom_padding + 5,
         WHITE,
-        g_game_state.resources.font16,
-        buffer_data,
+        texts->score,
         bitmap
     );
 
     // high score
-    buffer.size = 0;
-    push("High Score: ", &buffer);
-    int_to_string(g_game_state.high_score, &buffer);
-    push('\0', &buffer);
-    draw_text(
+    draw_text_mask(
         side_padding + board_width + 10,
         top_bottom_padding + 5 + score_text_dimensions.y + 5,
         WHITE,
-        g_game_state.resources.font16,
-        buffer_data,
+        texts->high_score,
         bitmap
     );
 
     // power ups
     {
-        char power_up_text_data[256];
-        auto power_up_text = make_string(0, power_up_text_data);
         auto power_up_color = WHITE;
         auto y = top_bottom_padding;
 
-        push("Mirror shape: ", &power_up_text);
-        int_to_string(g_game_state.power_ups.mirror, &power_up_text);
-        push('\0', &power_up_text);
-        auto mirror_power_up_text_surface = text_to_surface(power_up_color, g_game_state.resources.font16, power_up_text.data);
-        draw_text(
-            side_padding - mirror_power_up_text_surface->w - 5,
-            y,
-            power_up_color,
-            g_game_state.resources.font16,
-            power_up_text.data,
-            bitmap
-        );
-        y += mirror_power_up_text_surface->h + 5;
-        power_up_text.size = 0;
-        SDL_FreeSurface(mirror_power_up_text_surface);
-
-        push("Fill cell: ", &power_up_text);
-        int_to_string(g_game_state.power_ups.fill_cell, &power_up_text);
-        push('\0', &power_up_text);
-        auto fill_cell_power_up_text_surface = text_to_surface(power_up_color, g_game_state.resources.font16, power_up_text.data);
-        draw_text(
-            side_padding - fill_cell_power_up_text_surface->w - 5,
-            y,
-            power_up_color,
-            g_game_state.resources.font16,
-            power_up_text.data,
-            bitmap
-        );
-        y += fill_cell_power_up_text_surface->h + 5;
-        power_up_text.size = 0;
-        SDL_FreeSurface(fill_cell_power_up_text_surface);
-
-        push("Invert board: ", &power_up_text);
-        int_to_string(g_game_state.power_ups.invert_board, &power_up_text);
-        push('\0', &power_up_text);
-        auto invert_board_power_up_text_surface = text_to_surface(power_up_color, g_game_state.resources.font16, power_up_text.data);
-        draw_text(
-            side_padding - invert_board_power_up_text_surface->w - 5,
-            y,
-            power_up_color,
-            g_game_state.resources.font16,
-            power_up_text.data,
-            bitmap
-        );
-        y += invert_board_power_up_text_surface->h + 5;
-        power_up_text.size = 0;
-        SDL_FreeSurface(invert_board_power_up_text_surface);
-
-        push("Bomb: ", &power_up_text);
-        int_to_string(g_game_state.power_ups.bomb, &power_up_text);
-        push('\0', &power_up_text);
-        auto bomb_power_up_text_surface = text_to_surface(power_up_color, g_game_state.resources.font16, power_up_text.data);
-        draw_text(
-            side_padding - bomb_power_up_text_surface->w - 5,
-            y,
-            power_up_color,
-            g_game_state.resources.font16,
-            power_up_text.data,
-            bitmap
-        );
-        y += bomb_power_up_text_surface->h + 5;
-        power_up_text.size = 0;
-        SDL_FreeSurface(bomb_power_up_text_surface);
+        auto mirror_text = texts->mirror;
+        draw_text_mask(side_padding - mirror_text.width - 5, y, power_up_color, mirror_text, bitmap);
+        y += mirror_text.height + 5;
+
+        auto fill_cell_text = texts->fill_cell;
+        draw_text_mask(side_padding - fill_cell_text.width - 5, y, power_up_color, fill_cell_text, bitmap);
+        y += fill_cell_text.height + 5;
+
+        auto invert_board_text = texts->invert_board;
+        draw_text_mask(side_padding - invert_board_text.width - 5, y, power_up_color, invert_board_text, bitmap);
+        y += invert_board_text.height + 5;
+
+        auto bomb_text = texts->bomb;
+        draw_text_mask(side_padding - bomb_text.width - 5, y, power_up_color, bomb_text, bitmap);
+        y += bomb_text.height + 5;
     }
 }
 
-void draw_game(Bitmap bitmap)
+// the GAME OVER and PAUSED text still goes through TTF, which isn't thread safe, so it is drawn over the whole bitmap
+void draw_game_overlay(Bitmap bitmap)
 {
-    clear_bitmap(BLACK, bitmap);
-
-    draw_game_screen(bitmap);
-
     if (g_game_state.mode == GameModeLost)
     {
-        auto game_over_text_surface = text_to_surface(RED, g_game_state.resources.font32, "GAME OVER");
+        auto game_over_text_surface = text_to_surface(RED, g_resources.font32, "GAME OVER");
         auto game_over_text_dimensions = draw_text_with_shade(
             (bitmap.width - game_over_text_surface->w) / 2,
             (bitmap.height - game_over_text_surface->h) / 2,
             RED,
             2,
             BLACK,
-            g_game_state.resources.font32,
+            g_resources.font32,
             "GAME OVER",
             bitmap
         );
         SDL_FreeSurface(game_over_text_surface);
 
-        auto restart_text_surface = text_to_surface(WHITE, g_game_state.resources.font16, "(press ENTER to restart)");
+        auto restart_text_surface = text_to_surface(WHITE, g_resources.font16, "(press ENTER to restart)");
         draw_text_with_shade(
             (bitmap.width - restart_text_surface->w) / 2,
             (bitmap.height + game_over_text_dimensions.y) / 2,
             WHITE,
             2,
             BLACK,
-            g_game_state.resources.font16,
+            g_resources.font16,
             "(press ENTER to restart)",
             bitmap
         );
@@ -314,17 +562,61 @@ void draw_game(Bitmap bitmap)
     }
     if (g_game_state.mode == GameModePause)
     {
-        auto paused_text_surface = text_to_surface(WHITE, g_game_state.resources.font32, "PAUSED");
+        auto paused_text_surface = text_to_surface(WHITE, g_resources.font32, "PAUSED");
         draw_text_with_shade(
             (bitmap.width - paused_text_surface->w) / 2,
             (bitmap.height - paused_text_surface->h) / 2,
             WHITE,
             2,
             BLACK,
-            g_game_state.resources.font32,
+            g_resources.font32,
             "PAUSED",
             bitmap
         );
         SDL_FreeSurface(paused_text_surface);
     }
 }
+
+void draw_game(Bitmap bitmap)
+{
+    auto texts = get_hud_texts();
+    clear_bitmap(BLACK, bitmap);
+    draw_game_screen(bitmap, &texts);
+    draw_game_overlay(bitmap);
+}
+
+struct GameTiles
+{
+    Bitmap bitmap;
+    HudTexts texts;
+};
+
+void draw_game_tiles(void* data, int begin, int end)
+{
+    auto tiles = (GameTiles*)data;
+    auto tile = tiles->bitmap;
+    tile.clip_y0 = begin * RENDER_TILE_HEIGHT;
+    tile.clip_y1 = MIN(end * RENDER_TILE_HEIGHT, (int)tiles->bitmap.height);
+    clear_bitmap(BLACK, tile);
+    draw_game_screen(tile, &tiles->texts);
+}
+
+// same output as draw_game, with the board and HUD drawn in horizontal tiles spread over the job workers
+void draw_game_tiled(Bitmap bitmap)
+{
+    GameTiles tiles;
+    tiles.bitmap = bitmap;
+    tiles.texts = get_hud_texts();
+    auto tile_count = ((int)bitmap.height + RENDER_TILE_HEIGHT - 1) / RENDER_TILE_HEIGHT;
+    parallel_for(draw_game_tiles, &tiles, tile_count, 1);
+    draw_game_overlay(bitmap);
+}
+
+void load_resources()
+{
+    g_resources.font16 = TTF_OpenFont("res/Sans.ttf", 16);
+    if (g_resources.font16 == NULL) { panic_sdl("TTF_OpenFont"); }
+    g_resources.font32 = TTF_OpenFont("res/Sans.ttf", 32);
+    if (g_resources.font32 == NULL) { panic_sdl("TTF_OpenFont"); }
+    initialize_hud(g_resources.font16);
+}
@@ -0,0 +1,371 @@
+// Lookahead search. Max nodes pick a placement for the falling shape, chance nodes average over the five shapes
+// generate_new_falling_shape can spawn next (it draws uniformly from ALL_SHAPES), leaves score the board with BotWeights
+// or the loaded network.
+// Depth is the number of shapes placed: depth 1 is the greedy bot, each extra level adds one unknown shape.
+// The search deepens one level at a time until the time budget runs out and keeps the last depth that finished.
+// Root placements are searched as a parallel-for on the job system; each job worker has its own scratch memory, one
+// SearchPly per level.
+// Max node values go into a transposition table keyed by get_search_position_hash, since different placement orders
+// often build the same board. Values are stored without the rows cleared since the root, so they stay valid across
+// moves. The network also reads the fill cell, invert board and bomb counts, so with one loaded those are in the key.
+
+#define MAX_SEARCH_DEPTH 6
+#define DEFAULT_SEARCH_BUDGET_MS 50
+#define DEFAULT_SEARCH_BEAM_WIDTH 8
+
+struct SearchConfig
+{
+    BotWeights weights;
+    int max_depth;
+    u64 budget_nanoseconds;
+    // below the root only the best placements by static score get searched deeper
+    int beam_width;
+};
+
+struct SearchResult
+{
+    Placement placement;
+    int depth; // deepest level that finished inside the budget
+    float value;
+    u64 nodes;
+    u64 nanoseconds;
+    TranspositionStats table_stats;
+};
+
+struct SearchPly
+{
+    MoveGeneration generation;
+    Placement placements[MAX_LOCK_POSITIONS];
+    GameState child;
+    GameState next_shape;
+    PackedBoard searched_boards[MAX_LOCK_POSITIONS];
+    s32 searched_mirrors[MAX_LOCK_POSITIONS];
+};
+
+struct SearchWorker
+{
+    struct Search* search;
+    u64 nodes;
+    TranspositionStats table_stats;
+    SearchPly plies[MAX_SEARCH_DEPTH];
+};
+
+struct Search
+{
+    SearchConfig config;
+    GameState* root;
+    u64 deadline;
+    SDL_atomic_t stop;
+    int depth; // of the iteration in progress
+    TranspositionTable table;
+    SearchConfig table_config; // what the values in the table were searched with
+
+    SearchPly root_ply;
+    int root_count;
+    float root_values[MAX_LOCK_POSITIONS];
+
+    int worker_count;
+    SearchWorker* workers;
+};
+
+SearchConfig make_search_config(BotWeights weights, u64 budget_milliseconds)
+{
+    SearchConfig result;
+    result.weights = weights;
+    result.max_depth = MAX_SEARCH_DEPTH;
+    result.budget_nanoseconds = budget_milliseconds * 1000000;
+    result.beam_width = DEFAULT_SEARCH_BEAM_WIDTH;
+    return result;
+}
+
+Search* allocate_search()
+{
+    auto search = (Search*)SDL_calloc(1, sizeof(Search));
+    if (search == NULL) { panic("Out of memory for search"); }
+    search->worker_count = get_job_worker_count();
+    search->workers = (SearchWorker*)SDL_calloc(search->worker_count, sizeof(SearchWorker));
+    if (search->workers == NULL) { panic("Out of memory for search workers"); }
+    for (auto i = 0; i < search->worker_count; i++) { search->workers[i].search = search; }
+    search->table = allocate_transposition_table(DEFAULT_TRANSPOSITION_TABLE_BITS);
+    return search;
+}
+
+void free_search(Search* search)
+{
+    free_transposition_table(&search->table);
+    SDL_free(search->workers);
+    SDL_free(search);
+}
+
+// best first; ties go to the placement that leaves more mirror power ups, so it wins the dominance check below
+void sort_placements_by_score(Placement* placements, int count)
+{
+    for (auto i = 1; i < count; i++)
+    {
+        auto placement = placements[i];
+        auto j = i;
+        while (j > 0 && (placements[j - 1].score < placement.score
+            || (placements[j - 1].score == placement.score && placements[j - 1].mirrored && !placement.mirrored)))
+        {
+            placements[j] = placements[j - 1];
+            j--;
+        }
+        placements[j] = placement;
+    }
+}
+
+// a placement is dominated when an earlier one left the same board and at least as many mirror power ups
+bool is_dominated(SearchPly* ply, int searched_count, GameState* child)
+{
+    auto board = pack_board(child->board);
+    for (auto i = 0; i < searched_count; i++)
+    {
+        if (ply->searched_mirrors[i] >= child->power_ups.mirror
+            && memory_equals(sizeof(board), &ply->searched_boards[i], &board))
+        { return true; }
+    }
+    ply->searched_boards[searched_count] = board;
+    ply->searched_mirrors[searched_count] = child->power_ups.mirror;
+    return false;
+}
+
+bool should_stop_search(Search* search)
+{
+    if (SDL_AtomicGet(&search->stop)) { return true; }
+    if (get_monotonic_nanoseconds() < search->deadline) { return false; }
+    SDL_AtomicSet(&search->stop, 1);
+    return true;
+}
+
+// generates and scores every placement of the falling shape, best first; returns how many there are
+int expand_placements(SearchWorker* worker, SearchPly* ply, GameState* state)
+{
+    auto search = worker->search;
+    auto count = enumerate_placements(state, &ply->generation, ply->placements);
+    // cleared rows count from the root, so a line cleared two shapes ahead is worth the same as one cleared now
+    auto cleared_rows_offset = state->score - search->root->score;
+    score_bot_placements(state, &ply->generation, ply->placements, count, search->config.weights, cleared_rows_offset);
+    worker->nodes += count;
+    sort_placements_by_score(ply->placements, count);
+    return count;
+}
+
+float search_chance_node(SearchWorker* worker, GameState* state, int depth, int ply_index);
+
+float search_max_node_uncached(SearchWorker* worker, GameState* state, int depth, int ply_index)
+{
+    auto search = worker->search;
+    auto ply = &worker->plies[ply_index];
+    auto count = expand_placements(worker, ply, state);
+    if (count == 0) { return LOST_GAME_SCORE; }
+    if (depth == 1) { return ply->placements[0].score; }
+
+    auto best = LOST_GAME_SCORE;
+    auto searched = 0;
+    for (auto i = 0; i < count && searched < search->config.beam_width; i++)
+    {
+        // sorted, so everything from here on loses too
+        if (ply->placements[i].score == LOST_GAME_SCORE) { break; }
+        ply->child = *state;
+        apply_placement(ply->placements[i], &ply->child);
+        if (is_dominated(ply, searched, &ply->child)) { continue; }
+        searched++;
+        auto value = search_chance_node(worker, &ply->child, depth - 1, ply_index + 1);
+        if (SDL_AtomicGet(&search->stop)) { return 0; }
+        best = MAX(best, value);
+    }
+    return best;
+}
+
+// get_position_hash, plus the other power up counts when g_board_network scores the leaves, capped where its inputs are
+u64 get_search_position_hash(GameState* state)
+{
+    auto result = get_position_hash(state);
+    if (g_board_network == NULL) { return result; }
+    auto power_ups = &state->power_ups;
+    u64 counts = MIN(MAX(power_ups->fill_cell, 0), NETWORK_POWER_UP_LEVELS)
+        | MIN(MAX(power_ups->invert_board, 0), NETWORK_POWER_UP_LEVELS) << 8
+        | MIN(MAX(power_ups->bomb, 0), NETWORK_POWER_UP_LEVELS) << 16;
+    return mix_hash(result, counts);
+}
+
+// value of the best placement of the falling shape, looking depth shapes ahead including this one
+float search_max_node(SearchWorker* worker, GameState* state, int depth, int ply_index)
+{
+    auto search = worker->search;
+    if (should_stop_search(search)) { return 0; }
+    auto cleared_rows_value = (state->score - search->root->score) * search->config.weights.cleared_rows;
+    auto key = get_search_position_hash(state);
+    float stored;
+    if (probe_transposition_table(&search->table, key, depth, &stored, &worker->table_stats)) { return stored + cleared_rows_value; }
+
+    auto value = search_max_node_uncached(worker, state, depth, ply_index);
+    if (SDL_AtomicGet(&search->stop)) { return 0; }
+    store_transposition_table(&search->table, key, depth, value - cleared_rows_value, &worker->table_stats);
+    return value;
+}
+
+// expected value over the next shape, each of ALL_SHAPES being equally likely
+float search_chance_node(SearchWorker* worker, GameState* state, int depth, int ply_index)
+{
+    if (state->mode == GameModeLost) { return LOST_GAME_SCORE; }
+    auto ply = &worker->plies[ply_index];
+    auto total = 0.0f;
+    for (auto shape = 0; shape < countof(ALL_SHAPES); shape++)
+    {
+        ply->next_shape = *state;
+        spawn_falling_shape(*ALL_SHAPES[shape], &ply->next_shape);
+        total += search_max_node(worker, &ply->next_shape, depth, ply_index);
+        if (SDL_AtomicGet(&worker->search->stop)) { return 0; }
+    }
+    return total / countof(ALL_SHAPES);
+}
+
+// root jobs never wait on other jobs, so two of them can't end up sharing a worker's scratch memory
+void search_root_placements(void* data, int begin, int end)
+{
+    auto search = (Search*)data;
+    auto worker = &search->workers[get_job_worker_index()];
+    for (auto index = begin; index < end && !SDL_AtomicGet(&search->stop); index++)
+    {
+        auto child = &worker->plies[0].child;
+        *child = *search->root;
+        apply_placement(search->root_ply.placements[index], child);
+        search->root_values[index] = search_chance_node(worker, child, search->depth - 1, 1);
+    }
+}
+
+// returns false if the falling shape has nowhere to go
+bool search_best_placement(Search* search, GameState* state, SearchConfig config, SearchResult* result)
+{
+    auto start = get_monotonic_nanoseconds();
+    search->config = config;
+    search->root = state;
+    search->deadline = start + config.budget_nanoseconds;
+    SDL_AtomicSet(&search->stop, 0);
+    for (auto i = 0; i < search->worker_count; i++)
+    {
+        search->workers[i].nodes = 0;
+        set_memory(0, sizeof(search->workers[i].table_stats), &search->workers[i].table_stats);
+    }
+    // the table survives between moves, but values scored with other weights or pruned differently don't mix
+    if (!memory_equals(sizeof(config.weights), &config.weights, &search->table_config.weights)
+        || config.beam_width != search->table_config.beam_width)
+    {
+        clear_transposition_table(&search->table);
+        search->table_config = config;
+    }
+
+    // depth 1 always finishes, whatever the budget: it is the greedy bot
+    auto root_worker = &search->workers[get_job_worker_index()];
+    auto count = expand_placements(root_worker, &search->root_ply, state);
+    set_memory(0, sizeof(*result), result);
+    if (count == 0) { return false; }
+
+    // dominated root placements can't be better than the one that dominates them, drop them for good
+    auto kept = 0;
+    for (auto i = 0; i < count; i++)
+    {
+        root_worker->plies[0].child = *state;
+        apply_placement(search->root_ply.placements[i], &root_worker->plies[0].child);
+        if (is_dominated(&search->root_ply, kept, &root_worker->plies[0].child)) { continue; }
+        search->root_ply.placements[kept++] = search->root_ply.placements[i];
+    }
+    search->root_count = kept;
+    result->placement = search->root_ply.placements[0];
+    result->value = result->placement.score;
+    result->depth = 1;
+
+    for (auto depth = 2; depth <= config.max_depth && search->root_count > 1; depth++)
+    {
+        if (should_stop_search(search)) { break; }
+        search->depth = depth;
+        parallel_for(search_root_placements, search, search->root_count, 1);
+        if (SDL_AtomicGet(&search->stop)) { break; }
+
+        // the finished iteration orders the root for the next one, so the likely best move is searched first
+        for (auto i = 0; i < search->root_count; i++) { search->root_ply.placements[i].score = search->root_values[i]; }
+        sort_placements_by_score(search->root_ply.placements, search->root_count);
+        result->placement = search->root_ply.placements[0];
+        result->value = result->placement.score;
+        result->depth = depth;
+    }
+
+    for (auto i = 0; i < search->worker_count; i++)
+    {
+        auto worker = &search->workers[i];
+        result->nodes += worker->nodes;
+        result->table_stats.probes += worker->table_stats.probes;
+        result->table_stats.hits += worker->table_stats.hits;
+        result->table_stats.stores += worker->table_stats.stores;
+    }
+    result->nanoseconds = get_monotonic_nanoseconds() - start;
+    return true;
+}
+
+int run_search_games(int games, int max_shapes, s32 seed, int budget_milliseconds)
+{
+    initialize_shape_cell_maps();
+    auto config = make_search_config(DEFAULT_BOT_WEIGHTS, budget_milliseconds);
+    auto search = allocate_search();
+    reset_job_stats();
+    u64 total_nodes = 0;
+    u64 total_nanoseconds = 0;
+    u64 total_depth = 0;
+    u64 total_moves = 0;
+    u64 total_score = 0;
+    TranspositionStats total_table_stats;
+    set_memory(0, sizeof(total_table_stats), &total_table_stats);
+    for (auto game = 0; game < games; game++)
+    {
+        GameState state;
+        initialize_game_state(seed + game, &state);
+        auto shapes = 0;
+        while (state.mode == GameModePlaying && shapes < max_shapes)
+        {
+            SearchResult result;
+            if (!search_best_placement(search, &state, config, &result)) { break; }
+            apply_placement(result.placement, &state);
+            shapes++;
+
+            print("shape ");
+            print((s64)shapes);
+            print(": depth ");
+            print((s64)result.depth);
+            print(", nodes ");
+            print(result.nodes);
+            print(", nodes/sec ");
+            print(get_nodes_per_second(result.nodes, result.nanoseconds));
+            print(", table hit rate ");
+            print(get_hit_rate(result.table_stats));
+            print("\n");
+
+            total_nodes += result.nodes;
+            total_nanoseconds += result.nanoseconds;
+            total_depth += result.depth;
+            total_moves++;
+            total_table_stats.probes += result.table_stats.probes;
+            total_table_stats.hits += result.table_stats.hits;
+        }
+        print("game ");
+        print((s64)game);
+        print(": score ");
+        print((s64)state.score);
+        print(", shapes ");
+        print((s64)shapes);
+        print("\n");
+        total_score += state.score;
+    }
+    print("average score: ");
+    print((float)total_score / (float)MAX(1, games));
+    print(", average depth: ");
+    print((float)total_depth / (float)MAX(1, total_moves));
+    print(", nodes/sec: ");
+    print(get_nodes_per_second(total_nodes, total_nanoseconds));
+    print(", table hit rate: ");
+    print(get_hit_rate(total_table_stats));
+    print("\n");
+    print_job_stats();
+    free_search(search);
+    return 0;
+}
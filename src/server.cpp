@@ -0,0 +1,674 @@
+// Game server: many independent single player games for thin clients, all on one UDP socket. A client picks a client id,
+// and its address, port and id name its session, so one client socket can carry many sessions (the simulator uses
+// that to stay under the open file limit). Each session owns its GameState, nothing touches g_game_state.
+//
+// A thin client only draws, so what it gets is a ServerView: the packed board, the falling shape, the score and the
+// mode. Packets go only when there's something new: the server sends the view on the tick it changes, and again every
+// SERVER_RESEND_TICKS while the client hasn't acknowledged a state at least as new as that change, so a lost one is
+// sent again without resending every tick of the round trip. How much that saves depends on how busy the player is; the
+// simulator's clients press something one tick in eight and get a state on about a quarter of the ticks. A client sends
+// its presses with the SERVER_INPUT_HISTORY before them for as long as any of those were presses, so a lost packet is
+// covered by the next ones, plus whenever it has a newer state to acknowledge. Both sides send something at least every
+// SERVER_KEEPALIVE_TICKS, and the server closes a session that hasn't been heard from in SERVER_SESSION_TIMEOUT_TICKS.
+//
+// The main thread waits on the socket (epoll on Linux) until the next SERVER_TICK_MS tick is due, taking in packets as
+// they come. A tick runs the sessions as one parallel-for on the job system, SERVER_SESSION_BATCH at a time, then
+// sends the states. Sessions are dense in one array, found through a UdpPeerTable, and a session that hasn't
+// sent anything for SERVER_SESSION_TIMEOUT_TICKS is closed by moving the last one into its place.
+//
+// The UdpPeerTable, the batched receive and the socket setup are shared with the spectator broadcast.
+
+#define UDP_RECEIVE_BATCH 64
+#define MAX_UDP_REQUEST_BYTES 64 // of the packets a service takes in; longer ones arrive cut short and get ignored
+
+// who a packet came from: the sending socket, plus an id so one socket can stand in for many peers
+struct UdpPeer
+{
+    u32 address;
+    u16 port;
+    u32 id;
+};
+
+// Open addressing from a UdpPeer to its index in a dense array of entries that each start with their UdpPeer. The
+// table is at most half full, so probes stay short.
+struct UdpPeerTable
+{
+    int* slots; // entry indices, -1 for an empty slot
+    u32 mask;
+    u8* entries;
+    u64 entry_size;
+};
+
+void start_udp_peer_table(UdpPeerTable* table, void* entries, u64 entry_size, int max_entries)
+{
+    u32 size = 1;
+    while (size < 2 * (u32)max_entries) { size *= 2; }
+    table->slots = (int*)SDL_malloc(size * sizeof(int));
+    if (table->slots == NULL) { panic("Out of memory for a UDP peer table"); }
+    for (u32 i = 0; i < size; i++) { table->slots[i] = -1; }
+    table->mask = size - 1;
+    table->entries = (u8*)entries;
+    table->entry_size = entry_size;
+}
+
+void free_udp_peer_table(UdpPeerTable* table) { SDL_free(table->slots); }
+
+UdpPeer* get_udp_peer(UdpPeerTable* table, int index) { return (UdpPeer*)(table->entries + index * table->entry_size); }
+
+u32 get_udp_peer_home_slot(UdpPeerTable* table, UdpPeer peer)
+{
+    return (u32)mix_hash((u64)peer.address << 16 | peer.port, peer.id) & table->mask;
+}
+
+bool udp_peers_equal(UdpPeer left, UdpPeer right)
+{
+    return left.address == right.address && left.port == right.port && left.id == right.id;
+}
+
+// the slot that holds the peer's index or, if there is none, the empty slot where it would go
+int* find_udp_peer_slot(UdpPeerTable* table, UdpPeer peer)
+{
+    auto slot = get_udp_peer_home_slot(table, peer);
+    while (table->slots[slot] != -1 && !udp_peers_equal(*get_udp_peer(table, table->slots[slot]), peer))
+    { slot = (slot + 1) & table->mask; }
+    return &table->slots[slot];
+}
+
+// takes entry index out of the table and moves the entry at last into its place; closes the gap in the table by
+// pulling back entries that probed past it
+void remove_udp_peer(UdpPeerTable* table, int index, int last)
+{
+    auto hole = (u32)(find_udp_peer_slot(table, *get_udp_peer(table, index)) - table->slots);
+    table->slots[hole] = -1;
+    for (auto slot = (hole + 1) & table->mask; table->slots[slot] != -1; slot = (slot + 1) & table->mask)
+    {
+        auto home = get_udp_peer_home_slot(table, *get_udp_peer(table, table->slots[slot]));
+        // the entry can move to the hole unless its home lies cyclically after the hole, up to the entry itself
+        if (((slot - home) & table->mask) >= ((slot - hole) & table->mask))
+        {
+            table->slots[hole] = table->slots[slot];
+            table->slots[slot] = -1;
+            hole = slot;
+        }
+    }
+
+    if (index != last)
+    {
+        *find_udp_peer_slot(table, *get_udp_peer(table, last)) = index;
+        copy_memory(table->entry_size, get_udp_peer(table, last), get_udp_peer(table, index));
+    }
+}
+
+// opens the socket a service listens on and a poller for it; false, having said so, if the port can't be had
+bool open_udp_service(u16 port, s64* socket, s64* poller)
+{
+    *socket = platform_open_udp_socket(port);
+    if (*socket == -1)
+    {
+        print("Can't open UDP port ");
+        print((u64)port);
+        print("\n");
+        return false;
+    }
+    *poller = platform_open_udp_poller(*socket);
+    if (*poller == -1) { panic("Can't wait on a UDP socket"); }
+    return true;
+}
+
+typedef void UdpRequestReceiver(void* data, void* packet, u64 size, UdpPeer sender);
+
+// hands every packet waiting on the socket to receive, UDP_RECEIVE_BATCH at a time; the sender's id is left 0 for
+// receive to fill in from the packet
+void receive_udp_requests(s64 socket, UdpRequestReceiver* receive, void* data)
+{
+    u8 packets[UDP_RECEIVE_BATCH][MAX_UDP_REQUEST_BYTES];
+    UdpDatagram datagrams[UDP_RECEIVE_BATCH];
+    while (true)
+    {
+        for (auto i = 0; i < UDP_RECEIVE_BATCH; i++)
+        {
+            datagrams[i].data = packets[i];
+            datagrams[i].size = sizeof(packets[i]);
+        }
+        auto count = platform_receive_udp_batch(socket, datagrams, UDP_RECEIVE_BATCH);
+        for (auto i = 0; i < count; i++)
+        {
+            UdpPeer sender;
+            sender.address = datagrams[i].address;
+            sender.port = datagrams[i].port;
+            sender.id = 0;
+            receive(data, packets[i], datagrams[i].size, sender);
+        }
+        if (count < UDP_RECEIVE_BATCH) { break; }
+    }
+}
+
+#define SERVER_TICK_MS 16
+#define SERVER_MAGIC 0x56525354 // "TSRV"
+#define SERVER_INPUT_HISTORY 4
+#define SERVER_SESSION_TIMEOUT_TICKS (5000 / SERVER_TICK_MS)
+#define SERVER_KEEPALIVE_TICKS (1000 / SERVER_TICK_MS)
+#define SERVER_RESEND_TICKS 4 // an unacknowledged state goes again after this long, more than a round trip takes
+#define SERVER_SESSION_BATCH 64
+#define SERVER_RESTART_BIT (1 << 15) // enter, on top of pack_versus_input, since a thin client restarts its own game
+#define SERVER_LATENCY_SAMPLES 1024 // the last ticks the percentiles cover
+#define SERVER_REPORT_TICKS (5000 / SERVER_TICK_MS)
+#define SERVER_SIMULATOR_SOCKETS 8
+#define SERVER_SIMULATOR_PRESS_ODDS 8 // a simulated client presses something one tick in this many
+#define DEFAULT_SERVER_PORT 27100
+#define DEFAULT_MAX_SERVER_SESSIONS 20000
+#define DEFAULT_SERVER_BENCH_SESSIONS 2000
+#define DEFAULT_SERVER_BENCH_SECONDS 10
+
+struct ServerInputPacket
+{
+    u32 magic;
+    u32 client_id;
+    u32 sequence; // of inputs[0]
+    u32 state_tick; // of the newest state the client has, 0 for none
+    u16 inputs[SERVER_INPUT_HISTORY]; // newest first, inputs[i] is for sequence - i
+};
+
+static_assert(sizeof(ServerInputPacket) <= MAX_UDP_REQUEST_BYTES, "input packets won't fit the receive buffers");
+
+struct ServerView
+{
+    s32 score;
+    u8 mode;
+    u8 board[BOARD_HEIGHT]; // bit x of board[y] is the cell at (x, y)
+    u8 falling_shape[BOARD_HEIGHT]; // the same for the falling shape's cells
+};
+
+struct ServerStatePacket
+{
+    u32 magic;
+    u32 client_id;
+    u32 tick; // ticks start at 1
+    u32 input_sequence; // the newest input applied
+    ServerView view;
+};
+
+struct ServerSession
+{
+    UdpPeer client; // the id is the client id
+    u32 input_sequence;
+    u16 pending_input; // presses since the last tick
+    u32 last_heard_tick;
+    u32 acknowledged_tick; // the client has the state of this tick
+    u32 view_tick; // when view last changed
+    u32 sent_tick;
+    ServerView view;
+    GameState state;
+};
+
+struct ServerStats
+{
+    u64 ticks;
+    u64 packets_received;
+    u64 packets_ignored; // malformed, or a new client while the server is full
+    u64 states_sent;
+    u64 send_failures;
+    u64 sessions_opened;
+    u64 sessions_closed;
+    u64 tick_nanoseconds[SERVER_LATENCY_SAMPLES]; // by tick, from the start of the tick to the last state sent
+    u64 busy_nanoseconds; // summed over the workers, running sessions
+    u64 session_ticks;
+};
+
+struct Server
+{
+    s64 socket;
+    s64 poller;
+    int max_sessions;
+    int session_count;
+    ServerSession* sessions;
+    UdpPeerTable table;
+    u32 tick;
+    u64 next_tick_nanoseconds;
+    s32 next_seed;
+    // written by each worker during a tick
+    u64 worker_busy_nanoseconds[MAX_JOB_WORKERS];
+    u64 worker_states_sent[MAX_JOB_WORKERS];
+    u64 worker_send_failures[MAX_JOB_WORKERS];
+    ServerStats stats;
+};
+
+Server* start_server(u16 port, int max_sessions)
+{
+    auto server = (Server*)SDL_calloc(1, sizeof(Server));
+    if (server == NULL) { panic("Out of memory for the server"); }
+    if (!open_udp_service(port, &server->socket, &server->poller))
+    {
+        SDL_free(server);
+        return NULL;
+    }
+    server->max_sessions = max_sessions;
+    server->sessions = (ServerSession*)SDL_malloc(max_sessions * sizeof(ServerSession));
+    if (server->sessions == NULL) { panic("Out of memory for server sessions"); }
+    start_udp_peer_table(&server->table, server->sessions, sizeof(ServerSession), max_sessions);
+    server->tick = 1;
+    server->next_tick_nanoseconds = get_monotonic_nanoseconds();
+    return server;
+}
+
+void free_server(Server* server)
+{
+    platform_close_udp_poller(server->poller);
+    platform_close_udp_socket(server->socket);
+    free_udp_peer_table(&server->table);
+    SDL_free(server->sessions);
+    SDL_free(server);
+}
+
+// -1 if the server is full
+int open_server_session(Server* server, int* table_slot, UdpPeer client, u32 sequence)
+{
+    if (server->session_count == server->max_sessions) { return -1; }
+    auto index = server->session_count++;
+    auto session = &server->sessions[index];
+    session->client = client;
+    session->input_sequence = sequence - 1;
+    session->pending_input = 0;
+    session->last_heard_tick = server->tick;
+    session->acknowledged_tick = 0;
+    session->view_tick = server->tick;
+    session->sent_tick = 0;
+    set_memory(0, sizeof(session->view), &session->view);
+    initialize_game_state(server->next_seed++, &session->state);
+    *table_slot = index;
+    server->stats.sessions_opened++;
+    return index;
+}
+
+void close_server_session(Server* server, int index)
+{
+    remove_udp_peer(&server->table, index, server->session_count - 1);
+    server->session_count--;
+    server->stats.sessions_closed++;
+}
+
+void receive_server_packet(void* data, void* bytes, u64 size, UdpPeer client)
+{
+    auto server = (Server*)data;
+    auto packet = (ServerInputPacket*)bytes;
+    server->stats.packets_received++;
+    if (size != sizeof(*packet) || packet->magic != SERVER_MAGIC)
+    {
+        server->stats.packets_ignored++;
+        return;
+    }
+    client.id = packet->client_id;
+    auto table_slot = find_udp_peer_slot(&server->table, client);
+    auto index = *table_slot;
+    if (index == -1) { index = open_server_session(server, table_slot, client, packet->sequence); }
+    if (index == -1)
+    {
+        server->stats.packets_ignored++;
+        return;
+    }
+    auto session = &server->sessions[index];
+    session->last_heard_tick = server->tick;
+    if ((s32)(packet->state_tick - session->acknowledged_tick) > 0 && (s32)(packet->state_tick - server->tick) < 0)
+    { session->acknowledged_tick = packet->state_tick; }
+    auto fresh = (s32)(packet->sequence - session->input_sequence);
+    if (fresh <= 0) { return; } // late or repeated
+    for (auto i = MIN(fresh, SERVER_INPUT_HISTORY) - 1; i >= 0; i--) { session->pending_input |= packet->inputs[i]; }
+    session->input_sequence = packet->sequence;
+}
+
+ServerView get_server_view(GameState* state)
+{
+    ServerView result;
+    set_memory(0, sizeof(result), &result);
+    result.score = state->score;
+    result.mode = (u8)state->mode;
+    for (auto y = 0; y < BOARD_HEIGHT; y++)
+    {
+        result.board[y] = (u8)pack_cell_map_row(y, state->board);
+        auto shape_y = y - state->falling_shape.y;
+        if (shape_y >= 0 && shape_y < state->falling_shape.cell_map.height)
+        { result.falling_shape[y] = (u8)(pack_cell_map_row(shape_y, state->falling_shape.cell_map) << MAX(state->falling_shape.x, 0)); }
+    }
+    return result;
+}
+
+// the worker that runs a batch of sessions sends their states too, in one platform_send_udp_batch
+void run_server_sessions(void* data, int begin, int end)
+{
+    auto start = get_monotonic_nanoseconds();
+    auto server = (Server*)data;
+    ServerStatePacket packets[SERVER_SESSION_BATCH];
+    UdpDatagram datagrams[SERVER_SESSION_BATCH];
+    auto count = 0;
+    auto sent = 0;
+    auto failed = 0;
+    for (auto i = begin; i < end; i++)
+    {
+        auto session = &server->sessions[i];
+        auto input = unpack_versus_input(session->pending_input);
+        input.enter = (session->pending_input & SERVER_RESTART_BIT) != 0;
+        session->pending_input = 0;
+        process_input(SERVER_TICK_MS, input, &session->state);
+
+        auto view = get_server_view(&session->state);
+        if (!memory_equals(sizeof(view), &view, &session->view))
+        {
+            session->view = view;
+            session->view_tick = server->tick;
+        }
+        auto since_sent = server->tick - session->sent_tick;
+        auto unsent = (s32)(session->view_tick - session->sent_tick) > 0;
+        auto unacknowledged = (s32)(session->view_tick - session->acknowledged_tick) > 0;
+        if (unsent || (unacknowledged && since_sent >= SERVER_RESEND_TICKS) || since_sent >= SERVER_KEEPALIVE_TICKS)
+        {
+            auto packet = &packets[count];
+            packet->magic = SERVER_MAGIC;
+            packet->client_id = session->client.id;
+            packet->tick = server->tick;
+            packet->input_sequence = session->input_sequence;
+            packet->view = view;
+            datagrams[count].address = session->client.address;
+            datagrams[count].port = session->client.port;
+            datagrams[count].data = packet;
+            datagrams[count].size = sizeof(*packet);
+            session->sent_tick = server->tick;
+            count++;
+        }
+        if (count == SERVER_SESSION_BATCH || (i == end - 1 && count != 0))
+        {
+            auto batch_sent = platform_send_udp_batch(server->socket, datagrams, count);
+            sent += batch_sent;
+            failed += count - batch_sent;
+            count = 0;
+        }
+    }
+    auto worker = get_job_worker_index();
+    server->worker_states_sent[worker] += sent;
+    server->worker_send_failures[worker] += failed;
+    server->worker_busy_nanoseconds[worker] += get_monotonic_nanoseconds() - start;
+}
+
+void run_server_tick(Server* server)
+{
+    auto start = get_monotonic_nanoseconds();
+    for (auto i = 0; i < server->session_count; )
+    {
+        if (server->tick - server->sessions[i].last_heard_tick > SERVER_SESSION_TIMEOUT_TICKS) { close_server_session(server, i); }
+        else { i++; }
+    }
+    parallel_for(run_server_sessions, server, server->session_count, SERVER_SESSION_BATCH);
+
+    auto stats = &server->stats;
+    stats->tick_nanoseconds[stats->ticks % SERVER_LATENCY_SAMPLES] = get_monotonic_nanoseconds() - start;
+    for (auto i = 0; i < MAX_JOB_WORKERS; i++)
+    {
+        stats->busy_nanoseconds += server->worker_busy_nanoseconds[i];
+        stats->states_sent += server->worker_states_sent[i];
+        stats->send_failures += server->worker_send_failures[i];
+        server->worker_busy_nanoseconds[i] = 0;
+        server->worker_states_sent[i] = 0;
+        server->worker_send_failures[i] = 0;
+    }
+    stats->session_ticks += server->session_count;
+    stats->ticks++;
+    server->tick++;
+}
+
+// the value below which percent of the samples fall; sorts them
+u64 get_percentile(u64* samples, int count, float percent)
+{
+    for (auto i = 1; i < count; i++)
+    {
+        auto sample = samples[i];
+        auto j = i;
+        for (; j > 0 && samples[j - 1] > sample; j--) { samples[j] = samples[j - 1]; }
+        samples[j] = sample;
+    }
+    return samples[MIN((int)(percent / 100 * count), count - 1)];
+}
+
+// sessions per core is how many sessions one core could keep up with at SERVER_TICK_MS, going by the time spent running
+// them; the sessions' share of the table counts toward their memory
+void print_server_report(Server* server)
+{
+    auto stats = &server->stats;
+    if (stats->ticks == 0) { return; }
+    u64 samples[SERVER_LATENCY_SAMPLES];
+    auto count = (int)MIN(stats->ticks, (u64)SERVER_LATENCY_SAMPLES);
+    copy_memory(count * sizeof(u64), stats->tick_nanoseconds, samples);
+    float percents[] = { 50, 90, 99, 100 };
+    char* names[] = { "p50 ", ", p90 ", ", p99 ", ", max " };
+    print("sessions ");
+    print((s64)server->session_count);
+    print(", tick us ");
+    for (auto i = 0; i < countof(percents); i++)
+    {
+        print(names[i]);
+        print(get_percentile(samples, count, percents[i]) / 1000.0f);
+    }
+    print(", sessions per core ");
+    auto session_nanoseconds = stats->session_ticks == 0 ? 0 : (float)stats->busy_nanoseconds / stats->session_ticks;
+    print(session_nanoseconds == 0 ? 0 : SERVER_TICK_MS * 1e6f / session_nanoseconds);
+    print(", bytes per session ");
+    print((u64)(sizeof(ServerSession) + 2 * sizeof(int)));
+    print(", packets in ");
+    print(stats->packets_received);
+    print(" (");
+    print(stats->packets_ignored);
+    print(" ignored), states out ");
+    print(stats->states_sent);
+    print(" (");
+    print(stats->send_failures);
+    print(" failed, ");
+    print(100.0f * stats->states_sent / MAX(stats->session_ticks, 1ull));
+    print("% of session ticks), sessions opened ");
+    print(stats->sessions_opened);
+    print(", closed ");
+    print(stats->sessions_closed);
+    print("\n");
+}
+
+// runs ticks until end_nanoseconds, or forever with a report every SERVER_REPORT_TICKS when it's 0
+void run_server(Server* server, u64 end_nanoseconds)
+{
+    while (end_nanoseconds == 0 || get_monotonic_nanoseconds() < end_nanoseconds)
+    {
+        receive_udp_requests(server->socket, receive_server_packet, server);
+        auto now = get_monotonic_nanoseconds();
+        if (now < server->next_tick_nanoseconds)
+        {
+            // rounded up, so the wait doesn't spin through the last millisecond
+            platform_wait_for_udp(server->poller, (int)((server->next_tick_nanoseconds - now + 999999) / 1000000));
+            continue;
+        }
+        run_server_tick(server);
+        server->next_tick_nanoseconds += SERVER_TICK_MS * 1000000ull;
+        // a server that fell far behind skips ticks rather than running them back to back
+        if (now > server->next_tick_nanoseconds + 10 * SERVER_TICK_MS * 1000000ull) { server->next_tick_nanoseconds = now; }
+        if (end_nanoseconds == 0 && server->stats.ticks % SERVER_REPORT_TICKS == 0) { print_server_report(server); }
+    }
+}
+
+int run_server_command(int port, int max_sessions)
+{
+    initialize_shape_cell_maps();
+    auto server = start_server((u16)port, max_sessions);
+    if (server == NULL) { return 1; }
+    print("serving on UDP port ");
+    print((s64)port);
+    print("\n");
+    run_server(server, 0);
+    free_server(server);
+    return 0;
+}
+
+struct ServerClient
+{
+    u32 sequence;
+    u16 inputs[SERVER_INPUT_HISTORY];
+    u32 state_tick; // of the newest state
+    u32 acknowledged_tick; // the newest state_tick sent back
+    u32 sent_sequence;
+    ServerView view;
+};
+
+// thin clients, SERVER_SIMULATOR_SOCKETS sockets' worth, pressing random keys while pressing is set
+struct ServerSimulator
+{
+    SDL_atomic_t running;
+    SDL_atomic_t pressing;
+    u16 server_port;
+    int client_count;
+    ServerClient* clients; // client ids are indices + 1
+    s64 sockets[SERVER_SIMULATOR_SOCKETS];
+    RandomNumberGenerator random;
+    u64 inputs_sent;
+    u64 states_received;
+    u64 states_ignored;
+};
+
+void receive_simulated_states(ServerSimulator* simulator, s64 socket)
+{
+    ServerStatePacket packet;
+    u32 address;
+    u16 port;
+    s64 size;
+    while ((size = platform_receive_udp(socket, &packet, sizeof(packet), &address, &port)) >= 0)
+    {
+        if (size != sizeof(packet) || packet.magic != SERVER_MAGIC || packet.client_id == 0 || packet.client_id > (u32)simulator->client_count)
+        {
+            simulator->states_ignored++;
+            continue;
+        }
+        simulator->states_received++;
+        auto client = &simulator->clients[packet.client_id - 1];
+        if ((s32)(packet.tick - client->state_tick) <= 0) { continue; } // out of order
+        client->state_tick = packet.tick;
+        client->view = packet.view;
+    }
+}
+
+int run_server_simulator(void* data)
+{
+    auto simulator = (ServerSimulator*)data;
+    u16 keys[] = { 1, 1 << 1, 1 << 2, 1 << 3, 1 << 4 }; // left, right, down, up, r
+    auto next_tick = get_monotonic_nanoseconds();
+    while (SDL_AtomicGet(&simulator->running))
+    {
+        auto pressing = SDL_AtomicGet(&simulator->pressing) != 0;
+        for (auto i = 0; i < simulator->client_count; i++)
+        {
+            auto client = &simulator->clients[i];
+            u16 input = 0;
+            if (!pressing) {}
+            else if (client->view.mode == GameModeLost) { input = SERVER_RESTART_BIT; }
+            else if (get_random_number_in_range(0, SERVER_SIMULATOR_PRESS_ODDS, &simulator->random) == 0)
+            { input = keys[get_random_number_in_range(0, countof(keys), &simulator->random)]; }
+            auto pressed = input != 0;
+            for (auto j = SERVER_INPUT_HISTORY - 1; j > 0; j--)
+            {
+                client->inputs[j] = client->inputs[j - 1];
+                pressed |= client->inputs[j] != 0;
+            }
+            client->inputs[0] = input;
+            client->sequence++;
+            if (!pressed && client->acknowledged_tick == client->state_tick && client->sequence - client->sent_sequence < SERVER_KEEPALIVE_TICKS)
+            { continue; }
+
+            ServerInputPacket packet;
+            packet.magic = SERVER_MAGIC;
+            packet.client_id = i + 1;
+            packet.sequence = client->sequence;
+            packet.state_tick = client->state_tick;
+            copy_memory(sizeof(packet.inputs), client->inputs, packet.inputs);
+            if (platform_send_udp(simulator->sockets[i % SERVER_SIMULATOR_SOCKETS], VERSUS_LOOPBACK_ADDRESS, simulator->server_port, &packet, sizeof(packet)))
+            {
+                client->acknowledged_tick = client->state_tick;
+                client->sent_sequence = client->sequence;
+                simulator->inputs_sent++;
+            }
+        }
+        next_tick += SERVER_TICK_MS * 1000000ull;
+        while (get_monotonic_nanoseconds() < next_tick)
+        {
+            for (auto i = 0; i < SERVER_SIMULATOR_SOCKETS; i++) { receive_simulated_states(simulator, simulator->sockets[i]); }
+            SDL_Delay(1);
+        }
+    }
+    return 0;
+}
+
+// a server on this thread and the client simulator on another, over loopback
+int run_server_benchmark(int sessions, int seconds, int port)
+{
+    initialize_shape_cell_maps();
+    auto server = start_server((u16)port, sessions);
+    if (server == NULL) { return 1; }
+    auto simulator = (ServerSimulator*)SDL_calloc(1, sizeof(ServerSimulator));
+    if (simulator == NULL) { panic("Out of memory for the client simulator"); }
+    simulator->clients = (ServerClient*)SDL_calloc(sessions, sizeof(ServerClient));
+    if (simulator->clients == NULL) { panic("Out of memory for the client simulator"); }
+    simulator->server_port = (u16)port;
+    simulator->client_count = sessions;
+    seed_random_number_generator(port, &simulator->random);
+    for (auto i = 0; i < SERVER_SIMULATOR_SOCKETS; i++)
+    {
+        simulator->sockets[i] = platform_open_udp_socket((u16)(port + 1 + i));
+        if (simulator->sockets[i] == -1)
+        {
+            print("Can't open UDP port ");
+            print((s64)(port + 1 + i));
+            print("\n");
+            return 1;
+        }
+    }
+    SDL_AtomicSet(&simulator->running, 1);
+    SDL_AtomicSet(&simulator->pressing, 1);
+    auto thread = SDL_CreateThread(run_server_simulator, "server simulator", simulator);
+    if (thread == NULL) { panic_sdl("SDL_CreateThread"); }
+
+    for (auto second = 0; second < seconds; second++)
+    {
+        run_server(server, get_monotonic_nanoseconds() + 1000000000ull);
+        print_server_report(server);
+    }
+    // with the presses over, every client should catch up with its game; the server keeps ticking since a lost view
+    // is only sent again from a tick
+    SDL_AtomicSet(&simulator->pressing, 0);
+    run_server(server, get_monotonic_nanoseconds() + 250000000ull);
+    SDL_Delay(SERVER_TICK_MS * 4);
+    SDL_AtomicSet(&simulator->running, 0);
+    SDL_WaitThread(thread, NULL);
+
+    auto in_step = 0;
+    for (auto i = 0; i < sessions; i++)
+    {
+        UdpPeer client;
+        client.address = VERSUS_LOOPBACK_ADDRESS;
+        client.port = (u16)(port + 1 + i % SERVER_SIMULATOR_SOCKETS);
+        client.id = i + 1;
+        auto table_slot = find_udp_peer_slot(&server->table, client);
+        if (*table_slot == -1) { continue; }
+        auto session = &server->sessions[*table_slot];
+        in_step += memory_equals(sizeof(session->view), &session->view, &simulator->clients[i].view);
+    }
+    print("clients ");
+    print((s64)sessions);
+    print(", inputs sent ");
+    print(simulator->inputs_sent);
+    print(", states received ");
+    print(simulator->states_received);
+    print(", ignored ");
+    print(simulator->states_ignored);
+    print(", clients showing their game's latest view ");
+    print((s64)in_step);
+    print("\n");
+    auto all_served = server->stats.sessions_opened == (u64)sessions && in_step == sessions;
+    print(all_served ? (char*)"every client got a session and caught up with it\n" : (char*)"some clients never got a session or fell behind\n");
+
+    for (auto i = 0; i < SERVER_SIMULATOR_SOCKETS; i++) { platform_close_udp_socket(simulator->sockets[i]); }
+    SDL_free(simulator->clients);
+    SDL_free(simulator);
+    free_server(server);
+    return all_served ? 0 : 1;
+}
@@ -0,0 +1,571 @@
+// Spectator broadcast: one bot played game streamed to many viewers over UDP. Each tick the game's view (packed board
+// rows, the falling shape's cells and position, the score and the mode) is encoded once as a frame: the rows that
+// changed since the last frame sent, XORed with their old values, plus the falling shape whole, since that's a few
+// bytes. A tick where nothing changed sends nothing. The same bytes then go to every viewer, each batch of
+// SPECTATOR_FANOUT_BATCH datagrams pointing at the one frame, so nothing is copied per viewer on this side.
+//
+// A frame names the tick it was encoded against; a viewer applies it only on top of that tick, so a lost frame leaves
+// it unable to apply the next one. It then asks again, and the next tick it gets a keyframe (a frame encoded against
+// the empty view, tick 0), which is also what a new viewer gets first. Keyframes are encoded once per tick too, for
+// however many viewers need one. Viewers send a subscribe packet every SPECTATOR_KEEPALIVE_TICKS and are dropped after
+// SPECTATOR_TIMEOUT_TICKS without one. Like the game server's clients, a viewer is a UdpPeer, its address, port and
+// viewer id, kept in the same kind of table, so the benchmark's viewers can share a few sockets; viewers on one socket all see the same datagrams, so one decoder per
+// socket stands in for them.
+
+#define SPECTATOR_TICK_MS 16
+#define SPECTATOR_MAGIC 0x43455053 // "SPEC"
+#define SPECTATOR_KEEPALIVE_TICKS (1000 / SPECTATOR_TICK_MS)
+#define SPECTATOR_TIMEOUT_TICKS (5000 / SPECTATOR_TICK_MS)
+#define SPECTATOR_RETRY_TICKS 8 // between keyframe requests from a viewer that lost a frame
+#define SPECTATOR_FANOUT_BATCH 64
+#define SPECTATOR_REPORT_TICKS (5000 / SPECTATOR_TICK_MS)
+#define SPECTATOR_SHAPE_SIZE 4 // the falling shape's cells are packed 4 by 4
+#define SPECTATOR_SIMULATOR_SOCKETS 8
+#define MAX_SPECTATOR_FRAME_BYTES (sizeof(SpectatorFrameHeader) + BOARD_HEIGHT)
+#define DEFAULT_SPECTATOR_PORT 27200
+#define DEFAULT_MAX_SPECTATORS 100000
+#define DEFAULT_SPECTATOR_BENCH_VIEWERS 5000
+#define DEFAULT_SPECTATOR_BENCH_SECONDS 10
+
+struct SpectatorView
+{
+    s32 score;
+    u8 mode;
+    u8 board[BOARD_HEIGHT]; // bit x of board[y] is the cell at (x, y)
+    u16 shape_cells; // bit x + y * SPECTATOR_SHAPE_SIZE is the falling shape's cell at (x, y)
+    u8 shape_width, shape_height;
+    s8 shape_x, shape_y;
+};
+
+// followed by one XORed row for each bit set in changed_rows, top down
+struct SpectatorFrameHeader
+{
+    u32 magic;
+    u32 tick;
+    u32 base_tick; // the frame applies on top of this tick's view; 0 for a keyframe, which applies on the empty view
+    s32 score;
+    u32 changed_rows;
+    u16 shape_cells;
+    u8 shape_size; // width | height << 4
+    u8 mode;
+    s8 shape_x, shape_y;
+};
+
+struct SpectatorSubscribePacket
+{
+    u32 magic;
+    u32 viewer_id;
+    u32 tick; // of the newest frame the viewer applied, 0 when it needs a keyframe
+};
+
+static_assert(sizeof(SpectatorSubscribePacket) <= MAX_UDP_REQUEST_BYTES, "subscribe packets won't fit the receive buffers");
+
+struct Spectator
+{
+    UdpPeer peer; // the id is the viewer id
+    u32 last_heard_tick;
+    bool needs_keyframe;
+};
+
+struct SpectatorStats
+{
+    u64 ticks;
+    u64 frames_encoded;
+    u64 frame_bytes; // of the delta frames, so per tick it's what each up to date viewer costs
+    u64 keyframes_encoded;
+    u64 encode_nanoseconds;
+    u64 packets_received;
+    u64 packets_ignored;
+    u64 frames_sent;
+    u64 keyframes_sent;
+    u64 bytes_sent;
+    u64 send_failures;
+    u64 fanout_nanoseconds;
+    u64 viewer_ticks; // viewers summed over ticks
+    u64 viewers_subscribed;
+    u64 viewers_dropped;
+};
+
+struct SpectatorService
+{
+    s64 socket;
+    s64 poller;
+    int max_viewers;
+    int viewer_count;
+    Spectator* viewers;
+    UdpPeerTable table;
+    u32 tick;
+    u64 next_tick_nanoseconds;
+    GameState state;
+    Bot bot;
+    SpectatorView view; // as of the last frame sent
+    u32 view_tick;
+    int keyframes_wanted; // viewers whose needs_keyframe went up since the last tick
+    // this tick's frames, read by every fan-out job
+    u8 frame[MAX_SPECTATOR_FRAME_BYTES];
+    u64 frame_size; // 0 when nothing changed
+    u8 keyframe[MAX_SPECTATOR_FRAME_BYTES];
+    u64 keyframe_size;
+    // written by each worker during a tick
+    u64 worker_busy_nanoseconds[MAX_JOB_WORKERS];
+    u64 worker_frames_sent[MAX_JOB_WORKERS];
+    u64 worker_keyframes_sent[MAX_JOB_WORKERS];
+    u64 worker_bytes_sent[MAX_JOB_WORKERS];
+    u64 worker_send_failures[MAX_JOB_WORKERS];
+    SpectatorStats stats;
+};
+
+SpectatorView get_spectator_view(GameState* state)
+{
+    SpectatorView result;
+    set_memory(0, sizeof(result), &result);
+    result.score = state->score;
+    result.mode = (u8)state->mode;
+    for (auto y = 0; y < BOARD_HEIGHT; y++) { result.board[y] = (u8)pack_cell_map_row(y, state->board); }
+    auto shape = &state->falling_shape;
+    assert(shape->cell_map.width <= SPECTATOR_SHAPE_SIZE && shape->cell_map.height <= SPECTATOR_SHAPE_SIZE);
+    for (auto y = 0; y < shape->cell_map.height; y++)
+    { result.shape_cells |= (u16)(pack_cell_map_row(y, shape->cell_map) << (y * SPECTATOR_SHAPE_SIZE)); }
+    result.shape_width = (u8)shape->cell_map.width;
+    result.shape_height = (u8)shape->cell_map.height;
+    result.shape_x = (s8)shape->x;
+    result.shape_y = (s8)shape->y;
+    return result;
+}
+
+// the frame that turns base (the empty view for a keyframe) into view; returns its size
+u64 encode_spectator_frame(SpectatorView* base, u32 base_tick, SpectatorView* view, u32 tick, u8* buffer)
+{
+    SpectatorFrameHeader header;
+    set_memory(0, sizeof(header), &header);
+    header.magic = SPECTATOR_MAGIC;
+    header.tick = tick;
+    header.base_tick = base_tick;
+    header.score = view->score;
+    header.shape_cells = view->shape_cells;
+    header.shape_size = (u8)(view->shape_width | view->shape_height << 4);
+    header.mode = view->mode;
+    header.shape_x = view->shape_x;
+    header.shape_y = view->shape_y;
+    auto rows = buffer + sizeof(header);
+    for (auto y = 0; y < BOARD_HEIGHT; y++)
+    {
+        auto delta = (u8)(view->board[y] ^ base->board[y]);
+        if (delta == 0) { continue; }
+        header.changed_rows |= 1u << y;
+        *rows++ = delta;
+    }
+    copy_memory(sizeof(header), &header, buffer);
+    return rows - buffer;
+}
+
+// applies a frame to the view a viewer has as of *tick; false if it's malformed or meant for another tick
+bool apply_spectator_frame(u8* data, u64 size, SpectatorView* view, u32* tick)
+{
+    SpectatorFrameHeader header;
+    if (size < sizeof(header)) { return false; }
+    copy_memory(sizeof(header), data, &header);
+    auto row_count = 0;
+    for (auto y = 0; y < BOARD_HEIGHT; y++) { row_count += (header.changed_rows >> y) & 1; }
+    if (header.magic != SPECTATOR_MAGIC || size != sizeof(header) + row_count || header.changed_rows >> BOARD_HEIGHT != 0)
+    { return false; }
+    if (header.base_tick != *tick && header.base_tick != 0) { return false; }
+
+    if (header.base_tick == 0) { set_memory(0, sizeof(*view), view); }
+    auto rows = data + sizeof(header);
+    for (auto y = 0; y < BOARD_HEIGHT; y++)
+    {
+        if ((header.changed_rows >> y) & 1) { view->board[y] ^= *rows++; }
+    }
+    view->score = header.score;
+    view->mode = header.mode;
+    view->shape_cells = header.shape_cells;
+    view->shape_width = header.shape_size & 15;
+    view->shape_height = header.shape_size >> 4;
+    view->shape_x = header.shape_x;
+    view->shape_y = header.shape_y;
+    *tick = header.tick;
+    return true;
+}
+
+SpectatorService* start_spectator_service(u16 port, int max_viewers)
+{
+    auto service = (SpectatorService*)SDL_calloc(1, sizeof(SpectatorService));
+    if (service == NULL) { panic("Out of memory for the spectator service"); }
+    if (!open_udp_service(port, &service->socket, &service->poller))
+    {
+        SDL_free(service);
+        return NULL;
+    }
+    service->max_viewers = max_viewers;
+    service->viewers = (Spectator*)SDL_malloc(max_viewers * sizeof(Spectator));
+    if (service->viewers == NULL) { panic("Out of memory for spectators"); }
+    start_udp_peer_table(&service->table, service->viewers, sizeof(Spectator), max_viewers);
+    service->tick = 1;
+    service->next_tick_nanoseconds = get_monotonic_nanoseconds();
+    initialize_game_state(1, &service->state);
+    toggle_bot(&service->bot);
+    return service;
+}
+
+void free_spectator_service(SpectatorService* service)
+{
+    platform_close_udp_poller(service->poller);
+    platform_close_udp_socket(service->socket);
+    free_udp_peer_table(&service->table);
+    SDL_free(service->viewers);
+    SDL_free(service);
+}
+
+void drop_spectator(SpectatorService* service, int index)
+{
+    remove_udp_peer(&service->table, index, service->viewer_count - 1);
+    service->viewer_count--;
+    service->stats.viewers_dropped++;
+}
+
+void receive_spectator_packet(void* data, void* bytes, u64 size, UdpPeer sender)
+{
+    auto service = (SpectatorService*)data;
+    auto packet = (SpectatorSubscribePacket*)bytes;
+    service->stats.packets_received++;
+    if (size != sizeof(*packet) || packet->magic != SPECTATOR_MAGIC)
+    {
+        service->stats.packets_ignored++;
+        return;
+    }
+    sender.id = packet->viewer_id;
+    auto table_slot = find_udp_peer_slot(&service->table, sender);
+    if (*table_slot == -1)
+    {
+        if (service->viewer_count == service->max_viewers)
+        {
+            service->stats.packets_ignored++;
+            return;
+        }
+        *table_slot = service->viewer_count++;
+        auto viewer = &service->viewers[*table_slot];
+        viewer->peer = sender;
+        viewer->needs_keyframe = false;
+        service->stats.viewers_subscribed++;
+    }
+    auto viewer = &service->viewers[*table_slot];
+    viewer->last_heard_tick = service->tick;
+    // tick 0 from a new viewer, or one that lost a frame
+    if (packet->tick == 0 && !viewer->needs_keyframe)
+    {
+        viewer->needs_keyframe = true;
+        service->keyframes_wanted++;
+    }
+}
+
+// sends this tick's frame, or the keyframe to viewers that need one; every datagram points at the same bytes
+void fan_out_spectator_frames(void* data, int begin, int end)
+{
+    auto start = get_monotonic_nanoseconds();
+    auto service = (SpectatorService*)data;
+    UdpDatagram datagrams[SPECTATOR_FANOUT_BATCH];
+    auto count = 0;
+    u64 frames = 0, keyframes = 0, bytes = 0, failed = 0;
+    for (auto i = begin; i < end; i++)
+    {
+        auto viewer = &service->viewers[i];
+        auto keyframe = viewer->needs_keyframe;
+        if (keyframe || service->frame_size != 0)
+        {
+            datagrams[count].address = viewer->peer.address;
+            datagrams[count].port = viewer->peer.port;
+            datagrams[count].data = keyframe ? service->keyframe : service->frame;
+            datagrams[count].size = keyframe ? service->keyframe_size : service->frame_size;
+            viewer->needs_keyframe = false;
+            keyframes += keyframe;
+            bytes += datagrams[count].size;
+            count++;
+        }
+        if (count == SPECTATOR_FANOUT_BATCH || (i == end - 1 && count != 0))
+        {
+            auto sent = platform_send_udp_batch(service->socket, datagrams, count);
+            frames += sent;
+            failed += count - sent;
+            count = 0;
+        }
+    }
+    auto worker = get_job_worker_index();
+    service->worker_frames_sent[worker] += frames;
+    service->worker_keyframes_sent[worker] += keyframes;
+    service->worker_bytes_sent[worker] += bytes;
+    service->worker_send_failures[worker] += failed;
+    service->worker_busy_nanoseconds[worker] += get_monotonic_nanoseconds() - start;
+}
+
+void run_spectator_tick(SpectatorService* service)
+{
+    for (auto i = 0; i < service->viewer_count; )
+    {
+        if (service->tick - service->viewers[i].last_heard_tick > SPECTATOR_TIMEOUT_TICKS) { drop_spectator(service, i); }
+        else { i++; }
+    }
+    process_input(SPECTATOR_TICK_MS, get_bot_input(&service->bot, &service->state), &service->state);
+
+    auto stats = &service->stats;
+    auto start = get_monotonic_nanoseconds();
+    auto view = get_spectator_view(&service->state);
+    service->frame_size = 0;
+    if (!memory_equals(sizeof(view), &view, &service->view))
+    {
+        service->frame_size = encode_spectator_frame(&service->view, service->view_tick, &view, service->tick, service->frame);
+        service->view = view;
+        service->view_tick = service->tick;
+        stats->frames_encoded++;
+        stats->frame_bytes += service->frame_size;
+    }
+    if (service->keyframes_wanted != 0)
+    {
+        SpectatorView empty;
+        set_memory(0, sizeof(empty), &empty);
+        service->keyframe_size = encode_spectator_frame(&empty, 0, &service->view, service->view_tick, service->keyframe);
+        stats->keyframes_encoded++;
+        service->keyframes_wanted = 0;
+    }
+    stats->encode_nanoseconds += get_monotonic_nanoseconds() - start;
+
+    parallel_for(fan_out_spectator_frames, service, service->viewer_count, SPECTATOR_FANOUT_BATCH);
+    for (auto i = 0; i < MAX_JOB_WORKERS; i++)
+    {
+        stats->fanout_nanoseconds += service->worker_busy_nanoseconds[i];
+        stats->frames_sent += service->worker_frames_sent[i];
+        stats->keyframes_sent += service->worker_keyframes_sent[i];
+        stats->bytes_sent += service->worker_bytes_sent[i];
+        stats->send_failures += service->worker_send_failures[i];
+        service->worker_busy_nanoseconds[i] = 0;
+        service->worker_frames_sent[i] = 0;
+        service->worker_keyframes_sent[i] = 0;
+        service->worker_bytes_sent[i] = 0;
+        service->worker_send_failures[i] = 0;
+    }
+    stats->viewer_ticks += service->viewer_count;
+    stats->ticks++;
+    service->tick++;
+}
+
+// viewers per core is how many viewers one core could keep up with at SPECTATOR_TICK_MS, going by the fan-out time
+void print_spectator_report(SpectatorService* service)
+{
+    auto stats = &service->stats;
+    auto viewer_nanoseconds = stats->viewer_ticks == 0 ? 0 : (float)stats->fanout_nanoseconds / stats->viewer_ticks;
+    print("viewers ");
+    print((s64)service->viewer_count);
+    print(", bytes per tick ");
+    print((float)stats->frame_bytes / MAX(stats->ticks, 1ull));
+    print(" (full view ");
+    print((u64)(sizeof(SpectatorFrameHeader) + BOARD_HEIGHT));
+    print("), frames ");
+    print(stats->frames_encoded);
+    print(" in ");
+    print(stats->ticks);
+    print(" ticks, encode ns per tick ");
+    print((float)stats->encode_nanoseconds / MAX(stats->ticks, 1ull));
+    print(", ns per viewer per tick ");
+    print(viewer_nanoseconds);
+    print(", viewers per core ");
+    print(viewer_nanoseconds == 0 ? 0 : SPECTATOR_TICK_MS * 1e6f / viewer_nanoseconds);
+    print(", datagrams out ");
+    print(stats->frames_sent);
+    print(" (");
+    print(stats->keyframes_sent);
+    print(" keyframes, ");
+    print(stats->send_failures);
+    print(" failed), bytes out ");
+    print(stats->bytes_sent);
+    print(", subscribed ");
+    print(stats->viewers_subscribed);
+    print(", dropped ");
+    print(stats->viewers_dropped);
+    print("\n");
+}
+
+// runs ticks until end_nanoseconds, or forever with a report every SPECTATOR_REPORT_TICKS when it's 0
+void run_spectator_service(SpectatorService* service, u64 end_nanoseconds)
+{
+    while (end_nanoseconds == 0 || get_monotonic_nanoseconds() < end_nanoseconds)
+    {
+        receive_udp_requests(service->socket, receive_spectator_packet, service);
+        auto now = get_monotonic_nanoseconds();
+        if (now < service->next_tick_nanoseconds)
+        {
+            // rounded up, so the wait doesn't spin through the last millisecond
+            platform_wait_for_udp(service->poller, (int)((service->next_tick_nanoseconds - now + 999999) / 1000000));
+            continue;
+        }
+        run_spectator_tick(service);
+        service->next_tick_nanoseconds += SPECTATOR_TICK_MS * 1000000ull;
+        // a service that fell far behind skips ticks rather than running them back to back
+        if (now > service->next_tick_nanoseconds + 10 * SPECTATOR_TICK_MS * 1000000ull) { service->next_tick_nanoseconds = now; }
+        if (end_nanoseconds == 0 && service->stats.ticks % SPECTATOR_REPORT_TICKS == 0) { print_spectator_report(service); }
+    }
+}
+
+int run_spectator_command(int port, int max_viewers)
+{
+    initialize_shape_cell_maps();
+    auto service = start_spectator_service((u16)port, max_viewers);
+    if (service == NULL) { return 1; }
+    print("broadcasting on UDP port ");
+    print((s64)port);
+    print("\n");
+    run_spectator_service(service, 0);
+    free_spectator_service(service);
+    return 0;
+}
+
+// one socket's viewers; they all see every datagram sent to the socket, so they share a decoder
+struct SpectatorViewerSocket
+{
+    s64 socket;
+    SpectatorView view;
+    u32 tick; // of view, 0 before the first keyframe
+    u32 requested_tick; // the simulator's tick of the last keyframe request
+};
+
+struct SpectatorSimulator
+{
+    SDL_atomic_t running;
+    u16 service_port;
+    int viewer_count; // viewer ids are indices + 1, on socket index % SPECTATOR_SIMULATOR_SOCKETS
+    SpectatorViewerSocket sockets[SPECTATOR_SIMULATOR_SOCKETS];
+    u64 frames_received;
+    u64 frames_applied;
+    u64 frames_skipped; // duplicates and frames for a tick the socket didn't have
+    u64 keyframe_requests;
+};
+
+void send_spectator_subscribe(SpectatorSimulator* simulator, int viewer, u32 tick)
+{
+    SpectatorSubscribePacket packet;
+    packet.magic = SPECTATOR_MAGIC;
+    packet.viewer_id = viewer + 1;
+    packet.tick = tick;
+    platform_send_udp(simulator->sockets[viewer % SPECTATOR_SIMULATOR_SOCKETS].socket, VERSUS_LOOPBACK_ADDRESS, simulator->service_port, &packet, sizeof(packet));
+}
+
+int run_spectator_simulator(void* data)
+{
+    auto simulator = (SpectatorSimulator*)data;
+    // the keepalives are spread over the ticks between them
+    u32 tick = 0;
+    auto next_tick = get_monotonic_nanoseconds();
+    while (SDL_AtomicGet(&simulator->running))
+    {
+        for (auto i = (int)(tick % SPECTATOR_KEEPALIVE_TICKS); i < simulator->viewer_count; i += SPECTATOR_KEEPALIVE_TICKS)
+        { send_spectator_subscribe(simulator, i, simulator->sockets[i % SPECTATOR_SIMULATOR_SOCKETS].tick); }
+        next_tick += SPECTATOR_TICK_MS * 1000000ull;
+        tick++;
+        while (get_monotonic_nanoseconds() < next_tick)
+        {
+            for (auto i = 0; i < SPECTATOR_SIMULATOR_SOCKETS; i++)
+            {
+                auto viewer_socket = &simulator->sockets[i];
+                u8 buffer[MAX_SPECTATOR_FRAME_BYTES];
+                u32 address;
+                u16 port;
+                s64 size;
+                auto stuck = false;
+                while ((size = platform_receive_udp(viewer_socket->socket, buffer, sizeof(buffer), &address, &port)) >= 0)
+                {
+                    simulator->frames_received++;
+                    if (apply_spectator_frame(buffer, size, &viewer_socket->view, &viewer_socket->tick))
+                    {
+                        simulator->frames_applied++;
+                        stuck = false;
+                    }
+                    else
+                    {
+                        simulator->frames_skipped++;
+                        // a frame for a later tick than the socket has means one went missing
+                        SpectatorFrameHeader header;
+                        if (size >= (s64)sizeof(header))
+                        {
+                            copy_memory(sizeof(header), buffer, &header);
+                            stuck |= (s32)(header.base_tick - viewer_socket->tick) > 0;
+                        }
+                    }
+                }
+                if (stuck && tick - viewer_socket->requested_tick >= SPECTATOR_RETRY_TICKS && i < simulator->viewer_count)
+                {
+                    viewer_socket->requested_tick = tick;
+                    simulator->keyframe_requests++;
+                    send_spectator_subscribe(simulator, i, 0);
+                }
+            }
+            SDL_Delay(1);
+        }
+    }
+    return 0;
+}
+
+// the service on this thread and the viewers on another, over loopback; checks every socket ends up showing the game
+int run_spectator_benchmark(int viewers, int seconds, int port)
+{
+    initialize_shape_cell_maps();
+    auto service = start_spectator_service((u16)port, viewers);
+    if (service == NULL) { return 1; }
+    auto simulator = (SpectatorSimulator*)SDL_calloc(1, sizeof(SpectatorSimulator));
+    if (simulator == NULL) { panic("Out of memory for the spectator simulator"); }
+    simulator->service_port = (u16)port;
+    simulator->viewer_count = viewers;
+    for (auto i = 0; i < SPECTATOR_SIMULATOR_SOCKETS; i++)
+    {
+        simulator->sockets[i].socket = platform_open_udp_socket((u16)(port + 1 + i));
+        if (simulator->sockets[i].socket == -1)
+        {
+            print("Can't open UDP port ");
+            print((s64)(port + 1 + i));
+            print("\n");
+            return 1;
+        }
+    }
+    SDL_AtomicSet(&simulator->running, 1);
+    auto thread = SDL_CreateThread(run_spectator_simulator, "spectator simulator", simulator);
+    if (thread == NULL) { panic_sdl("SDL_CreateThread"); }
+
+    for (auto second = 0; second < seconds; second++)
+    {
+        run_spectator_service(service, get_monotonic_nanoseconds() + 1000000000ull);
+        print_spectator_report(service);
+    }
+    // the last frames need a moment to arrive
+    SDL_Delay(SPECTATOR_TICK_MS * 4);
+    SDL_AtomicSet(&simulator->running, 0);
+    SDL_WaitThread(thread, NULL);
+
+    auto in_step = 0;
+    for (auto i = 0; i < SPECTATOR_SIMULATOR_SOCKETS; i++)
+    {
+        auto viewer_socket = &simulator->sockets[i];
+        in_step += viewer_socket->tick == service->view_tick
+            && memory_equals(sizeof(viewer_socket->view), &viewer_socket->view, &service->view);
+    }
+    auto used_sockets = MIN(viewers, SPECTATOR_SIMULATOR_SOCKETS);
+    print("viewers ");
+    print((s64)viewers);
+    print(", frames received ");
+    print(simulator->frames_received);
+    print(", applied ");
+    print(simulator->frames_applied);
+    print(", skipped ");
+    print(simulator->frames_skipped);
+    print(", keyframe requests ");
+    print(simulator->keyframe_requests);
+    print(", viewer sockets showing the latest frame ");
+    print((s64)in_step);
+    print(" of ");
+    print((s64)used_sockets);
+    print("\n");
+    auto all_served = service->stats.viewers_subscribed == (u64)viewers && in_step == used_sockets;
+    print(all_served ? (char*)"every viewer subscribed and kept up with the game\n" : (char*)"some viewers never subscribed or fell behind\n");
+
+    for (auto i = 0; i < SPECTATOR_SIMULATOR_SOCKETS; i++) { platform_close_udp_socket(simulator->sockets[i].socket); }
+    SDL_free(simulator);
+    free_spectator_service(service);
+    return all_served ? 0 : 1;
+}
@@ -0,0 +1,331 @@
+// Terminal frontend: the game screen drawn with ANSI escape sequences, for watching games over SSH or on a box without
+// SDL. The layout follows draw_game_screen: power ups on the left, the board in the middle with each cell two columns
+// wide, the score on the right. Each frame is composed into a grid of character cells and compared with the grid the
+// terminal already shows, and only the cells that changed are written, with a cursor move only where the changed cells
+// aren't next to each other and a color change only where the color differs from the last one written. A frame goes
+// out in one write.
+//
+// Colors are from the xterm 256 color palette; the board color is the nearest one in its 6x6x6 cube, so the board is
+// only redrawn when the color cycles far enough to land on another.
+
+#define TERMINAL_TICK_MS 16
+#define TERMINAL_ROWS (BOARD_HEIGHT + 2)
+#define TERMINAL_COLUMNS 64
+#define TERMINAL_BOARD_COLUMN 18 // of the left border
+#define TERMINAL_MAX_GAP 4 // unchanged cells worth rewriting rather than moving the cursor over them
+#define TERMINAL_MAX_OUTPUT (TERMINAL_ROWS * TERMINAL_COLUMNS * 32)
+#define TERMINAL_GAME_OVER_FRAMES (1000 / TERMINAL_TICK_MS)
+#define TERMINAL_DEFAULT_COLOR 0 // the terminal's own; palette color 0 is never used, 16 is black
+#define TERMINAL_BORDER_COLOR 90 // LIGHT_PURPLE
+#define TERMINAL_FALLING_SHAPE_COLOR 46 // 0x00ff00
+#define TERMINAL_GAME_OVER_COLOR 196 // RED
+#define DEFAULT_TERMINAL_MAX_SHAPES 200
+
+struct TerminalCell
+{
+    char glyph;
+    u8 foreground;
+    u8 background;
+};
+
+struct TerminalScreen
+{
+    TerminalCell cells[TERMINAL_ROWS][TERMINAL_COLUMNS]; // the frame being composed
+    TerminalCell shown[TERMINAL_ROWS][TERMINAL_COLUMNS]; // what the terminal shows
+    // the terminal's cursor and colors; a cursor_x of -1 means unknown
+    int cursor_x, cursor_y;
+    u8 foreground, background;
+    char output[TERMINAL_MAX_OUTPUT];
+    String pending;
+    u64 frames;
+    u64 bytes;
+    u64 max_frame_bytes;
+    u64 first_frame_bytes;
+};
+
+u8 get_terminal_color(Pixel color)
+{
+    auto red = (color >> 16) & 0xff;
+    auto green = (color >> 8) & 0xff;
+    auto blue = color & 0xff;
+    return (u8)(16 + 36 * ((red * 5 + 127) / 255) + 6 * ((green * 5 + 127) / 255) + (blue * 5 + 127) / 255);
+}
+
+void put_terminal_text(TerminalScreen* screen, int x, int y, String text, u8 foreground)
+{
+    for (auto i = 0; i < (int)text.size && x + i < TERMINAL_COLUMNS; i++)
+    {
+        if (x + i < 0) { continue; }
+        auto cell = &screen->cells[y][x + i];
+        cell->glyph = text.data[i];
+        cell->foreground = foreground;
+    }
+}
+
+// "<label><value>", starting at x or, when right_aligned, ending just before it
+void put_terminal_label(TerminalScreen* screen, int x, int y, bool right_aligned, char* label, s64 value)
+{
+    char buffer[64];
+    auto text = make_string(0, buffer);
+    push(label, &text);
+    int_to_string(value, &text);
+    put_terminal_text(screen, right_aligned ? x - (int)text.size : x, y, text, TERMINAL_DEFAULT_COLOR);
+}
+
+void put_terminal_board_cell(TerminalScreen* screen, int x, int y, u8 background)
+{
+    for (auto i = 0; i < 2; i++) { screen->cells[y + 1][TERMINAL_BOARD_COLUMN + 1 + 2 * x + i].background = background; }
+}
+
+void compose_terminal_frame(TerminalScreen* screen, GameState* state)
+{
+    for (auto y = 0; y < TERMINAL_ROWS; y++)
+    {
+        for (auto x = 0; x < TERMINAL_COLUMNS; x++)
+        {
+            auto cell = &screen->cells[y][x];
+            cell->glyph = ' ';
+            cell->foreground = TERMINAL_DEFAULT_COLOR;
+            cell->background = TERMINAL_DEFAULT_COLOR;
+        }
+    }
+
+    // border
+    auto right_border = TERMINAL_BOARD_COLUMN + 1 + 2 * BOARD_WIDTH;
+    for (auto y = 0; y < TERMINAL_ROWS; y++)
+    {
+        auto edge = y == 0 || y == TERMINAL_ROWS - 1;
+        for (auto x = TERMINAL_BOARD_COLUMN; x <= right_border; x++)
+        {
+            auto side = x == TERMINAL_BOARD_COLUMN || x == right_border;
+            if (!edge && !side) { continue; }
+            screen->cells[y][x].glyph = edge && side ? '+' : edge ? '-' : '|';
+            screen->cells[y][x].foreground = TERMINAL_BORDER_COLOR;
+        }
+    }
+
+    // cells
+    auto board_color = get_terminal_color(state->board_color);
+    for (auto y = 0; y < BOARD_HEIGHT; y++)
+    {
+        for (auto x = 0; x < BOARD_WIDTH; x++)
+        {
+            if (get_cell(x, y, state->board)) { put_terminal_board_cell(screen, x, y, board_color); }
+        }
+    }
+
+    // falling shape
+    if (state->mode != GameModeLost)
+    {
+        auto cell_map = state->falling_shape.cell_map;
+        for (auto map_y = 0; map_y < cell_map.height; map_y++)
+        {
+            for (auto map_x = 0; map_x < cell_map.width; map_x++)
+            {
+                auto x = state->falling_shape.x + map_x;
+                auto y = state->falling_shape.y + map_y;
+                if (get_cell(map_x, map_y, cell_map) && x >= 0 && x < BOARD_WIDTH && y >= 0 && y < BOARD_HEIGHT)
+                { put_terminal_board_cell(screen, x, y, TERMINAL_FALLING_SHAPE_COLOR); }
+            }
+        }
+    }
+
+    // score, high score and power ups
+    put_terminal_label(screen, right_border + 2, 1, false, "Score: ", state->score);
+    put_terminal_label(screen, right_border + 2, 2, false, "High Score: ", state->high_score);
+    put_terminal_label(screen, TERMINAL_BOARD_COLUMN - 1, 1, true, "Mirror shape: ", state->power_ups.mirror);
+    put_terminal_label(screen, TERMINAL_BOARD_COLUMN - 1, 2, true, "Fill cell: ", state->power_ups.fill_cell);
+    put_terminal_label(screen, TERMINAL_BOARD_COLUMN - 1, 3, true, "Invert board: ", state->power_ups.invert_board);
+    put_terminal_label(screen, TERMINAL_BOARD_COLUMN - 1, 4, true, "Bomb: ", state->power_ups.bomb);
+
+    // GAME OVER and PAUSED over the middle of the board
+    char* overlay = state->mode == GameModeLost ? (char*)" GAME OVER " : state->mode == GameModePause ? (char*)" PAUSED " : NULL;
+    if (overlay != NULL)
+    {
+        auto text = make_string(c_string_length(overlay), overlay);
+        auto x = TERMINAL_BOARD_COLUMN + 1 + BOARD_WIDTH - (int)text.size / 2;
+        auto color = state->mode == GameModeLost ? TERMINAL_GAME_OVER_COLOR : TERMINAL_DEFAULT_COLOR;
+        put_terminal_text(screen, x, TERMINAL_ROWS / 2, text, (u8)color);
+        for (auto i = 0; i < (int)text.size; i++) { screen->cells[TERMINAL_ROWS / 2][x + i].background = TERMINAL_DEFAULT_COLOR; }
+    }
+}
+
+// SGR for the colors that differ from what the terminal has, leaving the foreground alone for a space; 39 and 49 go
+// back to the terminal's own colors
+void set_terminal_colors(TerminalScreen* screen, char glyph, u8 foreground, u8 background)
+{
+    auto output = &screen->pending;
+    if (foreground != screen->foreground && glyph != ' ')
+    {
+        if (foreground == TERMINAL_DEFAULT_COLOR) { push("\x1b[39m", output); }
+        else
+        {
+            push("\x1b[38;5;", output);
+            uint_to_string(foreground, output);
+            push('m', output);
+        }
+        screen->foreground = foreground;
+    }
+    if (background != screen->background)
+    {
+        if (background == TERMINAL_DEFAULT_COLOR) { push("\x1b[49m", output); }
+        else
+        {
+            push("\x1b[48;5;", output);
+            uint_to_string(background, output);
+            push('m', output);
+        }
+        screen->background = background;
+    }
+}
+
+void write_terminal_cell(TerminalScreen* screen, int x, int y)
+{
+    auto cell = screen->cells[y][x];
+    set_terminal_colors(screen, cell.glyph, cell.foreground, cell.background);
+    push(cell.glyph, &screen->pending);
+    screen->shown[y][x] = cell;
+    screen->cursor_x = x + 1;
+    // past the last column the cursor waits to wrap, and terminals disagree on what it does then
+    if (screen->cursor_x == TERMINAL_COLUMNS) { screen->cursor_x = -1; }
+}
+
+bool terminal_cells_equal(TerminalCell left, TerminalCell right)
+{
+    return left.glyph == right.glyph && left.foreground == right.foreground && left.background == right.background;
+}
+
+// the cells from the cursor up to x can be rewritten instead of moving over them: close, unchanged and in the colors
+// the terminal already has
+bool can_rewrite_terminal_gap(TerminalScreen* screen, int x, int y)
+{
+    if (screen->cursor_x == -1 || screen->cursor_y != y || x < screen->cursor_x || x - screen->cursor_x > TERMINAL_MAX_GAP)
+    { return false; }
+    for (auto gap_x = screen->cursor_x; gap_x < x; gap_x++)
+    {
+        auto cell = screen->shown[y][gap_x];
+        if ((cell.foreground != screen->foreground && cell.glyph != ' ') || cell.background != screen->background) { return false; }
+    }
+    return true;
+}
+
+// writes the cells that differ from what the terminal shows; returns the bytes written
+u64 flush_terminal_frame(TerminalScreen* screen)
+{
+    screen->pending = make_string(0, screen->output);
+    for (auto y = 0; y < TERMINAL_ROWS; y++)
+    {
+        for (auto x = 0; x < TERMINAL_COLUMNS; x++)
+        {
+            if (terminal_cells_equal(screen->cells[y][x], screen->shown[y][x])) { continue; }
+            if (can_rewrite_terminal_gap(screen, x, y))
+            {
+                while (screen->cursor_x < x) { write_terminal_cell(screen, screen->cursor_x, y); }
+            }
+            else if (screen->cursor_x != x || screen->cursor_y != y)
+            {
+                push("\x1b[", &screen->pending);
+                uint_to_string(y + 1, &screen->pending);
+                push(';', &screen->pending);
+                uint_to_string(x + 1, &screen->pending);
+                push('H', &screen->pending);
+                screen->cursor_y = y;
+            }
+            write_terminal_cell(screen, x, y);
+        }
+    }
+    assert(screen->pending.size <= TERMINAL_MAX_OUTPUT);
+    if (screen->pending.size != 0) { print(screen->pending); }
+
+    auto bytes = screen->pending.size;
+    if (screen->frames == 0) { screen->first_frame_bytes = bytes; }
+    screen->frames++;
+    screen->bytes += bytes;
+    screen->max_frame_bytes = MAX(screen->max_frame_bytes, bytes);
+    return bytes;
+}
+
+// clears the terminal and hides the cursor; the grid then starts out as what a cleared terminal shows
+void start_terminal_screen(TerminalScreen* screen)
+{
+    set_memory(0, sizeof(*screen), screen);
+    for (auto y = 0; y < TERMINAL_ROWS; y++)
+    {
+        for (auto x = 0; x < TERMINAL_COLUMNS; x++) { screen->shown[y][x].glyph = ' '; }
+    }
+    screen->cursor_x = -1;
+    screen->foreground = TERMINAL_DEFAULT_COLOR;
+    screen->background = TERMINAL_DEFAULT_COLOR;
+    print("\x1b[0m\x1b[2J\x1b[?25l");
+}
+
+// puts the colors and cursor back, below the screen
+void stop_terminal_screen()
+{
+    print("\x1b[0m\x1b[?25h\x1b[");
+    print((u64)TERMINAL_ROWS + 1);
+    print(";1H");
+}
+
+// the bot plays in real time, ticks_per_frame ticks per TERMINAL_TICK_MS frame, until it has placed max_shapes shapes
+int run_terminal_game(int max_shapes, s32 seed, int ticks_per_frame)
+{
+    initialize_shape_cell_maps();
+    auto escapes = platform_enable_terminal_escapes();
+    auto screen = (TerminalScreen*)SDL_malloc(sizeof(TerminalScreen));
+    auto bot = (Bot*)SDL_calloc(1, sizeof(Bot));
+    auto state = (GameState*)SDL_calloc(1, sizeof(GameState));
+    if (screen == NULL || bot == NULL || state == NULL) { panic("Out of memory for the terminal game"); }
+    initialize_game_state(seed, state);
+    bot->enabled = true;
+    bot->weights = DEFAULT_BOT_WEIGHTS;
+
+    start_terminal_screen(screen);
+    auto game_over_frames = 0;
+    auto games = 1;
+    auto next_frame = get_monotonic_nanoseconds();
+    while (bot->stats.shapes_placed < (u64)max_shapes)
+    {
+        // a lost game stays on screen for a moment before the bot restarts it
+        if (state->mode == GameModeLost)
+        {
+            if (++game_over_frames == TERMINAL_GAME_OVER_FRAMES)
+            {
+                process_input(TERMINAL_TICK_MS, get_bot_input(bot, state), state);
+                game_over_frames = 0;
+                games++;
+            }
+        }
+        else
+        {
+            for (auto i = 0; i < ticks_per_frame && state->mode != GameModeLost; i++)
+            { process_input(TERMINAL_TICK_MS, get_bot_input(bot, state), state); }
+        }
+        compose_terminal_frame(screen, state);
+        flush_terminal_frame(screen);
+
+        next_frame += TERMINAL_TICK_MS * 1000000ull;
+        auto now = get_monotonic_nanoseconds();
+        if (now < next_frame) { SDL_Delay((u32)((next_frame - now) / 1000000)); }
+    }
+    stop_terminal_screen();
+
+    if (!escapes) { print("stdout isn't a terminal that takes escape sequences, they were written as they are\n"); }
+    print("games ");
+    print((s64)games);
+    print(", shapes placed ");
+    print(bot->stats.shapes_placed);
+    print(", frames ");
+    print(screen->frames);
+    print(", bytes per frame ");
+    print((float)screen->bytes / MAX(screen->frames, 1ull));
+    print(" (first ");
+    print(screen->first_frame_bytes);
+    print(", most ");
+    print(screen->max_frame_bytes);
+    print(")\n");
+    SDL_free(state);
+    SDL_free(bot);
+    SDL_free(screen);
+    return 0;
+}
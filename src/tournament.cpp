@@ -0,0 +1,489 @@
+// Round-robin bot tournament. Every bot in the roster plays the same seeds, and a seed fixes the whole shape sequence,
+// so each pair of bots is compared game by game on identical shapes: the per-seed score differences give a paired z test,
+// which needs far fewer games than comparing two independent averages. Ratings are Bradley-Terry strengths fitted to the
+// per-seed wins, draws and losses of every pair, on the Elo scale and averaging 0.
+// Bots that place shapes greedily play their games as one parallel-for each; search bots play one game at a time, since
+// each search already spreads over the job system. Search bots go to a fixed depth with no time limit, so the results
+// don't depend on the machine. Everything scores placements with the network when TETRIS_NETWORK names one.
+//
+// Roster files are text, one bot per line:
+//   greedy                      the greedy bot with DEFAULT_BOT_WEIGHTS
+//   power-ups                   the greedy bot that also uses power ups, the estimator's rollout policy
+//   search <depth>              lookahead search to a fixed depth
+//   tuned <checkpoint file>     the greedy bot with the mean weights of a tuner checkpoint
+//
+// Results go to <prefix>.csv, one row per bot per seed, and <prefix>.json, the ratings and the pairwise comparisons.
+
+#define MAX_TOURNAMENT_BOTS 16
+#define MAX_TOURNAMENT_BOT_NAME 64
+#define MAX_ROSTER_FILE_SIZE 4096
+#define MAX_TOURNAMENT_PATH 512
+#define TOURNAMENT_RATING_ITERATIONS 1000
+#define TOURNAMENT_SEARCH_BUDGET_NANOSECONDS 1000000000000000ull // fixed depth is what stops the search
+#define DEFAULT_TOURNAMENT_GAMES 100
+#define DEFAULT_TOURNAMENT_MAX_SHAPES 500
+#define DEFAULT_TOURNAMENT_SEARCH_DEPTH 2
+
+enum TournamentBotKind
+{
+    TournamentBotGreedy,
+    TournamentBotPowerUps,
+    TournamentBotSearch,
+};
+
+struct TournamentBot
+{
+    char name[MAX_TOURNAMENT_BOT_NAME];
+    TournamentBotKind kind;
+    BotWeights weights;
+    int search_depth;
+};
+
+struct TournamentPair
+{
+    int first, second;
+    int wins, draws, losses; // of first against second
+    float mean_difference; // first's score minus second's, averaged over the seeds
+    float standard_error;
+    float z;
+    float p_value; // two sided
+};
+
+struct Tournament
+{
+    TournamentBot bots[MAX_TOURNAMENT_BOTS];
+    int bot_count;
+    int games;
+    int max_shapes;
+    s32 seed;
+    // bot by bot, game by game
+    s32* scores;
+    u32* shapes;
+    int playing; // the bot whose games are being played
+    float ratings[MAX_TOURNAMENT_BOTS];
+    TournamentPair pairs[MAX_TOURNAMENT_BOTS * (MAX_TOURNAMENT_BOTS - 1) / 2];
+    int pair_count;
+};
+
+void set_tournament_bot_name(TournamentBot* bot, String name)
+{
+    auto size = MIN(name.size, MAX_TOURNAMENT_BOT_NAME - 1);
+    copy_memory(size, name.data, bot->name);
+    bot->name[size] = '\0';
+}
+
+bool add_tournament_bot(Tournament* tournament, String line)
+{
+    if (tournament->bot_count == MAX_TOURNAMENT_BOTS) { return false; }
+    auto bot = &tournament->bots[tournament->bot_count];
+    set_memory(0, sizeof(*bot), bot);
+    set_tournament_bot_name(bot, line);
+    bot->weights = DEFAULT_BOT_WEIGHTS;
+
+    u64 space = 0;
+    while (space < line.size && line.data[space] != ' ') { space++; }
+    auto kind = make_string(space, line.data);
+    auto argument = make_string(space < line.size ? line.size - space - 1 : 0, line.data + space + 1);
+    char argument_data[MAX_TOURNAMENT_PATH];
+    if (argument.size >= sizeof(argument_data)) { return false; }
+    copy_memory(argument.size, argument.data, argument_data);
+    argument_data[argument.size] = '\0';
+    char kind_data[16];
+    if (kind.size >= sizeof(kind_data)) { return false; }
+    copy_memory(kind.size, kind.data, kind_data);
+    kind_data[kind.size] = '\0';
+
+    if (c_string_equals(kind_data, "greedy") && argument.size == 0) { bot->kind = TournamentBotGreedy; }
+    else if (c_string_equals(kind_data, "power-ups") && argument.size == 0) { bot->kind = TournamentBotPowerUps; }
+    else if (c_string_equals(kind_data, "search"))
+    {
+        auto depth = string_to_int(argument);
+        if (!depth.success || depth.value < 1 || depth.value > MAX_SEARCH_DEPTH) { return false; }
+        bot->kind = TournamentBotSearch;
+        bot->search_depth = depth.value;
+    }
+    else if (c_string_equals(kind_data, "tuned"))
+    {
+        TunerCheckpoint checkpoint;
+        auto size = platform_read_file(argument_data, &checkpoint, sizeof(checkpoint));
+        if (!is_tuner_checkpoint(&checkpoint, size)) { return false; }
+        bot->kind = TournamentBotGreedy;
+        bot->weights = get_tuner_mean(&checkpoint);
+    }
+    else { return false; }
+    tournament->bot_count++;
+    return true;
+}
+
+// without a roster file: the greedy bot, the power up bot and the depth 2 search
+bool load_tournament_roster(char* file_name, Tournament* tournament)
+{
+    tournament->bot_count = 0;
+    if (file_name == NULL)
+    {
+        char* lines[] = { "greedy", "power-ups", "search " DOUBLE_QUOTE(DEFAULT_TOURNAMENT_SEARCH_DEPTH) };
+        for (auto i = 0; i < countof(lines); i++) { add_tournament_bot(tournament, make_string(c_string_length(lines[i]), lines[i])); }
+        return true;
+    }
+
+    char data[MAX_ROSTER_FILE_SIZE];
+    auto size = platform_read_file(file_name, data, sizeof(data));
+    if (size < 0 || size == sizeof(data))
+    {
+        print("Can't read the roster file or it's too big\n");
+        return false;
+    }
+    auto text = make_string(size, data);
+    auto line_number = 0;
+    for (u64 position = 0; position < text.size;)
+    {
+        auto line = get_next_line(text, &position);
+        line_number++;
+        if (line.size == 0) { continue; }
+        if (!add_tournament_bot(tournament, line))
+        {
+            print("Roster line ");
+            print((s64)line_number);
+            print(" isn't a bot, or there are too many: ");
+            print(line);
+            print("\n");
+            return false;
+        }
+    }
+    if (tournament->bot_count < 2)
+    {
+        print("A tournament needs at least two bots\n");
+        return false;
+    }
+    return true;
+}
+
+void play_tournament_game(Tournament* tournament, Search* search, int bot_index, int game)
+{
+    auto bot = &tournament->bots[bot_index];
+    auto index = bot_index * tournament->games + game;
+    if (bot->kind == TournamentBotGreedy)
+    {
+        BotStats stats;
+        set_memory(0, sizeof(stats), &stats);
+        play_bot_game(tournament->seed + game, bot->weights, tournament->max_shapes, NULL, &stats);
+        tournament->scores[index] = (s32)stats.total_score;
+        tournament->shapes[index] = (u32)stats.shapes_placed;
+        return;
+    }
+
+    GameState state;
+    initialize_game_state(tournament->seed + game, &state);
+    Rollout rollout;
+    set_memory(0, sizeof(rollout), &rollout);
+    auto config = make_search_config(bot->weights, 0);
+    config.max_depth = bot->search_depth;
+    config.budget_nanoseconds = TOURNAMENT_SEARCH_BUDGET_NANOSECONDS;
+    u32 shapes = 0;
+    while (state.mode == GameModePlaying && shapes < tournament->max_shapes)
+    {
+        if (bot->kind == TournamentBotPowerUps)
+        {
+            if (!play_rollout_shape(&state, bot->weights, &rollout)) { break; }
+        }
+        else
+        {
+            SearchResult result;
+            if (!search_best_placement(search, &state, config, &result)) { break; }
+            apply_placement(result.placement, &state);
+        }
+        shapes++;
+    }
+    tournament->scores[index] = state.score;
+    tournament->shapes[index] = shapes;
+}
+
+void play_tournament_games(void* data, int begin, int end)
+{
+    auto tournament = (Tournament*)data;
+    for (auto game = begin; game < end; game++) { play_tournament_game(tournament, NULL, tournament->playing, game); }
+}
+
+// the normal distribution's two sided tail beyond z, with the Abramowitz and Stegun approximation of erfc
+float get_two_sided_p_value(float z)
+{
+    double x = (z < 0 ? -z : z) / 1.41421356;
+    auto t = 1 / (1 + 0.3275911 * x);
+    auto polynomial = t * (0.254829592 + t * (-0.284496736 + t * (1.421413741 + t * (-1.453152027 + t * 1.061405429))));
+    return (float)(polynomial * SDL_exp(-x * x));
+}
+
+void compare_tournament_pair(Tournament* tournament, TournamentPair* pair)
+{
+    auto first = tournament->scores + pair->first * tournament->games;
+    auto second = tournament->scores + pair->second * tournament->games;
+    s64 sum = 0;
+    s64 square_sum = 0;
+    for (auto game = 0; game < tournament->games; game++)
+    {
+        s64 difference = first[game] - second[game];
+        pair->wins += difference > 0;
+        pair->draws += difference == 0;
+        pair->losses += difference < 0;
+        sum += difference;
+        square_sum += difference * difference;
+    }
+    double n = tournament->games;
+    auto mean = sum / n;
+    auto variance = tournament->games > 1 ? MAX((square_sum - sum * mean) / (n - 1), 0.0) : 0.0;
+    pair->mean_difference = (float)mean;
+    pair->standard_error = (float)SDL_sqrt(variance / n);
+    pair->z = pair->standard_error > 0 ? pair->mean_difference / pair->standard_error : 0;
+    pair->p_value = pair->standard_error > 0 ? get_two_sided_p_value(pair->z) : (mean == 0 ? 1.0f : 0.0f);
+}
+
+// Bradley-Terry by minorization-maximization; every pair also gets one made up draw, so a bot that wins every game
+// still has a finite rating
+void rate_tournament_bots(Tournament* tournament)
+{
+    double wins[MAX_TOURNAMENT_BOTS] = {};
+    double games[MAX_TOURNAMENT_BOTS][MAX_TOURNAMENT_BOTS] = {};
+    for (auto i = 0; i < tournament->pair_count; i++)
+    {
+        auto pair = &tournament->pairs[i];
+        wins[pair->first] += pair->wins + 0.5 * pair->draws + 0.5;
+        wins[pair->second] += pair->losses + 0.5 * pair->draws + 0.5;
+        games[pair->first][pair->second] = games[pair->second][pair->first] = tournament->games + 1;
+    }
+    double strengths[MAX_TOURNAMENT_BOTS];
+    for (auto i = 0; i < tournament->bot_count; i++) { strengths[i] = 1; }
+    for (auto iteration = 0; iteration < TOURNAMENT_RATING_ITERATIONS; iteration++)
+    {
+        auto log_sum = 0.0;
+        for (auto i = 0; i < tournament->bot_count; i++)
+        {
+            auto denominator = 0.0;
+            for (auto j = 0; j < tournament->bot_count; j++)
+            {
+                if (j != i) { denominator += games[i][j] / (strengths[i] + strengths[j]); }
+            }
+            strengths[i] = wins[i] / denominator;
+            log_sum += SDL_log(strengths[i]);
+        }
+        // only the ratios matter, so the geometric mean stays 1
+        auto scale = SDL_exp(-log_sum / tournament->bot_count);
+        for (auto i = 0; i < tournament->bot_count; i++) { strengths[i] *= scale; }
+    }
+    for (auto i = 0; i < tournament->bot_count; i++) { tournament->ratings[i] = (float)(400 * SDL_log(strengths[i]) / SDL_log(10.0)); }
+}
+
+void push_json_string(char* value, String* result)
+{
+    push('"', result);
+    for (auto i = 0; value[i] != '\0'; i++)
+    {
+        if (value[i] == '"' || value[i] == '\\') { push('\\', result); }
+        push(value[i], result);
+    }
+    push('"', result);
+}
+
+// quoted when it has to be
+void push_csv_field(char* value, String* result)
+{
+    auto quoted = false;
+    for (auto i = 0; value[i] != '\0'; i++) { quoted |= value[i] == ',' || value[i] == '"'; }
+    if (quoted) { push('"', result); }
+    for (auto i = 0; value[i] != '\0'; i++)
+    {
+        if (value[i] == '"') { push('"', result); }
+        push(value[i], result);
+    }
+    if (quoted) { push('"', result); }
+}
+
+float get_tournament_average(Tournament* tournament, int bot_index, bool shapes)
+{
+    u64 total = 0;
+    for (auto game = 0; game < tournament->games; game++)
+    {
+        auto index = bot_index * tournament->games + game;
+        total += shapes ? tournament->shapes[index] : (u64)tournament->scores[index];
+    }
+    return (float)total / (float)tournament->games;
+}
+
+bool write_tournament_results(Tournament* tournament, char* prefix)
+{
+    char path_data[MAX_TOURNAMENT_PATH + 8];
+    if (c_string_length(prefix) > MAX_TOURNAMENT_PATH) { return false; }
+    // names can double in size when escaped
+    auto capacity = (u64)tournament->bot_count * tournament->games * (2 * MAX_TOURNAMENT_BOT_NAME + 48)
+        + (u64)tournament->pair_count * (4 * MAX_TOURNAMENT_BOT_NAME + 256) + 4096;
+    auto data = (char*)SDL_malloc(capacity);
+    if (data == NULL) { panic("Out of memory for tournament results"); }
+
+    auto text = make_string(0, data);
+    push("seed,bot,score,shapes\n", &text);
+    for (auto game = 0; game < tournament->games; game++)
+    {
+        for (auto bot = 0; bot < tournament->bot_count; bot++)
+        {
+            int_to_string(tournament->seed + game, &text);
+            push(',', &text);
+            push_csv_field(tournament->bots[bot].name, &text);
+            push(',', &text);
+            int_to_string(tournament->scores[bot * tournament->games + game], &text);
+            push(',', &text);
+            uint_to_string(tournament->shapes[bot * tournament->games + game], &text);
+            push('\n', &text);
+        }
+    }
+    auto path = make_string(0, path_data);
+    push(prefix, &path);
+    push(".csv", &path);
+    push('\0', &path);
+    auto result = platform_write_file(path.data, text.data, text.size);
+
+    text.size = 0;
+    push("{\n  \"games\": ", &text);
+    int_to_string(tournament->games, &text);
+    push(",\n  \"max_shapes\": ", &text);
+    int_to_string(tournament->max_shapes, &text);
+    push(",\n  \"seed\": ", &text);
+    int_to_string(tournament->seed, &text);
+    push(",\n  \"bots\": [", &text);
+    for (auto bot = 0; bot < tournament->bot_count; bot++)
+    {
+        if (bot != 0) { push(',', &text); }
+        push("\n    { \"name\": ", &text);
+        push_json_string(tournament->bots[bot].name, &text);
+        push(", \"rating\": ", &text);
+        float_to_string(tournament->ratings[bot], &text);
+        push(", \"average_score\": ", &text);
+        float_to_string(get_tournament_average(tournament, bot, false), &text);
+        push(", \"average_shapes\": ", &text);
+        float_to_string(get_tournament_average(tournament, bot, true), &text);
+        push(" }", &text);
+    }
+    push("\n  ],\n  \"pairs\": [", &text);
+    for (auto i = 0; i < tournament->pair_count; i++)
+    {
+        auto pair = &tournament->pairs[i];
+        if (i != 0) { push(',', &text); }
+        push("\n    { \"first\": ", &text);
+        push_json_string(tournament->bots[pair->first].name, &text);
+        push(", \"second\": ", &text);
+        push_json_string(tournament->bots[pair->second].name, &text);
+        push(", \"wins\": ", &text);
+        int_to_string(pair->wins, &text);
+        push(", \"draws\": ", &text);
+        int_to_string(pair->draws, &text);
+        push(", \"losses\": ", &text);
+        int_to_string(pair->losses, &text);
+        push(", \"mean_difference\": ", &text);
+        float_to_string(pair->mean_difference, &text);
+        push(", \"standard_error\": ", &text);
+        float_to_string(pair->standard_error, &text);
+        push(", \"z\": ", &text);
+        float_to_string(pair->z, &text);
+        push(", \"p_value\": ", &text);
+        float_to_string(pair->p_value, &text);
+        push(" }", &text);
+    }
+    push("\n  ]\n}\n", &text);
+    assert(text.size <= capacity);
+    path.size = 0;
+    push(prefix, &path);
+    push(".json", &path);
+    push('\0', &path);
+    result &= platform_write_file(path.data, text.data, text.size);
+    SDL_free(data);
+    return result;
+}
+
+int run_tournament(char* results_prefix, int games, int max_shapes, s32 seed, char* roster_file_name)
+{
+    initialize_shape_cell_maps();
+    auto tournament = (Tournament*)SDL_calloc(1, sizeof(Tournament));
+    if (tournament == NULL) { panic("Out of memory for the tournament"); }
+    auto result = 1;
+    if (load_tournament_roster(roster_file_name, tournament))
+    {
+        tournament->games = games;
+        tournament->max_shapes = max_shapes;
+        tournament->seed = seed;
+        tournament->scores = (s32*)SDL_malloc(tournament->bot_count * games * sizeof(s32));
+        tournament->shapes = (u32*)SDL_malloc(tournament->bot_count * games * sizeof(u32));
+        if (tournament->scores == NULL || tournament->shapes == NULL) { panic("Out of memory for tournament games"); }
+
+        reset_job_stats();
+        Search* search = NULL;
+        for (auto bot = 0; bot < tournament->bot_count; bot++)
+        {
+            auto start = get_monotonic_nanoseconds();
+            if (tournament->bots[bot].kind == TournamentBotSearch)
+            {
+                if (search == NULL) { search = allocate_search(); }
+                for (auto game = 0; game < games; game++) { play_tournament_game(tournament, search, bot, game); }
+            }
+            else
+            {
+                tournament->playing = bot;
+                parallel_for(play_tournament_games, tournament, games, 1);
+            }
+            auto nanoseconds = get_monotonic_nanoseconds() - start;
+            print(tournament->bots[bot].name);
+            print(": average score ");
+            print(get_tournament_average(tournament, bot, false));
+            print(", average shapes ");
+            print(get_tournament_average(tournament, bot, true));
+            print(", ");
+            print(get_nodes_per_second(games, nanoseconds));
+            print(" games/sec\n");
+        }
+        if (search != NULL) { free_search(search); }
+
+        for (auto first = 0; first < tournament->bot_count; first++)
+        {
+            for (auto second = first + 1; second < tournament->bot_count; second++)
+            {
+                auto pair = &tournament->pairs[tournament->pair_count++];
+                pair->first = first;
+                pair->second = second;
+                compare_tournament_pair(tournament, pair);
+                print(tournament->bots[first].name);
+                print(" vs ");
+                print(tournament->bots[second].name);
+                print(": ");
+                print((s64)pair->wins);
+                print("-");
+                print((s64)pair->draws);
+                print("-");
+                print((s64)pair->losses);
+                print(", score difference ");
+                print(pair->mean_difference);
+                print(" +- ");
+                print(pair->standard_error);
+                print(", p ");
+                print(pair->p_value);
+                print(pair->p_value < 0.05f ? (char*)", significant\n" : (char*)"\n");
+            }
+        }
+        rate_tournament_bots(tournament);
+        for (auto bot = 0; bot < tournament->bot_count; bot++)
+        {
+            print("rating ");
+            print(tournament->ratings[bot]);
+            print(": ");
+            print(tournament->bots[bot].name);
+            print("\n");
+        }
+        result = 0;
+        if (!write_tournament_results(tournament, results_prefix))
+        {
+            print("Failed to write the tournament results\n");
+            result = 1;
+        }
+        print_job_stats();
+        SDL_free(tournament->scores);
+        SDL_free(tournament->shapes);
+    }
+    SDL_free(tournament);
+    return result;
+}
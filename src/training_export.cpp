@@ -0,0 +1,286 @@
+// Training data export. Every placed shape becomes one fixed-size (state, action, reward, next state) record, appended
+// to shard files of at most shard_bytes each: a TrainingShardHeader followed by TrainingRecords, all single bytes so
+// there is no padding or byte order to worry about. Records go into the front of two buffers under a spin lock; a full
+// front buffer is handed to a background thread, which writes it while the other one fills. If the writer still has
+// the previous buffer when the next one fills up, records are dropped and counted, the same as the log does, so the
+// threads playing the games never wait on the disk.
+
+#define TRAINING_EXPORT_BUFFER_RECORDS 65536
+#define DEFAULT_TRAINING_SHARD_BYTES (64 * 1024 * 1024)
+#define TRAINING_SHARD_VERSION 1
+#define TRAINING_ORIENTATION_NONE 0xff
+#define MAX_TRAINING_SHARD_PATH 512 // of the directory; the shard name adds at most 22 bytes
+
+struct TrainingShardHeader
+{
+    char magic[4]; // "TTRN"
+    u8 version;
+    u8 record_size;
+    u8 board_width;
+    u8 board_height;
+    u8 shape_count; // shape indices go up to this, which stands for the fill cell power up's single cell
+    u8 reserved[7];
+};
+
+struct TrainingBoardState
+{
+    u8 rows[BOARD_HEIGHT]; // bit x of rows[y] is the cell at (x, y)
+    u8 shape; // get_shape_index of the falling shape
+    u8 power_ups[4]; // mirror, fill cell, invert board, bomb; capped at 255
+};
+
+struct TrainingRecord
+{
+    TrainingBoardState state;
+    // where the shape locked, its orientation numbered like the move generator's relative to the spawned shape;
+    // TRAINING_ORIENTATION_NONE when a power up swapped the shape out or blew it up before it locked
+    u8 orientation;
+    s8 x, y;
+    u8 reward; // rows cleared
+    u8 done; // the game was lost
+    TrainingBoardState next_state;
+    u8 reserved;
+};
+
+struct TrainingExportBuffer
+{
+    TrainingRecord* records;
+    int count;
+};
+
+struct TrainingExporter
+{
+    char* directory;
+    u64 shard_bytes;
+    SDL_SpinLock lock; // guards front and the front buffer
+    TrainingExportBuffer buffers[2];
+    int front;
+    SDL_atomic_t back_busy; // the back buffer is full and the writer owns it
+    SDL_atomic_t running;
+    SDL_atomic_t dropped_records;
+    SDL_sem* pending;
+    SDL_Thread* writer;
+    // owned by the writer
+    int shard_count;
+    u64 shard_size;
+    u64 written_records;
+    int failed_writes;
+};
+
+TrainingBoardState get_training_board_state(GameState* state)
+{
+    TrainingBoardState result;
+    for (auto y = 0; y < BOARD_HEIGHT; y++) { result.rows[y] = (u8)pack_cell_map_row(y, state->board); }
+    result.shape = (u8)get_shape_index(state->falling_shape.cell_map);
+    s32 counts[] = { state->power_ups.mirror, state->power_ups.fill_cell, state->power_ups.invert_board, state->power_ups.bomb };
+    for (auto i = 0; i < countof(counts); i++) { result.power_ups[i] = (u8)MIN(MAX(counts[i], 0), 255); }
+    return result;
+}
+
+u8 get_locked_orientation(CellMap spawned, CellMap locked)
+{
+    for (auto orientation = 0; orientation < 8; orientation++)
+    {
+        auto turned = spawned;
+        if (orientation >= 4) { mirror(&turned); }
+        for (auto i = 0; i < (orientation & 3); i++) { rotate(&turned); }
+        if (cell_maps_equal(turned, locked)) { return (u8)orientation; }
+    }
+    return TRAINING_ORIENTATION_NONE;
+}
+
+// before is the game as the shape spawned, after is the game once the next one has
+TrainingRecord make_training_record(GameState* before, GameState* after)
+{
+    TrainingRecord result;
+    set_memory(0, sizeof(result), &result);
+    result.state = get_training_board_state(before);
+    result.orientation = TRAINING_ORIENTATION_NONE;
+    result.x = -1;
+    result.y = -1;
+    if (after->shapes_locked != before->shapes_locked)
+    {
+        result.orientation = get_locked_orientation(before->falling_shape.cell_map, after->locked_shape.cell_map);
+        result.x = (s8)after->locked_shape.x;
+        result.y = (s8)after->locked_shape.y;
+    }
+    result.reward = (u8)MIN(MAX(after->score - before->score, 0), 255);
+    result.done = after->mode == GameModeLost;
+    result.next_state = get_training_board_state(after);
+    return result;
+}
+
+void write_training_shard_path(TrainingExporter* exporter, int shard, String* result)
+{
+    push(exporter->directory, result);
+    push("/shard_", result);
+    for (auto digit = 100000; digit > 1 && shard < digit; digit /= 10) { push('0', result); }
+    int_to_string(shard, result);
+    push(".bin", result);
+    push('\0', result);
+}
+
+// fills the current shard up to shard_bytes (with at least one record per shard) and starts new ones as needed
+void write_training_records(TrainingExporter* exporter, TrainingRecord* records, int count)
+{
+    char path_data[MAX_TRAINING_SHARD_PATH + 32];
+    while (count > 0)
+    {
+        auto path = make_string(0, path_data);
+        if (exporter->shard_size == 0 || exporter->shard_size + sizeof(TrainingRecord) > exporter->shard_bytes)
+        {
+            exporter->shard_count++;
+            write_training_shard_path(exporter, exporter->shard_count - 1, &path);
+            TrainingShardHeader header;
+            set_memory(0, sizeof(header), &header);
+            copy_memory(4, (void*)"TTRN", header.magic);
+            header.version = TRAINING_SHARD_VERSION;
+            header.record_size = sizeof(TrainingRecord);
+            header.board_width = BOARD_WIDTH;
+            header.board_height = BOARD_HEIGHT;
+            header.shape_count = countof(ALL_SHAPES);
+            if (!platform_write_file(path.data, &header, sizeof(header))) { exporter->failed_writes++; }
+            exporter->shard_size = sizeof(header);
+        }
+        else { write_training_shard_path(exporter, exporter->shard_count - 1, &path); }
+
+        auto room = (exporter->shard_bytes - MIN(exporter->shard_size, exporter->shard_bytes)) / sizeof(TrainingRecord);
+        auto written = (int)MIN((u64)count, MAX(room, (u64)1));
+        if (!platform_append_file(path.data, records, written * sizeof(TrainingRecord))) { exporter->failed_writes++; }
+        exporter->shard_size += written * sizeof(TrainingRecord);
+        exporter->written_records += written;
+        records += written;
+        count -= written;
+    }
+}
+
+int training_export_writer_thread(void* data)
+{
+    auto exporter = (TrainingExporter*)data;
+    while (true)
+    {
+        SDL_SemWait(exporter->pending);
+        if (SDL_AtomicGet(&exporter->back_busy))
+        {
+            // front can't change while the back buffer is busy
+            auto back = &exporter->buffers[exporter->front ^ 1];
+            write_training_records(exporter, back->records, back->count);
+            back->count = 0;
+            SDL_AtomicSet(&exporter->back_busy, 0);
+        }
+        if (!SDL_AtomicGet(&exporter->running)) { break; }
+    }
+    return 0;
+}
+
+// swaps buffers if the writer is free; the caller holds the lock
+bool hand_front_buffer_to_writer(TrainingExporter* exporter)
+{
+    if (SDL_AtomicGet(&exporter->back_busy)) { return false; }
+    exporter->front ^= 1;
+    SDL_AtomicSet(&exporter->back_busy, 1);
+    SDL_SemPost(exporter->pending);
+    return true;
+}
+
+// safe from any thread between start_training_export and stop_training_export
+void export_training_record(TrainingExporter* exporter, TrainingRecord record)
+{
+    SDL_AtomicLock(&exporter->lock);
+    auto front = &exporter->buffers[exporter->front];
+    if (front->count == TRAINING_EXPORT_BUFFER_RECORDS)
+    {
+        if (!hand_front_buffer_to_writer(exporter))
+        {
+            SDL_AtomicUnlock(&exporter->lock);
+            SDL_AtomicIncRef(&exporter->dropped_records);
+            return;
+        }
+        front = &exporter->buffers[exporter->front];
+    }
+    front->records[front->count++] = record;
+    SDL_AtomicUnlock(&exporter->lock);
+}
+
+void export_transition(TrainingExporter* exporter, GameState* before, GameState* after)
+{
+    export_training_record(exporter, make_training_record(before, after));
+}
+
+// directory has to exist and outlive the exporter; false if its path is too long
+bool start_training_export(TrainingExporter* exporter, char* directory, u64 shard_bytes)
+{
+    set_memory(0, sizeof(*exporter), exporter);
+    if (c_string_length(directory) > MAX_TRAINING_SHARD_PATH) { return false; }
+    exporter->directory = directory;
+    exporter->shard_bytes = MAX(shard_bytes, sizeof(TrainingShardHeader) + sizeof(TrainingRecord));
+    for (auto i = 0; i < countof(exporter->buffers); i++)
+    {
+        exporter->buffers[i].records = (TrainingRecord*)SDL_malloc(TRAINING_EXPORT_BUFFER_RECORDS * sizeof(TrainingRecord));
+        if (exporter->buffers[i].records == NULL) { panic("Out of memory for training export buffers"); }
+    }
+    exporter->pending = SDL_CreateSemaphore(0);
+    if (exporter->pending == NULL) { panic_sdl("SDL_CreateSemaphore"); }
+    SDL_AtomicSet(&exporter->running, 1);
+    exporter->writer = SDL_CreateThread(training_export_writer_thread, "training export", exporter);
+    if (exporter->writer == NULL) { panic_sdl("SDL_CreateThread"); }
+    return true;
+}
+
+// writes whatever is buffered; nothing may export records any more
+void stop_training_export(TrainingExporter* exporter)
+{
+    if (exporter->writer == NULL) { return; }
+    SDL_AtomicLock(&exporter->lock);
+    if (exporter->buffers[exporter->front].count != 0)
+    {
+        while (!hand_front_buffer_to_writer(exporter))
+        {
+            SDL_AtomicUnlock(&exporter->lock);
+            SDL_Delay(1);
+            SDL_AtomicLock(&exporter->lock);
+        }
+    }
+    SDL_AtomicUnlock(&exporter->lock);
+    SDL_AtomicSet(&exporter->running, 0);
+    SDL_SemPost(exporter->pending);
+    SDL_WaitThread(exporter->writer, NULL);
+    exporter->writer = NULL;
+    SDL_DestroySemaphore(exporter->pending);
+    for (auto i = 0; i < countof(exporter->buffers); i++) { SDL_free(exporter->buffers[i].records); }
+}
+
+void print_training_export_stats(TrainingExporter* exporter)
+{
+    print("records written: ");
+    print(exporter->written_records);
+    print(", dropped: ");
+    print((s64)SDL_AtomicGet(&exporter->dropped_records));
+    print(", shards: ");
+    print((s64)exporter->shard_count);
+    print(", failed writes: ");
+    print((s64)exporter->failed_writes);
+    print("\n");
+}
+
+// follows the windowed game from frame to frame, one record per shape
+struct TrainingRecorder
+{
+    bool has_spawn_state;
+    GameState spawn_state;
+};
+
+TrainingExporter g_training_exporter;
+TrainingRecorder g_training_recorder;
+
+void record_game_for_training(TrainingExporter* exporter, TrainingRecorder* recorder, GameState* state)
+{
+    if (recorder->has_spawn_state && recorder->spawn_state.shapes_spawned == state->shapes_spawned) { return; }
+    // shapes also spawn when a lost game restarts, which isn't a move
+    if (recorder->has_spawn_state && recorder->spawn_state.mode == GameModePlaying) { export_transition(exporter, &recorder->spawn_state, state); }
+    recorder->spawn_state = *state;
+    recorder->has_spawn_state = true;
+}
+
+// TETRIS_EXPORT_DIRECTORY turns on exporting the windowed game's shapes into that directory
+char* get_training_export_directory_from_environment() { return SDL_getenv("TETRIS_EXPORT_DIRECTORY"); }
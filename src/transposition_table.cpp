@@ -0,0 +1,82 @@
+// Fixed-size transposition table shared by all search threads, without locks. Each entry is two 64-bit words written
+// separately: the data and the key xor the data. A reader that sees words from two different writes gets a key that
+// doesn't match and treats it as a miss, so torn entries are never used. Newer entries always replace older ones.
+
+#define DEFAULT_TRANSPOSITION_TABLE_BITS 20
+
+struct TranspositionEntry
+{
+    volatile u64 check; // key ^ data
+    volatile u64 data; // value in the low 32 bits, depth above them
+};
+
+struct TranspositionTable
+{
+    u64 mask;
+    TranspositionEntry* entries;
+};
+
+// per thread, summed after the search so the counters don't bounce between cores
+struct TranspositionStats
+{
+    u64 probes;
+    u64 hits;
+    u64 stores;
+};
+
+TranspositionTable allocate_transposition_table(int bits)
+{
+    TranspositionTable result;
+    result.mask = ((u64)1 << bits) - 1;
+    result.entries = (TranspositionEntry*)SDL_calloc(result.mask + 1, sizeof(TranspositionEntry));
+    if (result.entries == NULL) { panic("Out of memory for transposition table"); }
+    return result;
+}
+
+void free_transposition_table(TranspositionTable* table)
+{
+    SDL_free(table->entries);
+    table->entries = NULL;
+}
+
+void clear_transposition_table(TranspositionTable* table)
+{
+    set_memory(0, (table->mask + 1) * sizeof(TranspositionEntry), table->entries);
+}
+
+u64 pack_transposition_data(int depth, float value)
+{
+    union { float f; u32 u; } bits;
+    bits.f = value;
+    return ((u64)depth << 32) | bits.u;
+}
+
+// only values searched to exactly the same depth are reused, so siblings are always compared at equal depth
+bool probe_transposition_table(TranspositionTable* table, u64 key, int depth, float* value, TranspositionStats* stats)
+{
+    stats->probes++;
+    auto entry = &table->entries[key & table->mask];
+    auto data = entry->data;
+    auto check = entry->check;
+    if ((check ^ data) != key || (int)(data >> 32) != depth) { return false; }
+    union { float f; u32 u; } bits;
+    bits.u = (u32)data;
+    *value = bits.f;
+    stats->hits++;
+    return true;
+}
+
+void store_transposition_table(TranspositionTable* table, u64 key, int depth, float value, TranspositionStats* stats)
+{
+    stats->stores++;
+    auto entry = &table->entries[key & table->mask];
+    auto data = pack_transposition_data(depth, value);
+    entry->data = data;
+    entry->check = key ^ data;
+}
+
+float get_hit_rate(TranspositionStats stats)
+{
+    if (stats.probes == 0) { return 0; }
+    return (float)stats.hits / (float)stats.probes;
+}
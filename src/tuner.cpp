@@ -0,0 +1,295 @@
+// BotWeights tuner. Each generation samples TUNER_POPULATION weight vectors from a normal distribution with a mean and
+// a standard deviation per weight, plays every one of them through the same seeded headless bot games and moves the
+// distribution toward the best TUNER_PARENTS, weighted by rank the way CMA-ES recombines (the cross-entropy method,
+// with a diagonal covariance). Only the direction of the weights matters to the bot, so candidates are scaled to unit
+// length. The games of a generation are one parallel-for on the job system, and the distribution is checkpointed after
+// every generation so a run can stop at any point and pick up where it left off.
+
+#define TUNER_POPULATION 16
+#define TUNER_PARENTS 8
+#define TUNER_START_DEVIATION 0.3f
+#define TUNER_MIN_DEVIATION 0.005f // keeps a weight from being frozen by a lucky generation
+#define TUNER_CHECKPOINT_VERSION 1
+#define DEFAULT_TUNER_GENERATIONS 30
+#define DEFAULT_TUNER_GAMES 100
+#define DEFAULT_TUNER_MAX_SHAPES 500
+#define TUNED_WEIGHTS (sizeof(BotWeights) / sizeof(float))
+#define MAX_TUNER_PATH 512
+
+char* BOT_WEIGHT_NAMES[] = { "aggregate_height", "holes", "bumpiness", "cleared_rows", "row_transitions" };
+
+static_assert(countof(BOT_WEIGHT_NAMES) == TUNED_WEIGHTS, "BOT_WEIGHT_NAMES is out of date");
+
+// in this machine's byte order; it's only for resuming a run
+struct TunerCheckpoint
+{
+    char magic[4]; // "TTUN"
+    u32 version;
+    s32 seed;
+    s32 generations; // finished so far
+    RandomNumberGenerator random;
+    float mean[TUNED_WEIGHTS];
+    float deviation[TUNED_WEIGHTS];
+    BotWeights best_weights; // the best single candidate so far, on its own generation's games
+    float best_fitness;
+    u64 games_played;
+};
+
+struct TunerGames
+{
+    BotWeights candidates[TUNER_POPULATION];
+    int games; // per candidate
+    int max_shapes;
+    s32 seed; // of the first game; every candidate plays the same games
+    BotStats* stats; // one per game, candidate by candidate
+};
+
+float* get_weight(BotWeights* weights, int index) { return (float*)weights + index; }
+
+float get_random_unit_float(RandomNumberGenerator* random) { return (float)((u32)get_random_number(random) >> 8) / 16777216.0f; }
+
+// Box-Muller
+float get_random_gaussian(RandomNumberGenerator* random)
+{
+    auto u = 1.0f - get_random_unit_float(random);
+    auto v = get_random_unit_float(random);
+    return SDL_sqrtf(-2.0f * SDL_logf(u)) * SDL_cosf(2.0f * 3.14159265f * v);
+}
+
+void normalize_weights(BotWeights* weights)
+{
+    auto length = 0.0f;
+    for (auto i = 0; i < TUNED_WEIGHTS; i++) { length += *get_weight(weights, i) * *get_weight(weights, i); }
+    length = SDL_sqrtf(length);
+    if (length == 0) { return; }
+    for (auto i = 0; i < TUNED_WEIGHTS; i++) { *get_weight(weights, i) /= length; }
+}
+
+void print_weights(BotWeights weights)
+{
+    print("{ ");
+    for (auto i = 0; i < TUNED_WEIGHTS; i++)
+    {
+        if (i != 0) { print(", "); }
+        print(*get_weight(&weights, i));
+        print("f");
+    }
+    print(" }");
+}
+
+void start_tuner_checkpoint(s32 seed, TunerCheckpoint* checkpoint)
+{
+    set_memory(0, sizeof(*checkpoint), checkpoint);
+    copy_memory(4, (void*)"TTUN", checkpoint->magic);
+    checkpoint->version = TUNER_CHECKPOINT_VERSION;
+    checkpoint->seed = seed;
+    seed_random_number_generator(seed, &checkpoint->random);
+    auto start = DEFAULT_BOT_WEIGHTS;
+    normalize_weights(&start);
+    for (auto i = 0; i < TUNED_WEIGHTS; i++)
+    {
+        checkpoint->mean[i] = *get_weight(&start, i);
+        checkpoint->deviation[i] = TUNER_START_DEVIATION;
+    }
+    checkpoint->best_weights = start;
+    checkpoint->best_fitness = -1;
+}
+
+bool is_tuner_checkpoint(TunerCheckpoint* checkpoint, s64 size)
+{
+    return size == sizeof(*checkpoint)
+        && memory_equals(4, checkpoint->magic, (void*)"TTUN")
+        && checkpoint->version == TUNER_CHECKPOINT_VERSION;
+}
+
+// false if file_name holds something other than a checkpoint; a missing file starts a new run
+bool load_tuner_checkpoint(char* file_name, s32 seed, TunerCheckpoint* checkpoint)
+{
+    auto size = platform_read_file(file_name, checkpoint, sizeof(*checkpoint));
+    if (size == -1)
+    {
+        start_tuner_checkpoint(seed, checkpoint);
+        return true;
+    }
+    return is_tuner_checkpoint(checkpoint, size);
+}
+
+BotWeights get_tuner_mean(TunerCheckpoint* checkpoint)
+{
+    BotWeights result;
+    for (auto i = 0; i < TUNED_WEIGHTS; i++) { *get_weight(&result, i) = checkpoint->mean[i]; }
+    return result;
+}
+
+void play_tuner_games(void* data, int begin, int end)
+{
+    auto games = (TunerGames*)data;
+    for (auto i = begin; i < end; i++)
+    {
+        auto candidate = i / games->games;
+        auto game = i % games->games;
+        play_bot_game(games->seed + game, games->candidates[candidate], games->max_shapes, NULL, &games->stats[i]);
+    }
+}
+
+// fitness is the average score over the candidate's games
+void run_tuner_generation(TunerCheckpoint* checkpoint, TunerGames* games, float* fitness)
+{
+    for (auto candidate = 0; candidate < TUNER_POPULATION; candidate++)
+    {
+        auto weights = &games->candidates[candidate];
+        for (auto i = 0; i < TUNED_WEIGHTS; i++)
+        { *get_weight(weights, i) = checkpoint->mean[i] + checkpoint->deviation[i] * get_random_gaussian(&checkpoint->random); }
+        normalize_weights(weights);
+    }
+    // new games every generation, so the weights don't fit one set of seeds
+    games->seed = checkpoint->seed + checkpoint->generations * games->games;
+    auto game_count = TUNER_POPULATION * games->games;
+    set_memory(0, game_count * sizeof(BotStats), games->stats);
+    parallel_for(play_tuner_games, games, game_count, 1);
+
+    for (auto candidate = 0; candidate < TUNER_POPULATION; candidate++)
+    {
+        u64 total_score = 0;
+        for (auto game = 0; game < games->games; game++) { total_score += games->stats[candidate * games->games + game].total_score; }
+        fitness[candidate] = (float)total_score / (float)games->games;
+    }
+}
+
+// moves the mean and deviation toward the best candidates; order has the candidates best first
+void update_tuner_distribution(TunerCheckpoint* checkpoint, TunerGames* games, int* order)
+{
+    float rank_weights[TUNER_PARENTS];
+    auto total = 0.0f;
+    for (auto rank = 0; rank < TUNER_PARENTS; rank++)
+    {
+        rank_weights[rank] = SDL_logf(TUNER_PARENTS + 0.5f) - SDL_logf(rank + 1.0f);
+        total += rank_weights[rank];
+    }
+    for (auto i = 0; i < TUNED_WEIGHTS; i++)
+    {
+        auto mean = 0.0f;
+        for (auto rank = 0; rank < TUNER_PARENTS; rank++) { mean += rank_weights[rank] / total * *get_weight(&games->candidates[order[rank]], i); }
+        auto variance = 0.0f;
+        for (auto rank = 0; rank < TUNER_PARENTS; rank++)
+        {
+            auto difference = *get_weight(&games->candidates[order[rank]], i) - mean;
+            variance += rank_weights[rank] / total * difference * difference;
+        }
+        checkpoint->mean[i] = mean;
+        checkpoint->deviation[i] = MAX(SDL_sqrtf(variance), TUNER_MIN_DEVIATION);
+    }
+}
+
+// runs until generations have finished in total, checkpointing to checkpoint_file_name after each one; seed only matters
+// for a new run
+int run_tuner(char* checkpoint_file_name, int generations, int games_per_candidate, int max_shapes, s32 seed)
+{
+    if (c_string_length(checkpoint_file_name) > MAX_TUNER_PATH)
+    {
+        print("The checkpoint file's path is too long\n");
+        return 1;
+    }
+    // the checkpoint is written next to the old one and renamed over it, so stopping mid-write can't tear it
+    char temporary_data[MAX_TUNER_PATH + 8];
+    auto temporary_file_name = make_string(0, temporary_data);
+    push(checkpoint_file_name, &temporary_file_name);
+    push(".tmp", &temporary_file_name);
+    push('\0', &temporary_file_name);
+
+    initialize_shape_cell_maps();
+    TunerCheckpoint checkpoint;
+    if (!load_tuner_checkpoint(checkpoint_file_name, seed, &checkpoint))
+    {
+        print("Not a tuner checkpoint: ");
+        print(checkpoint_file_name);
+        print("\n");
+        return 1;
+    }
+    if (checkpoint.generations != 0)
+    {
+        print("resuming after generation ");
+        print((s64)checkpoint.generations);
+        print("\n");
+    }
+
+    auto games = (TunerGames*)SDL_malloc(sizeof(TunerGames));
+    if (games == NULL) { panic("Out of memory for tuner games"); }
+    games->games = games_per_candidate;
+    games->max_shapes = max_shapes;
+    games->stats = (BotStats*)SDL_malloc(TUNER_POPULATION * games_per_candidate * sizeof(BotStats));
+    if (games->stats == NULL) { panic("Out of memory for tuner games"); }
+    reset_job_stats();
+    auto failures = 0;
+    u64 total_games = 0;
+    u64 total_nanoseconds = 0;
+    while (checkpoint.generations < generations)
+    {
+        auto start = get_monotonic_nanoseconds();
+        float fitness[TUNER_POPULATION];
+        run_tuner_generation(&checkpoint, games, fitness);
+        auto nanoseconds = get_monotonic_nanoseconds() - start;
+
+        int order[TUNER_POPULATION];
+        auto average = 0.0f;
+        for (auto candidate = 0; candidate < TUNER_POPULATION; candidate++)
+        {
+            auto rank = candidate;
+            for (; rank > 0 && fitness[order[rank - 1]] < fitness[candidate]; rank--) { order[rank] = order[rank - 1]; }
+            order[rank] = candidate;
+            average += fitness[candidate] / TUNER_POPULATION;
+        }
+        update_tuner_distribution(&checkpoint, games, order);
+        if (fitness[order[0]] > checkpoint.best_fitness)
+        {
+            checkpoint.best_fitness = fitness[order[0]];
+            checkpoint.best_weights = games->candidates[order[0]];
+        }
+        auto game_count = (u64)TUNER_POPULATION * games_per_candidate;
+        checkpoint.games_played += game_count;
+        checkpoint.generations++;
+        total_games += game_count;
+        total_nanoseconds += nanoseconds;
+        if (!platform_write_file(temporary_file_name.data, &checkpoint, sizeof(checkpoint))
+            || !platform_replace_file(temporary_file_name.data, checkpoint_file_name))
+        { failures++; }
+
+        // the spread of the distribution shrinks as the run converges
+        auto spread = 0.0f;
+        for (auto i = 0; i < TUNED_WEIGHTS; i++) { spread += checkpoint.deviation[i] * checkpoint.deviation[i]; }
+        print("generation ");
+        print((s64)checkpoint.generations);
+        print(": best ");
+        print(fitness[order[0]]);
+        print(", average ");
+        print(average);
+        print(", spread ");
+        print(SDL_sqrtf(spread));
+        print(", ");
+        print(get_nodes_per_second(game_count, nanoseconds));
+        print(" games/sec\n");
+    }
+
+    print("weights: ");
+    for (auto i = 0; i < TUNED_WEIGHTS; i++)
+    {
+        if (i != 0) { print(", "); }
+        print(BOT_WEIGHT_NAMES[i]);
+    }
+    print("\nmean: ");
+    print_weights(get_tuner_mean(&checkpoint));
+    print("\nbest candidate (average score ");
+    print(checkpoint.best_fitness);
+    print("): ");
+    print_weights(checkpoint.best_weights);
+    print("\ngames: ");
+    print(checkpoint.games_played);
+    print(" in total, ");
+    print(get_nodes_per_second(total_games, total_nanoseconds));
+    print(" games/sec in this run\n");
+    if (failures != 0) { print("Failed to write the checkpoint\n"); }
+    print_job_stats();
+    SDL_free(games->stats);
+    SDL_free(games);
+    return failures == 0 ? 0 : 1;
+}
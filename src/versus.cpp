@@ -0,0 +1,1077 @@
+// Two player versus over UDP, in lockstep. Both instances simulate both games from the same seeds, one fixed
+// VERSUS_TICK_MS tick at a time, and a tick only runs once both players' inputs for it are known, so the games can't drift
+// apart and nothing but inputs crosses the network. A local input is scheduled input_delay ticks ahead, which hides the
+// latency as long as the delay covers it; otherwise the game stalls until the other side's input arrives, and the stall
+// lines the two clocks back up. Every packet repeats all the inputs the other side hasn't acknowledged (up to
+// VERSUS_INPUT_HISTORY), so a lost packet is covered by any later one without retransmission. Packets also echo the
+// other side's send time, which gives the round trip and its jitter, and the automatic input delay follows both.
+// Rows a player clears become garbage rows for the opponent, pushed under their board when their next shape locks.
+// A match ends when a board tops out and the next one starts VERSUS_RESTART_TICKS ticks later.
+//
+// With rollback on, a side doesn't wait for late inputs: it predicts the other player pressed nothing (every input is a
+// one tick press, so repeating the last one would repeat a move) and runs up to max_rollback ticks ahead of what it
+// knows. Everything a tick changes lives in VersusSimulation, a flat struct copied into a ring of snapshots before each
+// tick, so when a real input turns out to differ from the prediction the side restores the snapshot from before that
+// tick and simulates forward again with the real inputs.
+//
+// Every tick that ran with both players' real inputs gets a checksum (hash_game_state of both games plus the match
+// state), and each packet carries the sender's latest one. When a side finds the checksums of a tick differ, the games
+// have gone out of step for good: it stops, sends its state and inputs for the tick to the other side, and writes both
+// to versus_desync_<local port>.txt.
+//
+// The instances agree on who is player 0 and on the seeds through random nonces in their first packets. Packets are
+// raw structs, so both ends need the same byte order.
+
+#define VERSUS_TICK_MS 16
+#define VERSUS_INPUT_HISTORY 32
+#define VERSUS_INPUT_BUFFER 256 // ticks of inputs kept per player, a power of two
+#define VERSUS_MAX_INPUT_DELAY 15
+#define VERSUS_MAX_ROLLBACK_TICKS 16
+#define VERSUS_MAX_CATCH_UP_TICKS 4 // per frame, when the window fell behind
+#define VERSUS_RESTART_TICKS 120
+#define VERSUS_DELAY_UPDATE_NANOSECONDS 1000000000ull // the automatic delay changes at most this often
+#define VERSUS_MAGIC 0x53525654 // "TVRS"
+#define VERSUS_NO_ECHO 0xffffffff
+#define VERSUS_DESYNC_MAGIC 0x59534454 // "TDSY"
+#define VERSUS_NO_CHECKSUM 0xffffffff
+#define VERSUS_CHECKSUM_HISTORY 64 // confirmed ticks kept, state and all, to compare with the other side's checksums
+#define VERSUS_DESYNC_REPORT_NANOSECONDS 2000000000ull // then the dump goes without the other side's state
+#define MAX_VERSUS_DUMP_BYTES 16384
+#define VERSUS_MAX_ROUND_TRIP_US 10000000 // longer samples are clock trouble, not latency
+#define VERSUS_LOOPBACK_ADDRESS 0x7f000001
+#define VERSUS_BENCH_TIMEOUT_NANOSECONDS 10000000000ull // with no tick in either game
+#define DEFAULT_VERSUS_PORT 27015
+#define DEFAULT_VERSUS_BENCH_TICKS 20000
+#define DEFAULT_ROLLBACK_BENCH_TICKS 20000
+
+static_assert((VERSUS_INPUT_BUFFER & (VERSUS_INPUT_BUFFER - 1)) == 0, "VERSUS_INPUT_BUFFER isn't a power of two");
+static_assert(VERSUS_INPUT_BUFFER > 2 * (VERSUS_MAX_INPUT_DELAY + VERSUS_INPUT_HISTORY + VERSUS_MAX_ROLLBACK_TICKS), "VERSUS_INPUT_BUFFER is too small");
+
+struct VersusPacket
+{
+    u32 magic;
+    u32 nonce;
+    u32 sequence;
+    u32 acknowledged_tick; // the receiver's inputs are known below this tick
+    u32 first_tick; // of inputs[0]
+    u32 input_count;
+    u32 send_time; // microseconds on the sender's clock
+    u32 echo_time; // the latest send_time the sender got
+    u32 echo_hold; // microseconds between getting echo_time and sending this, VERSUS_NO_ECHO before the first packet
+    u32 checksum_tick; // the sender's latest confirmed tick, VERSUS_NO_CHECKSUM before the first
+    u64 checksum;
+    u16 inputs[VERSUS_INPUT_HISTORY];
+};
+
+struct VersusStats
+{
+    float round_trip_ms; // smoothed
+    float jitter_ms; // smoothed difference between consecutive round trips
+    float min_round_trip_ms, max_round_trip_ms;
+    u64 round_trip_samples;
+    u64 packets_sent;
+    u64 packets_dropped; // by drop_percent
+    u64 packets_received;
+    u32 first_sequence, last_sequence;
+    u64 stalled_ticks; // ticks that were due but waited for the other side's input
+    u64 rollbacks;
+    u64 rolled_back_ticks; // simulated again after a misprediction
+    u32 max_rollback_depth;
+    u64 checksums_compared;
+};
+
+struct VersusPlayer
+{
+    GameState state;
+    int scored; // the part of the score already sent as garbage
+    int incoming_garbage; // rows waiting for the next lock
+    u32 wins;
+};
+
+// everything a tick changes, so a snapshot is one copy
+struct VersusSimulation
+{
+    s32 seed; // of match 0
+    u32 match;
+    int restart_countdown; // ticks; the last match is over while it isn't 0
+    int last_winner; // -1 for a draw
+    RandomNumberGenerator garbage_random;
+    u64 garbage_rows;
+    VersusPlayer players[2];
+};
+
+// a tick that ran with both players' real inputs
+struct VersusConfirmedTick
+{
+    u32 tick;
+    u16 inputs[2];
+    u64 checksum;
+    VersusSimulation simulation; // after the tick
+};
+
+// sent every frame once a side has found a desync
+struct VersusDesyncPacket
+{
+    u32 magic;
+    u32 nonce;
+    VersusConfirmedTick confirmed;
+};
+
+struct VersusChecksum
+{
+    u32 tick;
+    u64 value;
+};
+
+struct Versus
+{
+    s64 socket;
+    u16 local_port;
+    u32 peer_address;
+    u16 peer_port;
+    u32 nonce, peer_nonce;
+    bool started; // both nonces are known
+    int local; // the player this instance's inputs drive
+
+    u32 tick; // the next one to simulate
+    u32 scheduled; // local inputs are known below this tick
+    u32 known; // the other player's inputs are known below this tick
+    u32 acknowledged; // the other side knows the local inputs below this tick
+    u16 inputs[2][VERSUS_INPUT_BUFFER];
+    u16 pending_input; // local presses that haven't got a tick yet
+    int input_delay;
+    bool automatic_delay;
+    int max_rollback; // ticks the simulation may run ahead of the other side's inputs, 0 for plain lockstep
+    bool mispredicted;
+    u32 rollback_tick; // the first tick simulated with a wrong prediction while mispredicted
+    u64 delay_updated;
+    u64 next_tick_nanoseconds;
+
+    u32 sequence;
+    bool has_echo;
+    u32 echo_time;
+    u32 echo_received;
+    int drop_percent; // of outgoing packets, to try packet loss on loopback
+    RandomNumberGenerator drop_random;
+
+    u32 confirmed; // ticks below this ran with both players' real inputs
+    VersusConfirmedTick confirmed_ticks[VERSUS_CHECKSUM_HISTORY]; // by tick
+    VersusChecksum peer_checksums[VERSUS_CHECKSUM_HISTORY]; // by tick, the ones that came before the local tick was confirmed
+    bool desynced; // the games differ after desync_tick; nothing runs anymore
+    u32 desync_tick;
+    u64 desync_nanoseconds;
+    bool has_peer_report;
+    VersusConfirmedTick peer_report;
+    bool dumped;
+
+    VersusStats stats;
+    VersusSimulation simulation;
+    VersusSimulation snapshots[VERSUS_MAX_ROLLBACK_TICKS + 1]; // from before each tick, by tick
+};
+
+u32 get_versus_microseconds() { return (u32)(get_monotonic_nanoseconds() / 1000); }
+
+// escape and enter are left out: pausing and restarting are up to the match, not one player
+u16 pack_versus_input(GameInput input)
+{
+    return input.left | input.right << 1 | input.down << 2 | input.up << 3 | input.r << 4
+        | input.one << 5 | input.two << 6 | input.three << 7 | input.four << 8;
+}
+
+GameInput unpack_versus_input(u16 bits)
+{
+    GameInput result;
+    set_memory(0, sizeof(result), &result);
+    result.left = bits & 1;
+    result.right = (bits >> 1) & 1;
+    result.down = (bits >> 2) & 1;
+    result.up = (bits >> 3) & 1;
+    result.r = (bits >> 4) & 1;
+    result.one = (bits >> 5) & 1;
+    result.two = (bits >> 6) & 1;
+    result.three = (bits >> 7) & 1;
+    result.four = (bits >> 8) & 1;
+    return result;
+}
+
+// dotted quad or localhost
+bool parse_ipv4_address(char* text, u32* address)
+{
+    if (c_string_equals(text, "localhost"))
+    {
+        *address = VERSUS_LOOPBACK_ADDRESS;
+        return true;
+    }
+    *address = 0;
+    auto start = 0;
+    for (auto part = 0; part < 4; part++)
+    {
+        auto end = start;
+        while (text[end] != '\0' && text[end] != '.') { end++; }
+        auto value = string_to_int(make_string(end - start, text + start));
+        if (!value.success || value.value < 0 || value.value > 255) { return false; }
+        if ((part < 3 && text[end] != '.') || (part == 3 && text[end] != '\0')) { return false; }
+        *address = *address << 8 | value.value;
+        start = end + 1;
+    }
+    return true;
+}
+
+void start_versus_match(VersusSimulation* simulation)
+{
+    auto seed = simulation->seed + (s32)simulation->match * 2;
+    for (auto player = 0; player < 2; player++)
+    {
+        auto wins = simulation->players[player].wins;
+        set_memory(0, sizeof(simulation->players[player]), &simulation->players[player]);
+        initialize_game_state(seed + player, &simulation->players[player].state);
+        simulation->players[player].wins = wins;
+    }
+    seed_random_number_generator(seed, &simulation->garbage_random);
+    simulation->restart_countdown = 0;
+}
+
+Versus* start_versus(u16 local_port, u32 peer_address, u16 peer_port, int input_delay, int max_rollback)
+{
+    auto versus = (Versus*)SDL_calloc(1, sizeof(Versus));
+    if (versus == NULL) { panic("Out of memory for versus"); }
+    versus->socket = platform_open_udp_socket(local_port);
+    if (versus->socket == -1)
+    {
+        print("Can't open UDP port ");
+        print((u64)local_port);
+        print("\n");
+        SDL_free(versus);
+        return NULL;
+    }
+    versus->local_port = local_port;
+    versus->peer_address = peer_address;
+    versus->peer_port = peer_port;
+    versus->nonce = (u32)(get_monotonic_nanoseconds() * 2654435761u) ^ local_port;
+    versus->automatic_delay = input_delay == 0;
+    versus->input_delay = versus->automatic_delay ? 1 : MIN(input_delay, VERSUS_MAX_INPUT_DELAY);
+    versus->max_rollback = MIN(max_rollback, VERSUS_MAX_ROLLBACK_TICKS);
+    versus->simulation.last_winner = -1;
+    seed_random_number_generator(local_port, &versus->drop_random);
+    for (auto i = 0; i < VERSUS_CHECKSUM_HISTORY; i++)
+    {
+        versus->confirmed_ticks[i].tick = VERSUS_NO_CHECKSUM;
+        versus->peer_checksums[i].tick = VERSUS_NO_CHECKSUM;
+    }
+    // something to draw while waiting for the other side
+    start_versus_match(&versus->simulation);
+    return versus;
+}
+
+void free_versus(Versus* versus)
+{
+    platform_close_udp_socket(versus->socket);
+    SDL_free(versus);
+}
+
+void add_round_trip_sample(VersusStats* stats, u32 microseconds)
+{
+    auto milliseconds = microseconds / 1000.0f;
+    if (stats->round_trip_samples == 0)
+    {
+        stats->round_trip_ms = milliseconds;
+        stats->min_round_trip_ms = milliseconds;
+        stats->max_round_trip_ms = milliseconds;
+    }
+    else
+    {
+        auto change = milliseconds - stats->round_trip_ms;
+        stats->jitter_ms += ((change < 0 ? -change : change) - stats->jitter_ms) / 16;
+        stats->round_trip_ms += change / 8;
+        stats->min_round_trip_ms = MIN(stats->min_round_trip_ms, milliseconds);
+        stats->max_round_trip_ms = MAX(stats->max_round_trip_ms, milliseconds);
+    }
+    stats->round_trip_samples++;
+}
+
+// percent of the other side's packets that didn't arrive, dropped by the network or by its drop_percent
+float get_versus_packet_loss(VersusStats* stats)
+{
+    if (stats->packets_received == 0) { return 0; }
+    auto expected = (u64)(stats->last_sequence - stats->first_sequence) + 1;
+    return 100.0f * (float)(expected - MIN(expected, stats->packets_received)) / (float)expected;
+}
+
+u64 hash_versus_simulation(VersusSimulation* simulation)
+{
+    u64 words[] =
+    {
+        (u64)(u32)simulation->seed | (u64)simulation->match << 32,
+        (u64)(u32)simulation->restart_countdown | (u64)(u32)simulation->last_winner << 32,
+        (u64)simulation->garbage_random.previous,
+        simulation->garbage_rows,
+    };
+    u64 result = 0;
+    for (auto i = 0; i < countof(words); i++) { result = mix_hash(result, words[i]); }
+    for (auto i = 0; i < 2; i++)
+    {
+        auto player = &simulation->players[i];
+        result = mix_hash(result, hash_game_state(&player->state));
+        result = mix_hash(result, (u64)(u32)player->scored | (u64)(u32)player->incoming_garbage << 32);
+        result = mix_hash(result, player->wins);
+    }
+    return result;
+}
+
+void compare_versus_checksum(Versus* versus, u32 tick, u64 peer_checksum)
+{
+    auto local = &versus->confirmed_ticks[tick % VERSUS_CHECKSUM_HISTORY];
+    if (local->tick != tick) { return; } // too old to check
+    versus->stats.checksums_compared++;
+    if (local->checksum == peer_checksum || (versus->desynced && (s32)(versus->desync_tick - tick) <= 0)) { return; }
+    // both sides settle on the earliest tick either of them found
+    if (!versus->desynced) { log_error("Versus games went out of step at tick ", (u64)tick); }
+    versus->desynced = true;
+    versus->desync_tick = tick;
+    versus->desync_nanoseconds = get_monotonic_nanoseconds();
+    versus->has_peer_report = versus->has_peer_report && versus->peer_report.tick == tick;
+}
+
+void receive_versus_checksum(Versus* versus, u32 tick, u64 checksum)
+{
+    if (tick == VERSUS_NO_CHECKSUM) { return; }
+    if ((s32)(tick - versus->confirmed) < 0)
+    {
+        compare_versus_checksum(versus, tick, checksum);
+        return;
+    }
+    auto slot = &versus->peer_checksums[tick % VERSUS_CHECKSUM_HISTORY];
+    slot->tick = tick;
+    slot->value = checksum;
+}
+
+// checksums the ticks that have run with both players' real inputs since the last call; the state after tick t is the
+// snapshot from before t + 1
+void confirm_versus_ticks(Versus* versus)
+{
+    while (!versus->desynced && (s32)(versus->confirmed - versus->tick) < 0 && (s32)(versus->confirmed - versus->known) < 0)
+    {
+        auto tick = versus->confirmed;
+        auto confirmed = &versus->confirmed_ticks[tick % VERSUS_CHECKSUM_HISTORY];
+        confirmed->tick = tick;
+        confirmed->simulation = tick + 1 == versus->tick ? versus->simulation : versus->snapshots[(tick + 1) % countof(versus->snapshots)];
+        for (auto i = 0; i < 2; i++) { confirmed->inputs[i] = versus->inputs[i][tick % VERSUS_INPUT_BUFFER]; }
+        confirmed->checksum = hash_versus_simulation(&confirmed->simulation);
+        versus->confirmed++;
+        auto peer = &versus->peer_checksums[tick % VERSUS_CHECKSUM_HISTORY];
+        if (peer->tick == tick) { compare_versus_checksum(versus, tick, peer->value); }
+    }
+}
+
+void receive_versus_desync_report(Versus* versus, VersusConfirmedTick* report)
+{
+    receive_versus_checksum(versus, report->tick, report->checksum);
+    if (versus->desynced && report->tick == versus->desync_tick && !versus->has_peer_report)
+    {
+        versus->peer_report = *report;
+        versus->has_peer_report = true;
+    }
+}
+
+void receive_versus_packets(Versus* versus)
+{
+    union
+    {
+        VersusPacket packet;
+        VersusDesyncPacket desync;
+    } received;
+    auto& packet = received.packet;
+    u32 address;
+    u16 port;
+    s64 size;
+    while ((size = platform_receive_udp(versus->socket, &received, sizeof(received), &address, &port)) >= 0)
+    {
+        if (address != versus->peer_address || port != versus->peer_port) { continue; }
+        if (size == sizeof(received.desync) && received.desync.magic == VERSUS_DESYNC_MAGIC)
+        {
+            if (versus->started && received.desync.nonce == versus->peer_nonce) { receive_versus_desync_report(versus, &received.desync.confirmed); }
+            continue;
+        }
+        if (size != sizeof(packet) || packet.magic != VERSUS_MAGIC) { continue; }
+        if (!versus->started)
+        {
+            // the larger nonce is player 0; on the off chance they're equal, both sides try again
+            if (packet.nonce == versus->nonce)
+            {
+                versus->nonce = (u32)(get_monotonic_nanoseconds() * 2654435761u);
+                continue;
+            }
+            versus->peer_nonce = packet.nonce;
+            versus->local = versus->nonce > versus->peer_nonce ? 0 : 1;
+            versus->started = true;
+            versus->next_tick_nanoseconds = get_monotonic_nanoseconds();
+            versus->simulation.seed = (s32)MAX(versus->nonce, versus->peer_nonce);
+            start_versus_match(&versus->simulation);
+        }
+        else if (packet.nonce != versus->peer_nonce) { continue; }
+
+        auto now = get_versus_microseconds();
+        auto stats = &versus->stats;
+        if (stats->packets_received == 0) { stats->first_sequence = stats->last_sequence = packet.sequence; }
+        stats->packets_received++;
+        if ((s32)(packet.sequence - stats->last_sequence) >= 0)
+        {
+            stats->last_sequence = packet.sequence;
+            versus->has_echo = true;
+            versus->echo_time = packet.send_time;
+            versus->echo_received = now;
+        }
+        if (packet.echo_hold != VERSUS_NO_ECHO)
+        {
+            auto round_trip = now - packet.echo_time - packet.echo_hold;
+            if (round_trip < VERSUS_MAX_ROUND_TRIP_US) { add_round_trip_sample(stats, round_trip); }
+        }
+
+        if ((s32)(packet.acknowledged_tick - versus->acknowledged) > 0) { versus->acknowledged = packet.acknowledged_tick; }
+        auto remote = 1 - versus->local;
+        for (u32 i = 0; i < MIN(packet.input_count, VERSUS_INPUT_HISTORY); i++)
+        {
+            auto tick = packet.first_tick + i;
+            if (tick != versus->known) { continue; }
+            assert((s32)(tick - versus->tick) < VERSUS_INPUT_BUFFER / 2);
+            // ticks that already ran were predicted as no presses
+            if ((s32)(tick - versus->tick) < 0 && packet.inputs[i] != 0 && !versus->mispredicted)
+            {
+                versus->mispredicted = true;
+                versus->rollback_tick = tick;
+            }
+            versus->inputs[remote][tick % VERSUS_INPUT_BUFFER] = packet.inputs[i];
+            versus->known++;
+        }
+        receive_versus_checksum(versus, packet.checksum_tick, packet.checksum);
+    }
+}
+
+void send_versus_datagram(Versus* versus, void* data, u64 size)
+{
+    if (versus->drop_percent != 0 && get_random_unit_float(&versus->drop_random) * 100 < versus->drop_percent)
+    {
+        versus->stats.packets_dropped++;
+        return;
+    }
+    if (platform_send_udp(versus->socket, versus->peer_address, versus->peer_port, data, size)) { versus->stats.packets_sent++; }
+}
+
+void send_versus_packet(Versus* versus)
+{
+    VersusPacket packet;
+    set_memory(0, sizeof(packet), &packet);
+    packet.magic = VERSUS_MAGIC;
+    packet.nonce = versus->nonce;
+    packet.sequence = versus->sequence++;
+    packet.acknowledged_tick = versus->known;
+    if (versus->started)
+    {
+        auto oldest = versus->scheduled > VERSUS_INPUT_HISTORY ? versus->scheduled - VERSUS_INPUT_HISTORY : 0;
+        packet.first_tick = MAX(versus->acknowledged, oldest);
+        packet.input_count = versus->scheduled - packet.first_tick;
+        for (u32 i = 0; i < packet.input_count; i++)
+        { packet.inputs[i] = versus->inputs[versus->local][(packet.first_tick + i) % VERSUS_INPUT_BUFFER]; }
+    }
+    packet.checksum_tick = VERSUS_NO_CHECKSUM;
+    if (versus->confirmed != 0)
+    {
+        packet.checksum_tick = versus->confirmed - 1;
+        packet.checksum = versus->confirmed_ticks[packet.checksum_tick % VERSUS_CHECKSUM_HISTORY].checksum;
+    }
+    auto now = get_versus_microseconds();
+    packet.send_time = now;
+    packet.echo_time = versus->echo_time;
+    packet.echo_hold = versus->has_echo ? now - versus->echo_received : VERSUS_NO_ECHO;
+    send_versus_datagram(versus, &packet, sizeof(packet));
+
+    if (versus->desynced)
+    {
+        VersusDesyncPacket desync;
+        set_memory(0, sizeof(desync), &desync);
+        desync.magic = VERSUS_DESYNC_MAGIC;
+        desync.nonce = versus->nonce;
+        desync.confirmed = versus->confirmed_ticks[versus->desync_tick % VERSUS_CHECKSUM_HISTORY];
+        send_versus_datagram(versus, &desync, sizeof(desync));
+    }
+}
+
+// enough delay to cover the one way latency and two jitters, plus a tick of slack; rollback covers up to max_rollback
+// ticks of that instead
+void tune_versus_input_delay(Versus* versus)
+{
+    auto now = get_monotonic_nanoseconds();
+    if (!versus->automatic_delay || versus->stats.round_trip_samples == 0 || now - versus->delay_updated < VERSUS_DELAY_UPDATE_NANOSECONDS)
+    { return; }
+    versus->delay_updated = now;
+    auto milliseconds = versus->stats.round_trip_ms / 2 + 2 * versus->stats.jitter_ms;
+    auto delay = (int)(milliseconds / VERSUS_TICK_MS) + 2 - versus->max_rollback;
+    versus->input_delay = MIN(MAX(delay, 1), VERSUS_MAX_INPUT_DELAY);
+}
+
+void simulate_versus_tick(VersusSimulation* simulation, u16* inputs)
+{
+    if (simulation->restart_countdown > 0)
+    {
+        simulation->restart_countdown--;
+        if (simulation->restart_countdown == 0)
+        {
+            simulation->match++;
+            start_versus_match(simulation);
+        }
+        return;
+    }
+
+    for (auto i = 0; i < 2; i++)
+    {
+        auto player = &simulation->players[i];
+        auto locked = player->state.shapes_locked;
+        process_input(VERSUS_TICK_MS, unpack_versus_input(inputs[i]), &player->state);
+        if (player->state.shapes_locked != locked && player->incoming_garbage != 0 && player->state.mode == GameModePlaying)
+        {
+            add_garbage_rows(player->incoming_garbage, get_random_number_in_range(0, BOARD_WIDTH, &simulation->garbage_random), &player->state);
+            player->incoming_garbage = 0;
+        }
+    }
+    for (auto i = 0; i < 2; i++)
+    {
+        auto player = &simulation->players[i];
+        auto rows = player->state.score - player->scored;
+        player->scored = player->state.score;
+        simulation->players[1 - i].incoming_garbage += rows;
+        simulation->garbage_rows += rows;
+    }
+
+    auto lost0 = simulation->players[0].state.mode == GameModeLost;
+    auto lost1 = simulation->players[1].state.mode == GameModeLost;
+    if (lost0 || lost1)
+    {
+        simulation->last_winner = lost0 && lost1 ? -1 : (lost0 ? 1 : 0);
+        if (simulation->last_winner != -1) { simulation->players[simulation->last_winner].wins++; }
+        simulation->restart_countdown = VERSUS_RESTART_TICKS;
+    }
+}
+
+// runs versus->tick, predicting the other player's input if it isn't known yet
+void advance_versus(Versus* versus)
+{
+    auto slot = versus->tick % VERSUS_INPUT_BUFFER;
+    if ((s32)(versus->tick - versus->known) >= 0) { versus->inputs[1 - versus->local][slot] = 0; }
+    if (versus->max_rollback != 0) { versus->snapshots[versus->tick % countof(versus->snapshots)] = versus->simulation; }
+    u16 inputs[] = { versus->inputs[0][slot], versus->inputs[1][slot] };
+    simulate_versus_tick(&versus->simulation, inputs);
+    versus->tick++;
+}
+
+// back to before the first mispredicted tick, then forward again to the same tick with the inputs known now
+void roll_back_versus(Versus* versus)
+{
+    if (!versus->mispredicted) { return; }
+    versus->mispredicted = false;
+    auto depth = versus->tick - versus->rollback_tick;
+    assert(depth <= (u32)versus->max_rollback);
+    versus->stats.rollbacks++;
+    versus->stats.rolled_back_ticks += depth;
+    versus->stats.max_rollback_depth = MAX(versus->stats.max_rollback_depth, depth);
+    auto tick = versus->tick;
+    versus->tick = versus->rollback_tick;
+    versus->simulation = versus->snapshots[versus->tick % countof(versus->snapshots)];
+    while (versus->tick != tick) { advance_versus(versus); }
+}
+
+// ticks the window owes the game since the last frame
+int get_due_versus_ticks(Versus* versus)
+{
+    if (!versus->started) { return 0; }
+    auto now = get_monotonic_nanoseconds();
+    if (now < versus->next_tick_nanoseconds) { return 0; }
+    auto due = (now - versus->next_tick_nanoseconds) / (VERSUS_TICK_MS * 1000000ull) + 1;
+    return (int)MIN(due, (u64)VERSUS_MAX_CATCH_UP_TICKS);
+}
+
+void push_versus_simulation(VersusSimulation* simulation, String* text)
+{
+    push("match ", text);
+    uint_to_string(simulation->match, text);
+    push(", restart countdown ", text);
+    int_to_string(simulation->restart_countdown, text);
+    push(", last winner ", text);
+    int_to_string(simulation->last_winner, text);
+    push(", garbage random ", text);
+    int_to_string(simulation->garbage_random.previous, text);
+    push(", garbage rows ", text);
+    uint_to_string(simulation->garbage_rows, text);
+    push('\n', text);
+    for (auto i = 0; i < 2; i++)
+    {
+        auto player = &simulation->players[i];
+        auto state = &player->state;
+        char* values[] = { "checksum ", ", mode ", ", score ", ", shapes spawned ", ", locked ", ", shape x ", ", y ", ", quick fall ",
+            ", fall timer ", ", color timer ", ", random ", ", mirrors ", ", fills ", ", inverts ", ", bombs ", ", incoming garbage ", ", wins " };
+        s64 numbers[] = { 0, state->mode, state->score, state->shapes_spawned, state->shapes_locked, state->falling_shape.x,
+            state->falling_shape.y, state->quick_fall_mode, state->timers.shape_fall, state->timers.board_color, state->random.previous,
+            state->power_ups.mirror, state->power_ups.fill_cell, state->power_ups.invert_board, state->power_ups.bomb,
+            player->incoming_garbage, player->wins };
+        static_assert(countof(values) == countof(numbers), "a value without a name");
+        push("player ", text);
+        int_to_string(i, text);
+        push(": ", text);
+        for (auto j = 0; j < countof(values); j++)
+        {
+            push(values[j], text);
+            if (j == 0) { uint_to_string(hash_game_state(state), text); }
+            else { int_to_string(numbers[j], text); }
+        }
+        push('\n', text);
+        // # for the board, @ for the falling shape
+        for (auto y = 0; y < BOARD_HEIGHT; y++)
+        {
+            for (auto x = 0; x < BOARD_WIDTH; x++)
+            {
+                auto falling = get_cell(x - state->falling_shape.x, y - state->falling_shape.y, state->falling_shape.cell_map);
+                push(falling ? '@' : (get_cell(x, y, state->board) ? '#' : '.'), text);
+            }
+            push('\n', text);
+        }
+    }
+}
+
+void push_versus_confirmed_tick(char* title, VersusConfirmedTick* confirmed, String* text)
+{
+    push(title, text);
+    push(": checksum ", text);
+    uint_to_string(confirmed->checksum, text);
+    push(", inputs ", text);
+    uint_to_string(confirmed->inputs[0], text);
+    push(" and ", text);
+    uint_to_string(confirmed->inputs[1], text);
+    push(" (bits of pack_versus_input)\n", text);
+    push_versus_simulation(&confirmed->simulation, text);
+}
+
+// both sides' state after the tick the checksums first differed on, and the inputs that led there
+void write_versus_desync_dump(Versus* versus)
+{
+    auto data = (char*)SDL_malloc(MAX_VERSUS_DUMP_BYTES);
+    if (data == NULL) { panic("Out of memory for the versus desync dump"); }
+    auto text = make_string(0, data);
+    push("desync after tick ", &text);
+    uint_to_string(versus->desync_tick, &text);
+    push(", this side is player ", &text);
+    int_to_string(versus->local, &text);
+    push("\n\n", &text);
+    push_versus_confirmed_tick("this side", &versus->confirmed_ticks[versus->desync_tick % VERSUS_CHECKSUM_HISTORY], &text);
+    push('\n', &text);
+    if (versus->has_peer_report) { push_versus_confirmed_tick("other side", &versus->peer_report, &text); }
+    else { push("the other side's state didn't arrive\n", &text); }
+    assert(text.size <= MAX_VERSUS_DUMP_BYTES);
+
+    char path_data[32];
+    auto path = make_string(0, path_data);
+    push("versus_desync_", &path);
+    uint_to_string(versus->local_port, &path);
+    push(".txt", &path);
+    push('\0', &path);
+    // the log keeps message pointers, so the port stands in for the path
+    if (platform_write_file(path.data, text.data, text.size)) { log_error("Wrote versus_desync_<port>.txt for port ", (u64)versus->local_port); }
+    else { log_error("Failed to write versus_desync_<port>.txt for port ", (u64)versus->local_port); }
+    SDL_free(data);
+    versus->dumped = true;
+}
+
+// one frame: takes in the other side's inputs, runs up to max_ticks ticks and sends the local inputs
+void update_versus(Versus* versus, GameInput input, int max_ticks)
+{
+    receive_versus_packets(versus);
+    versus->pending_input |= pack_versus_input(input);
+    if (versus->desynced && !versus->dumped
+        && (versus->has_peer_report || get_monotonic_nanoseconds() - versus->desync_nanoseconds > VERSUS_DESYNC_REPORT_NANOSECONDS))
+    { write_versus_desync_dump(versus); }
+    if (versus->started && !versus->desynced)
+    {
+        tune_versus_input_delay(versus);
+        roll_back_versus(versus);
+        confirm_versus_ticks(versus);
+        for (auto i = 0; i < max_ticks; i++)
+        {
+            // a smaller delay leaves the presses pending until the ticks catch up with the ones already scheduled
+            while (versus->scheduled <= versus->tick + versus->input_delay)
+            {
+                versus->inputs[versus->local][versus->scheduled % VERSUS_INPUT_BUFFER] = versus->pending_input;
+                versus->pending_input = 0;
+                versus->scheduled++;
+            }
+            if ((s32)(versus->tick - versus->known) >= versus->max_rollback)
+            {
+                // what's left of the frame waits, so this side falls back in step with the other one
+                versus->stats.stalled_ticks += max_ticks - i;
+                versus->next_tick_nanoseconds = get_monotonic_nanoseconds();
+                break;
+            }
+            advance_versus(versus);
+            confirm_versus_ticks(versus);
+            versus->next_tick_nanoseconds += VERSUS_TICK_MS * 1000000ull;
+        }
+    }
+    send_versus_packet(versus);
+}
+
+// the local game as the window draws it; once a match is over the result replaces the GAME OVER screen
+GameState get_versus_display_state(Versus* versus)
+{
+    auto result = versus->simulation.players[versus->local].state;
+    if (result.mode == GameModeLost) { result.mode = GameModePlaying; }
+    return result;
+}
+
+struct VersusHud
+{
+    bool initialized;
+    NumericLabel round_trip;
+    NumericLabel jitter;
+    NumericLabel loss;
+    NumericLabel input_delay;
+    NumericLabel stalls;
+    NumericLabel rolled_back;
+    NumericLabel incoming_garbage;
+    NumericLabel wins;
+    NumericLabel losses;
+};
+
+VersusHud g_versus_hud;
+
+void draw_versus_hud(Versus* versus, int y, Bitmap bitmap)
+{
+    if (!g_versus_hud.initialized)
+    {
+        auto font = g_resources.font16;
+        g_versus_hud.round_trip = make_numeric_label(font, "Ping ms: ");
+        g_versus_hud.jitter = make_numeric_label(font, "Jitter ms: ");
+        g_versus_hud.loss = make_numeric_label(font, "Loss %: ");
+        g_versus_hud.input_delay = make_numeric_label(font, "Input delay: ");
+        g_versus_hud.stalls = make_numeric_label(font, "Stalled ticks: ");
+        g_versus_hud.rolled_back = make_numeric_label(font, "Rolled back ticks: ");
+        g_versus_hud.incoming_garbage = make_numeric_label(font, "Garbage: ");
+        g_versus_hud.wins = make_numeric_label(font, "Wins: ");
+        g_versus_hud.losses = make_numeric_label(font, "Losses: ");
+        g_versus_hud.initialized = true;
+    }
+    auto local = &versus->simulation.players[versus->local];
+    auto remote = &versus->simulation.players[1 - versus->local];
+    auto digits = &g_hud.digits16;
+    TextMask texts[] =
+    {
+        get_numeric_label_text(&g_versus_hud.round_trip, versus->stats.round_trip_ms, digits),
+        get_numeric_label_text(&g_versus_hud.jitter, versus->stats.jitter_ms, digits),
+        get_numeric_label_text(&g_versus_hud.loss, get_versus_packet_loss(&versus->stats), digits),
+        get_numeric_label_text(&g_versus_hud.input_delay, (s64)versus->input_delay, digits),
+        get_numeric_label_text(&g_versus_hud.stalls, (s64)versus->stats.stalled_ticks, digits),
+        get_numeric_label_text(&g_versus_hud.rolled_back, (s64)versus->stats.rolled_back_ticks, digits),
+        get_numeric_label_text(&g_versus_hud.incoming_garbage, (s64)local->incoming_garbage, digits),
+        get_numeric_label_text(&g_versus_hud.wins, (s64)local->wins, digits),
+        get_numeric_label_text(&g_versus_hud.losses, (s64)remote->wins, digits),
+    };
+    for (auto i = 0; i < countof(texts); i++)
+    {
+        draw_text_mask(0, y, RED, texts[i], bitmap);
+        y += texts[i].height;
+    }
+
+    // the opponent's board, small, in the bottom right corner when the margin beside the main board has room
+    auto cell_size = MAX(2, (int)bitmap.height / 60);
+    auto width = cell_size * BOARD_WIDTH;
+    auto height = cell_size * BOARD_HEIGHT;
+    if (width + 20 <= (int)bitmap.width / 5 && height + 20 <= (int)bitmap.height)
+    {
+        auto x0 = (int)bitmap.width - width - 10;
+        auto y0 = (int)bitmap.height - height - 10;
+        draw_rectangle(x0, y0, width, height, LIGHT_PURPLE, bitmap);
+        auto state = &remote->state;
+        for (auto y = 0; y < BOARD_HEIGHT; y++)
+        {
+            for (auto x = 0; x < BOARD_WIDTH; x++)
+            {
+                auto shape_x = x - state->falling_shape.x;
+                auto shape_y = y - state->falling_shape.y;
+                auto falling = state->mode == GameModePlaying
+                    && shape_x >= 0 && shape_x < state->falling_shape.cell_map.width
+                    && shape_y >= 0 && shape_y < state->falling_shape.cell_map.height
+                    && get_cell(shape_x, shape_y, state->falling_shape.cell_map);
+                auto color = falling ? 0x00ff00 : (get_cell(x, y, state->board) ? state->board_color : BLACK);
+                draw_rectangle(x0 + x * cell_size + 1, y0 + y * cell_size + 1, cell_size - 1, cell_size - 1, color, bitmap);
+            }
+        }
+    }
+
+    char* message = NULL;
+    if (!versus->started) { message = "WAITING FOR OPPONENT"; }
+    else if (versus->desynced) { message = "OUT OF STEP"; }
+    else if (versus->simulation.restart_countdown > 0)
+    {
+        if (versus->simulation.last_winner == -1) { message = "DRAW"; }
+        else { message = versus->simulation.last_winner == versus->local ? (char*)"YOU WIN" : (char*)"YOU LOSE"; }
+    }
+    if (message != NULL)
+    {
+        auto surface = text_to_surface(RED, g_resources.font32, message);
+        draw_text_with_shade((bitmap.width - surface->w) / 2, (bitmap.height - surface->h) / 2, RED, 2, BLACK, g_resources.font32, message, bitmap);
+        SDL_FreeSurface(surface);
+    }
+}
+
+// arguments after --versus: <local port> <peer address> <peer port> [input delay] [rollback ticks]
+Versus* start_versus_from_arguments(int argument_count, char** arguments)
+{
+    if (argument_count < 3 || argument_count > 5) { return NULL; }
+    auto local_port = string_to_int(make_string(c_string_length(arguments[0]), arguments[0]));
+    auto peer_port = string_to_int(make_string(c_string_length(arguments[2]), arguments[2]));
+    u32 peer_address;
+    if (!local_port.success || local_port.value <= 0 || local_port.value > 65535
+        || !peer_port.success || peer_port.value <= 0 || peer_port.value > 65535
+        || !parse_ipv4_address(arguments[1], &peer_address))
+    { return NULL; }
+    auto input_delay = 0;
+    if (argument_count >= 4)
+    {
+        auto parsed = string_to_int(make_string(c_string_length(arguments[3]), arguments[3]));
+        if (!parsed.success || parsed.value < 0 || parsed.value > VERSUS_MAX_INPUT_DELAY) { return NULL; }
+        input_delay = parsed.value;
+    }
+    auto max_rollback = 0;
+    if (argument_count == 5)
+    {
+        auto parsed = string_to_int(make_string(c_string_length(arguments[4]), arguments[4]));
+        if (!parsed.success || parsed.value < 0 || parsed.value > VERSUS_MAX_ROLLBACK_TICKS) { return NULL; }
+        max_rollback = parsed.value;
+    }
+    return start_versus((u16)local_port.value, peer_address, (u16)peer_port.value, input_delay, max_rollback);
+}
+
+bool versus_games_match(GameState* left, GameState* right)
+{
+    return left->mode == right->mode && left->score == right->score && left->board_hash == right->board_hash
+        && left->shapes_locked == right->shapes_locked && left->falling_shape.x == right->falling_shape.x
+        && left->falling_shape.y == right->falling_shape.y
+        && cell_maps_equal(left->falling_shape.cell_map, right->falling_shape.cell_map)
+        && left->random.previous == right->random.previous
+        && memory_equals(sizeof(left->power_ups), &left->power_ups, &right->power_ups);
+}
+
+// two bot driven instances in one process talking over loopback; checks they simulated the same games
+int run_versus_benchmark(int ticks, int drop_percent, int input_delay, int max_rollback, int port)
+{
+    initialize_shape_cell_maps();
+    Versus* sides[2];
+    sides[0] = start_versus((u16)port, VERSUS_LOOPBACK_ADDRESS, (u16)(port + 1), input_delay, max_rollback);
+    sides[1] = start_versus((u16)(port + 1), VERSUS_LOOPBACK_ADDRESS, (u16)port, input_delay, max_rollback);
+    if (sides[0] == NULL || sides[1] == NULL) { return 1; }
+    auto bots = (Bot*)SDL_calloc(2, sizeof(Bot));
+    if (bots == NULL) { panic("Out of memory for versus bots"); }
+    u32 last_ticks[2] = {};
+    for (auto i = 0; i < 2; i++)
+    {
+        sides[i]->drop_percent = drop_percent;
+        toggle_bot(&bots[i]);
+    }
+
+    auto start = get_monotonic_nanoseconds();
+    auto last_progress = start;
+    auto timed_out = false;
+    // past the last tick the sides keep exchanging inputs until neither is left with a prediction
+    while (sides[0]->tick < ticks || sides[1]->tick < ticks || sides[0]->known < sides[0]->tick || sides[1]->known < sides[1]->tick)
+    {
+        for (auto i = 0; i < 2; i++)
+        {
+            auto side = sides[i];
+            // the bot plans one action per tick, so it only plays when this update gives the local player a new tick
+            GameInput input;
+            set_memory(0, sizeof(input), &input);
+            if (side->started && side->scheduled <= side->tick + side->input_delay)
+            { input = get_bot_input(&bots[i], &side->simulation.players[side->local].state); }
+            if (side->tick != last_ticks[i])
+            {
+                last_ticks[i] = side->tick;
+                last_progress = get_monotonic_nanoseconds();
+            }
+            update_versus(side, input, side->tick < ticks ? 1 : 0);
+        }
+        if (get_monotonic_nanoseconds() - last_progress > VERSUS_BENCH_TIMEOUT_NANOSECONDS)
+        {
+            timed_out = true;
+            break;
+        }
+        // after a desync nothing runs, so the run is over once the dumps are written
+        if ((sides[0]->desynced || sides[1]->desynced)
+            && (!sides[0]->desynced || sides[0]->dumped) && (!sides[1]->desynced || sides[1]->dumped))
+        { break; }
+    }
+    auto nanoseconds = get_monotonic_nanoseconds() - start;
+
+    auto first = &sides[0]->simulation;
+    auto second = &sides[1]->simulation;
+    auto in_step = sides[0]->tick == sides[1]->tick && first->match == second->match && sides[0]->local != sides[1]->local
+        && !sides[0]->desynced && !sides[1]->desynced;
+    for (auto i = 0; i < 2; i++)
+    {
+        in_step &= versus_games_match(&first->players[i].state, &second->players[i].state);
+        in_step &= first->players[i].wins == second->players[i].wins;
+    }
+    print(timed_out ? (char*)"timed out at tick " : (char*)"ticks ");
+    print((u64)MIN(sides[0]->tick, sides[1]->tick));
+    print(", ");
+    print(get_nodes_per_second(MIN(sides[0]->tick, sides[1]->tick), nanoseconds));
+    print(" ticks/sec, matches finished ");
+    print((u64)first->match);
+    print(", wins ");
+    print((u64)first->players[0].wins);
+    print(" to ");
+    print((u64)first->players[1].wins);
+    print(", garbage rows ");
+    print(first->garbage_rows);
+    print("\n");
+    for (auto i = 0; i < 2; i++)
+    {
+        auto stats = &sides[i]->stats;
+        print("side ");
+        print((s64)i);
+        print(": ping ms ");
+        print(stats->round_trip_ms);
+        print(" (");
+        print(stats->min_round_trip_ms);
+        print(" to ");
+        print(stats->max_round_trip_ms);
+        print("), jitter ms ");
+        print(stats->jitter_ms);
+        print(", packets sent ");
+        print(stats->packets_sent);
+        print(", dropped ");
+        print(stats->packets_dropped);
+        print(", received ");
+        print(stats->packets_received);
+        print(", loss % ");
+        print(get_versus_packet_loss(stats));
+        print(", stalled ticks ");
+        print(stats->stalled_ticks);
+        print(", rollbacks ");
+        print(stats->rollbacks);
+        print(" (");
+        print(stats->rolled_back_ticks);
+        print(" ticks, deepest ");
+        print((u64)stats->max_rollback_depth);
+        print("), checksums compared ");
+        print(stats->checksums_compared);
+        print(", input delay ");
+        print((s64)sides[i]->input_delay);
+        print("\n");
+    }
+    print(in_step ? (char*)"both sides simulated the same games\n" : (char*)"the sides went out of step\n");
+
+    SDL_free(bots);
+    free_versus(sides[0]);
+    free_versus(sides[1]);
+    return in_step && !timed_out ? 0 : 1;
+}
+
+// Two bots in one simulation, no network. Every frame runs a tick and then forces a rollback of depth ticks: restores
+// the snapshot from before them and simulates them again, which is the worst a misprediction costs. The state after is
+// checked against the one before, so this also catches a tick that depends on something the snapshot doesn't hold.
+int run_rollback_benchmark(int ticks)
+{
+    initialize_shape_cell_maps();
+    auto simulation = (VersusSimulation*)SDL_calloc(2 + VERSUS_MAX_ROLLBACK_TICKS + 1, sizeof(VersusSimulation));
+    auto bots = (Bot*)SDL_calloc(2, sizeof(Bot));
+    if (simulation == NULL || bots == NULL) { panic("Out of memory for the rollback benchmark"); }
+    auto expected = simulation + 1;
+    auto snapshots = simulation + 2;
+    auto ring = VERSUS_MAX_ROLLBACK_TICKS + 1;
+
+    // a snapshot is one struct copy both ways
+    auto copies = 100000;
+    auto start = get_monotonic_nanoseconds();
+    for (auto i = 0; i < copies; i++)
+    {
+        simulation->match = i;
+        snapshots[i % ring] = *simulation;
+    }
+    auto save_nanoseconds = (get_monotonic_nanoseconds() - start) / (float)copies;
+    start = get_monotonic_nanoseconds();
+    for (auto i = 0; i < copies; i++) { *simulation = snapshots[i % ring]; }
+    auto restore_nanoseconds = (get_monotonic_nanoseconds() - start) / (float)copies;
+    // the checksum every confirmed tick gets in a networked game
+    u64 checksums = 0;
+    start = get_monotonic_nanoseconds();
+    for (auto i = 0; i < copies; i++) { checksums ^= hash_versus_simulation(&snapshots[i % ring]); }
+    auto checksum_nanoseconds = (get_monotonic_nanoseconds() - start) / (float)copies;
+    print("GameState ");
+    print((u64)sizeof(GameState));
+    print(" bytes, snapshot ");
+    print((u64)sizeof(VersusSimulation));
+    print(" bytes, save ns ");
+    print(save_nanoseconds);
+    print(", restore ns ");
+    print(restore_nanoseconds);
+    print(", checksum ns ");
+    print(checksum_nanoseconds);
+    print("\n");
+    // keeps the checksums from being optimized away
+    if (checksums == 1) { print("unreachable"); }
+
+    auto failures = 0;
+    int depths[] = { 1, 2, 4, 8, VERSUS_MAX_ROLLBACK_TICKS };
+    for (auto depth_index = 0; depth_index < countof(depths); depth_index++)
+    {
+        auto depth = depths[depth_index];
+        set_memory(0, sizeof(*simulation), simulation);
+        simulation->last_winner = -1;
+        start_versus_match(simulation);
+        set_memory(0, 2 * sizeof(Bot), bots);
+        toggle_bot(&bots[0]);
+        toggle_bot(&bots[1]);
+        u16 inputs[VERSUS_MAX_ROLLBACK_TICKS + 1][2];
+        u64 total_nanoseconds = 0;
+        u64 worst_nanoseconds = 0;
+        auto in_step = true;
+        for (auto tick = 0; tick < ticks; tick++)
+        {
+            // the bots plan outside the timed part, it's the simulation that's measured
+            for (auto i = 0; i < 2; i++) { inputs[tick % ring][i] = pack_versus_input(get_bot_input(&bots[i], &simulation->players[i].state)); }
+
+            auto frame_start = get_monotonic_nanoseconds();
+            snapshots[tick % ring] = *simulation;
+            simulate_versus_tick(simulation, inputs[tick % ring]);
+            auto first = MAX(tick + 1 - depth, 0);
+            *expected = *simulation;
+            *simulation = snapshots[first % ring];
+            for (auto resimulated = first; resimulated <= tick; resimulated++)
+            {
+                snapshots[resimulated % ring] = *simulation;
+                simulate_versus_tick(simulation, inputs[resimulated % ring]);
+            }
+            auto nanoseconds = get_monotonic_nanoseconds() - frame_start;
+
+            total_nanoseconds += nanoseconds;
+            worst_nanoseconds = MAX(worst_nanoseconds, nanoseconds);
+            for (auto i = 0; i < 2; i++)
+            {
+                in_step &= versus_games_match(&simulation->players[i].state, &expected->players[i].state);
+                in_step &= simulation->players[i].wins == expected->players[i].wins;
+            }
+        }
+        if (!in_step) { failures++; }
+        print("rollback ");
+        print((s64)depth);
+        print(" ticks: frame ns ");
+        print((float)total_nanoseconds / ticks);
+        print(" average, ");
+        print(worst_nanoseconds);
+        print(" worst, ");
+        print((float)total_nanoseconds / ticks / (depth + 1));
+        print(" per tick simulated, matches ");
+        print((u64)simulation->match);
+        print(in_step ? (char*)"\n" : (char*)", the simulated again state differs\n");
+    }
+
+    SDL_free(bots);
+    SDL_free(simulation);
+    return failures == 0 ? 0 : 1;
+}